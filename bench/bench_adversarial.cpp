@@ -0,0 +1,308 @@
+// Structured and low-entropy keys: insert / find-hit / find-miss throughput of emhash5-8 and
+// emilib1-4 under every built-in integer hash mode, flagging throughput cliffs.
+//
+// Build:
+//   g++ -std=c++17 -O2 -march=native -Iinclude -Ibench bench/bench_adversarial.cpp -o advbench
+// Run:
+//   ./advbench [keys=500000] [map filter] [key set filter] [hash filter] [adversarial.csv] [budget_s=2]
+//
+// Key sets: random (the baseline), sequential ids, strided multiples of 2^8/2^12/2^16/2^20,
+// pointer-like (16-byte aligned, 48-byte size class), nanosecond timestamps at 1 us spacing,
+// and strings sharing a 48 byte prefix (against random strings of the same length). Misses
+// continue each pattern past the inserted keys. The random sets always run: they are the
+// baselines.
+//
+// Hash modes are hasher functors with the mixers the maps compile in: std (std::hash, the
+// identity for integers on libstdc++/libc++), int1/int2/int3 (EMH_INT_HASH=1/2/3) and wyhash
+// (EMH_WYHASH64 / EMH_WY_HASH), so all eight maps, including the emilib ones that have no
+// EMH_INT_HASH switch, run each mode from one binary. Build with the default config: with
+// EMH_INT_HASH defined the emhash maps ignore the hasher argument.
+//
+// A cell whose operation runs past budget_s seconds is stopped and reported as "timeout"
+// (primary clustering or a collision chain gone quadratic). Any operation below a quarter of
+// the same map and hash on random keys is marked "CLIFF". With EMH_JSON=<path> each finished
+// operation is also written as JSON for bench_compare (map "emhash8/int1", key = key set).
+
+#include "bench_result.h"
+
+#include "emhash/hash_table5.hpp"
+#include "emhash/hash_table6.hpp"
+#include "emhash/hash_table7.hpp"
+#include "emhash/hash_table8.hpp"
+#include "emilib/emihmap1.hpp"
+#include "emilib/emihmap2.hpp"
+#include "emilib/emihmap3.hpp"
+#include "emilib/emihmap4.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <map>
+#include <random>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+namespace {
+
+// ---- hash modes -----------------------------------------------------------
+
+constexpr uint64_t KC = UINT64_C(11400714819323198485);
+
+struct Int1Hash { // EMH_INT_HASH == 1
+    size_t operator()(uint64_t key) const {
+#if defined(__SIZEOF_INT128__)
+        __uint128_t r = key;
+        r *= KC;
+        return static_cast<size_t>(static_cast<uint64_t>(r >> 64) + static_cast<uint64_t>(r));
+#else
+        const uint64_t r = key * UINT64_C(0xca4bcaa75ec3f625);
+        return static_cast<size_t>((r >> 32) + r);
+#endif
+    }
+};
+
+struct Int2Hash { // EMH_INT_HASH == 2, MurmurHash3 finalizer
+    size_t operator()(uint64_t h) const {
+        h ^= h >> 33;
+        h *= UINT64_C(0xff51afd7ed558ccd);
+        h ^= h >> 33;
+        h *= UINT64_C(0xc4ceb9fe1a85ec53);
+        h ^= h >> 33;
+        return static_cast<size_t>(h);
+    }
+};
+
+struct Int3Hash { // EMH_INT_HASH == 3
+    size_t operator()(uint64_t key) const {
+        const auto ror = (key >> 32) | (key << 32);
+        return static_cast<size_t>(key * UINT64_C(0xA24BAED4963EE407) + ror * UINT64_C(0x9FB21C651E98DF25));
+    }
+};
+
+struct WyHash {
+    size_t operator()(uint64_t key) const { return static_cast<size_t>(emh_wyhash64(key, KC)); }
+    size_t operator()(const std::string& key) const { return static_cast<size_t>(wyhash(key.data(), key.size(), 0)); }
+};
+
+// ---- key sets -------------------------------------------------------------
+
+// First half inserted, second half probed as misses.
+template <typename K> struct KeySet {
+    std::string name;
+    std::vector<K> keys;
+};
+
+std::vector<KeySet<uint64_t>> int_key_sets(size_t num) {
+    std::vector<KeySet<uint64_t>> sets;
+    const auto make = [&](const char* name, const std::function<uint64_t(uint64_t)>& gen) {
+        KeySet<uint64_t> set{name, std::vector<uint64_t>(2 * num)};
+        for (size_t i = 0; i < 2 * num; i++)
+            set.keys[i] = gen(i);
+        sets.push_back(std::move(set));
+    };
+
+    std::mt19937_64 rng(20260606);
+    make("random", [&](uint64_t) { return rng(); });
+    make("sequential", [](uint64_t i) { return i + 1; });
+    for (const int shift : {8, 12, 16, 20}) {
+        const std::string name = "stride2^" + std::to_string(shift);
+        make(name.c_str(), [shift](uint64_t i) { return (i + 1) << shift; });
+    }
+    make("pointer", [](uint64_t i) { return (UINT64_C(0x7f3a5c000000) + i * 48) & ~UINT64_C(15); });
+    make("timestamp_ns", [](uint64_t i) { return UINT64_C(1780000000000000000) + i * 1000; });
+    return sets;
+}
+
+// Random strings of the same length as the prefixed ones (the string baseline), then keys
+// that differ only after a shared 48 byte prefix.
+std::vector<KeySet<std::string>> string_key_sets(size_t num) {
+    const std::string prefix = "tenant:0042/region:eu-west-1/service:checkout/id:";
+    KeySet<std::string> random{"random_str", std::vector<std::string>(2 * num)};
+    KeySet<std::string> shared{"prefix48", std::vector<std::string>(2 * num)};
+    std::mt19937_64 rng(20260607);
+    for (size_t i = 0; i < 2 * num; i++) {
+        shared.keys[i] = prefix.substr(0, 48) + std::to_string(i);
+        auto& key = random.keys[i];
+        key.resize(shared.keys[i].size());
+        for (auto& c : key)
+            c = static_cast<char>('!' + rng() % 94);
+    }
+    return {random, shared};
+}
+
+// ---- timing ---------------------------------------------------------------
+
+struct Options {
+    const char* map_filter = nullptr;
+    const char* set_filter = nullptr;
+    const char* hash_filter = nullptr;
+    double budget = 2.0;
+    FILE* csv = nullptr;
+    BenchResults* results = nullptr;
+};
+
+struct Result {
+    double mops[3] = {0, 0, 0}; // insert, find_hit, find_miss; < 0: timeout
+};
+
+const char* const OPS[] = {"insert", "find_hit", "find_miss"};
+
+double now_s() {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+uint64_t g_sink = 0;
+
+// Runs body(i) for i in [first, last) in chunks, giving up past the budget. Mops/s or -1.
+template <typename Body> double timed(size_t first, size_t last, double budget, Body&& body) {
+    constexpr size_t CHUNK = 1024;
+    const auto start = now_s();
+    for (size_t i = first; i < last;) {
+        const auto end = std::min(last, i + CHUNK);
+        for (; i < end; i++)
+            body(i);
+        if (now_s() - start > budget)
+            return -1;
+    }
+    return static_cast<double>(last - first) / (now_s() - start) / 1e6;
+}
+
+template <typename Map, typename K> Result measure(const std::vector<K>& keys, double budget) {
+    Result result;
+    const auto num = keys.size() / 2;
+    Map map;
+    uint64_t sum = 0;
+    result.mops[0] = timed(0, num, budget, [&](size_t i) { (void)map.emplace(keys[i], i); });
+    if (result.mops[0] < 0) {
+        result.mops[1] = result.mops[2] = -1;
+        return result;
+    }
+    result.mops[1] = timed(0, num, budget, [&](size_t i) { sum += map.find(keys[i])->second; });
+    result.mops[2] = timed(num, 2 * num, budget, [&](size_t i) { sum += map.find(keys[i]) != map.end(); });
+    g_sink += sum + map.size();
+    return result;
+}
+
+// (map, hash, key type) -> random-key baseline
+std::map<std::string, Result> g_baseline;
+
+template <typename Map, typename K>
+void cell(const char* map_name, const char* hash_name, const KeySet<K>& set, const Options& opt) {
+    const bool baseline = set.name.compare(0, 6, "random") == 0;
+    if (opt.set_filter && !strstr(set.name.c_str(), opt.set_filter) && !baseline)
+        return;
+    const auto result = measure<Map>(set.keys, opt.budget);
+    const auto key = std::string(map_name) + "/" + hash_name + (std::is_same<K, std::string>::value ? "/str" : "");
+    if (baseline)
+        g_baseline[key] = result;
+    const auto base = g_baseline.find(key);
+
+    bool cliff = false;
+    printf("%-8s %-7s %-13s", map_name, hash_name, set.name.c_str());
+    for (int op = 0; op < 3; op++) {
+        const auto mops = result.mops[op];
+        if (mops < 0)
+            printf(" %9s", "timeout");
+        else
+            printf(" %9.2f", mops);
+        if (base != g_baseline.end() && (mops < 0 || mops < base->second.mops[op] / 4))
+            cliff = true;
+    }
+    printf("%s\n", cliff ? "  CLIFF" : "");
+    if (opt.csv) {
+        for (int op = 0; op < 3; op++)
+            fprintf(opt.csv, "%s,%s,%s,%s,%zu,%.3f,%d\n", map_name, hash_name, set.name.c_str(), OPS[op],
+                    set.keys.size() / 2, result.mops[op], cliff ? 1 : 0);
+        fflush(opt.csv);
+    }
+    for (int op = 0; op < 3; op++)
+        if (result.mops[op] > 0)
+            opt.results->add(std::string(map_name) + "/" + hash_name, OPS[op], set.keys.size() / 2, set.name,
+                             "uint64_t", 1e3 / result.mops[op]);
+}
+
+template <template <typename, typename, typename> class Map, typename Hash>
+void int_hash_mode(const char* map_name, const char* hash_name, const std::vector<KeySet<uint64_t>>& sets,
+                   const Options& opt) {
+    if (opt.hash_filter && !strstr(hash_name, opt.hash_filter))
+        return;
+    for (const auto& set : sets)
+        cell<Map<uint64_t, uint64_t, Hash>>(map_name, hash_name, set, opt);
+}
+
+template <template <typename, typename, typename> class Map>
+void run(const char* map_name, const std::vector<KeySet<uint64_t>>& sets,
+         const std::vector<KeySet<std::string>>& strings, const Options& opt) {
+    if (opt.map_filter && !strstr(map_name, opt.map_filter))
+        return;
+    int_hash_mode<Map, std::hash<uint64_t>>(map_name, "std", sets, opt);
+    int_hash_mode<Map, Int1Hash>(map_name, "int1", sets, opt);
+    int_hash_mode<Map, Int2Hash>(map_name, "int2", sets, opt);
+    int_hash_mode<Map, Int3Hash>(map_name, "int3", sets, opt);
+    int_hash_mode<Map, WyHash>(map_name, "wyhash", sets, opt);
+
+    for (const auto& set : strings) {
+        if (!opt.hash_filter || strstr("std", opt.hash_filter))
+            cell<Map<std::string, uint64_t, std::hash<std::string>>>(map_name, "std", set, opt);
+        if (!opt.hash_filter || strstr("wyhash", opt.hash_filter))
+            cell<Map<std::string, uint64_t, WyHash>>(map_name, "wyhash", set, opt);
+    }
+}
+
+template <typename K, typename V, typename H> using Map5 = emhash5::HashMap<K, V, H>;
+template <typename K, typename V, typename H> using Map6 = emhash6::HashMap<K, V, H>;
+template <typename K, typename V, typename H> using Map7 = emhash7::HashMap<K, V, H>;
+template <typename K, typename V, typename H> using Map8 = emhash8::HashMap<K, V, H>;
+template <typename K, typename V, typename H> using Emilib1 = emilib::HashMap<K, V, H>;
+template <typename K, typename V, typename H> using Emilib2 = emilib2::HashMap<K, V, H>;
+template <typename K, typename V, typename H> using Emilib3 = emilib3::HashMap<K, V, H>;
+template <typename K, typename V, typename H> using Emilib4 = emilib4::HashMap<K, V, H>;
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    const size_t num = argc > 1 ? strtoull(argv[1], nullptr, 10) : 500000;
+    Options opt;
+    opt.map_filter = argc > 2 && strcmp(argv[2], "all") ? argv[2] : nullptr;
+    opt.set_filter = argc > 3 && strcmp(argv[3], "all") ? argv[3] : nullptr;
+    opt.hash_filter = argc > 4 && strcmp(argv[4], "all") ? argv[4] : nullptr;
+    const char* csv_path = argc > 5 ? argv[5] : "adversarial.csv";
+    opt.budget = argc > 6 ? atof(argv[6]) : 2.0;
+    BenchResults results("advbench");
+    opt.results = &results;
+
+#if EMH_INT_HASH
+    printf("built with EMH_INT_HASH=%d: emhash5-8 ignore the hasher, only emilib rows vary by hash\n", EMH_INT_HASH);
+#endif
+    opt.csv = fopen(csv_path, "w");
+    if (opt.csv)
+        fprintf(opt.csv, "map,hash,keys,op,n,mops,cliff\n");
+    else
+        fprintf(stderr, "cannot write %s, printing only\n", csv_path);
+
+    const auto sets = int_key_sets(num);
+    const auto strings = string_key_sets(num);
+    printf("%zu keys per set, %.1f s budget per operation (Mops/s)\n", num, opt.budget);
+    printf("%-8s %-7s %-13s %9s %9s %9s\n", "map", "hash", "keys", "insert", "find_hit", "find_miss");
+
+    run<Map5>("emhash5", sets, strings, opt);
+    run<Map6>("emhash6", sets, strings, opt);
+    run<Map7>("emhash7", sets, strings, opt);
+    run<Map8>("emhash8", sets, strings, opt);
+    run<Emilib1>("emilib1", sets, strings, opt);
+    run<Emilib2>("emilib2", sets, strings, opt);
+    run<Emilib3>("emilib3", sets, strings, opt);
+    run<Emilib4>("emilib4", sets, strings, opt);
+
+    if (opt.csv)
+        fclose(opt.csv);
+    if (results.enabled() && results.write())
+        printf("results written to %s\n", results.path().c_str());
+    printf("sink %llu\n", static_cast<unsigned long long>(g_sink));
+    return 0;
+}
@@ -0,0 +1,265 @@
+// Cache-hierarchy sweep: find-hit, find-miss and insert cost of emhash5-8 and emilib1-4 at
+// log-spaced table sizes from 1 KiB to 8 GiB, to locate where each map falls out of L1, L2,
+// L3 and into DRAM on the machine it runs on.
+//
+// Build:
+//   g++ -std=c++17 -O2 -march=native -Iinclude -Ibench bench/bench_cache_sweep.cpp -o cachebench
+// Run:
+//   ./cachebench [max_bytes=8G] [points=32] [sweep.csv] [map filter] [ops=4000000]
+//
+// Sizes are payload bytes (keys * 16 for uint64_t -> uint64_t), so every map gets the same
+// key counts; the CSV also records each table's real footprint from memory_usage() and the
+// cache level that footprint fits in. Cache sizes come from
+// /sys/devices/system/cpu/cpu0/cache. Memory is limited to half the physical memory at the
+// peak of a build, not in payload: max_bytes is capped so that 4x the payload fits (a table
+// needs about 2-4x its payload, plus the old array during a rehash), and a map stops its
+// sweep before a size where its last footprint from memory_usage(), scaled to the new key
+// count and by 1.5 for the rehash, would exceed the limit.
+// Keys are a bijective mix of their index, so probes compute keys on the fly and the timed
+// loops touch nothing but the table. Each point times `ops` random lookups (hits over all
+// keys, misses on keys never inserted) and enough builds from empty, without reserve, to
+// reach `ops` inserts. With EMH_JSON=<path> every point is also written as JSON for
+// bench_compare (see bench_result.h).
+
+#include "bench_result.h"
+
+#include "emhash/hash_table5.hpp"
+#include "emhash/hash_table6.hpp"
+#include "emhash/hash_table7.hpp"
+#include "emhash/hash_table8.hpp"
+#include "emilib/emihmap1.hpp"
+#include "emilib/emihmap2.hpp"
+#include "emilib/emihmap3.hpp"
+#include "emilib/emihmap4.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <unistd.h>
+#endif
+
+namespace {
+
+struct Caches {
+    uint64_t l1d = 32 << 10;
+    uint64_t l2 = 1 << 20;
+    uint64_t l3 = 32 << 20;
+
+    const char* level(uint64_t bytes) const {
+        return bytes <= l1d ? "L1" : bytes <= l2 ? "L2" : bytes <= l3 ? "L3" : "DRAM";
+    }
+};
+
+// "48K" / "2048K" / "32M" -> bytes
+uint64_t parse_size(const std::string& text) {
+    char* end = nullptr;
+    uint64_t value = strtoull(text.c_str(), &end, 10);
+    switch (end ? *end : 0) {
+    case 'G': case 'g': value <<= 10; // fallthrough
+    case 'M': case 'm': value <<= 10; // fallthrough
+    case 'K': case 'k': value <<= 10; break;
+    default: break;
+    }
+    return value;
+}
+
+Caches read_caches() {
+    Caches caches;
+    for (int index = 0; index < 8; index++) {
+        const std::string dir = "/sys/devices/system/cpu/cpu0/cache/index" + std::to_string(index) + "/";
+        std::ifstream level_in(dir + "level"), type_in(dir + "type"), size_in(dir + "size");
+        std::string level, type, size;
+        if (!std::getline(level_in, level) || !std::getline(type_in, type) || !std::getline(size_in, size))
+            continue;
+        if (type == "Instruction")
+            continue;
+        const auto bytes = parse_size(size);
+        if (level == "1")
+            caches.l1d = bytes;
+        else if (level == "2")
+            caches.l2 = bytes;
+        else if (level == "3")
+            caches.l3 = bytes;
+    }
+    return caches;
+}
+
+uint64_t physical_memory() {
+#if defined(_SC_PHYS_PAGES) && defined(_SC_PAGESIZE)
+    const long pages = sysconf(_SC_PHYS_PAGES), page = sysconf(_SC_PAGESIZE);
+    if (pages > 0 && page > 0)
+        return static_cast<uint64_t>(pages) * static_cast<uint64_t>(page);
+#endif
+    return 0;
+}
+
+// splitmix64 finalizer: a bijection, so distinct indices give distinct keys
+inline uint64_t key_of(uint64_t index) {
+    index += 0x9E3779B97F4A7C15ull;
+    index = (index ^ (index >> 30)) * 0xBF58476D1CE4E5B9ull;
+    index = (index ^ (index >> 27)) * 0x94D049BB133111EBull;
+    return index ^ (index >> 31);
+}
+
+struct Rng {
+    uint64_t state;
+    uint32_t next() {
+        state ^= state << 13;
+        state ^= state >> 7;
+        state ^= state << 17;
+        return static_cast<uint32_t>(state >> 32);
+    }
+    // uniform in [0, n) for n < 2^32, else a 64 bit draw folded into [0, n)
+    uint64_t below(uint64_t n) {
+        if (n <= UINT32_MAX)
+            return (static_cast<uint64_t>(next()) * n) >> 32;
+        return ((static_cast<uint64_t>(next()) << 32) | next()) % n;
+    }
+};
+
+double now_ns() {
+    return std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+uint64_t g_sink = 0;
+uint64_t g_memory_limit = 0; // peak bytes a build may reach, 0: unknown
+BenchResults* g_results = nullptr;
+
+template <typename Map>
+void sweep(const char* name, const std::vector<uint64_t>& sizes, uint64_t ops, const Caches& caches, FILE* csv) {
+    double bytes_per_key = 0;
+    for (const auto keys : sizes) {
+        // a rehash holds the old array next to the new one, twice its size
+        const auto peak = bytes_per_key * static_cast<double>(keys) * 1.5;
+        if (g_memory_limit && peak > static_cast<double>(g_memory_limit)) {
+            printf("%-8s %11llu %10llu skipped: about %.0f MiB at peak, limit %llu MiB\n", name,
+                   static_cast<unsigned long long>(keys * 2 * sizeof(uint64_t)), static_cast<unsigned long long>(keys),
+                   peak / 1048576, static_cast<unsigned long long>(g_memory_limit >> 20));
+            break;
+        }
+
+        // insert: whole builds from empty until `ops` inserts
+        double insert_ns = 0;
+        uint64_t inserted = 0;
+        do {
+            Map map;
+            const auto t0 = now_ns();
+            for (uint64_t i = 0; i < keys; i++)
+                (void)map.emplace(key_of(i), i);
+            insert_ns += now_ns() - t0;
+            inserted += keys;
+            g_sink += map.size();
+        } while (inserted < ops);
+
+        Map map;
+        for (uint64_t i = 0; i < keys; i++)
+            (void)map.emplace(key_of(i), i);
+        const auto footprint = map.memory_usage().total();
+        bytes_per_key = static_cast<double>(footprint) / static_cast<double>(keys);
+
+        Rng rng{keys * 0x2545F4914F6CDD1Dull + 1};
+        uint64_t sum = 0;
+        auto t0 = now_ns();
+        for (uint64_t i = 0; i < ops; i++)
+            sum += map.find(key_of(rng.below(keys)))->second;
+        const auto hit_ns = (now_ns() - t0) / static_cast<double>(ops);
+
+        t0 = now_ns();
+        for (uint64_t i = 0; i < ops; i++)
+            sum += map.find(key_of(keys + rng.below(keys))) != map.end();
+        const auto miss_ns = (now_ns() - t0) / static_cast<double>(ops);
+        g_sink += sum;
+
+        const auto payload = keys * 2 * sizeof(uint64_t);
+        const auto per_insert = insert_ns / static_cast<double>(inserted);
+        printf("%-8s %11llu %10llu %12llu %-4s %8.2f %8.2f %8.2f\n", name, static_cast<unsigned long long>(payload),
+               static_cast<unsigned long long>(keys), static_cast<unsigned long long>(footprint),
+               caches.level(footprint), hit_ns, miss_ns, per_insert);
+        if (csv) {
+            fprintf(csv, "%s,%llu,%llu,%llu,%s,%.3f,%.3f,%.3f\n", name, static_cast<unsigned long long>(payload),
+                    static_cast<unsigned long long>(keys), static_cast<unsigned long long>(footprint),
+                    caches.level(footprint), hit_ns, miss_ns, per_insert);
+            fflush(csv);
+        }
+        g_results->add(name, "find_hit", keys, "uint64_t", "uint64_t", hit_ns);
+        g_results->add(name, "find_miss", keys, "uint64_t", "uint64_t", miss_ns);
+        g_results->add(name, "insert", keys, "uint64_t", "uint64_t", per_insert);
+    }
+}
+
+template <typename Map>
+void run(const char* name, const char* filter, const std::vector<uint64_t>& sizes, uint64_t ops,
+         const Caches& caches, FILE* csv) {
+    if (!filter || strstr(name, filter))
+        sweep<Map>(name, sizes, ops, caches, csv);
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    uint64_t max_bytes = argc > 1 ? parse_size(argv[1]) : (8ull << 30);
+    const int points = argc > 2 ? std::max(2, atoi(argv[2])) : 32;
+    const char* csv_path = argc > 3 ? argv[3] : "sweep.csv";
+    const char* filter = argc > 4 ? argv[4] : nullptr;
+    const uint64_t ops = argc > 5 ? strtoull(argv[5], nullptr, 10) : 4000000;
+
+    BenchResults results("cachebench");
+    g_results = &results;
+    const auto caches = read_caches();
+    g_memory_limit = physical_memory() / 2;
+    if (g_memory_limit && max_bytes > g_memory_limit / 4) {
+        printf("max size %llu capped at %llu: 4x the payload must fit in half the physical memory\n",
+               static_cast<unsigned long long>(max_bytes), static_cast<unsigned long long>(g_memory_limit / 4));
+        max_bytes = g_memory_limit / 4;
+    }
+
+    constexpr uint64_t MIN_BYTES = 1 << 10, ELEMENT = 2 * sizeof(uint64_t);
+    std::vector<uint64_t> sizes;
+    const double step = std::pow(static_cast<double>(max_bytes) / MIN_BYTES, 1.0 / (points - 1));
+    for (int i = 0; i < points; i++) {
+        const auto keys = static_cast<uint64_t>(MIN_BYTES * std::pow(step, i) / ELEMENT);
+        if (keys > 0 && (sizes.empty() || keys > sizes.back()))
+            sizes.push_back(keys);
+    }
+
+    FILE* csv = fopen(csv_path, "w");
+    if (!csv)
+        fprintf(stderr, "cannot write %s, printing only\n", csv_path);
+    else {
+        fprintf(csv, "# l1d=%llu l2=%llu l3=%llu\n", static_cast<unsigned long long>(caches.l1d),
+                static_cast<unsigned long long>(caches.l2), static_cast<unsigned long long>(caches.l3));
+        fprintf(csv, "map,payload_bytes,keys,table_bytes,level,find_hit_ns,find_miss_ns,insert_ns\n");
+    }
+
+    printf("caches: L1d %llu KiB, L2 %llu KiB, L3 %llu KiB; %zu sizes up to %llu MiB, %llu ops per point\n",
+           static_cast<unsigned long long>(caches.l1d >> 10), static_cast<unsigned long long>(caches.l2 >> 10),
+           static_cast<unsigned long long>(caches.l3 >> 10), sizes.size(),
+           static_cast<unsigned long long>(max_bytes >> 20), static_cast<unsigned long long>(ops));
+    printf("%-8s %11s %10s %12s %-4s %8s %8s %8s\n", "map", "payload", "keys", "table", "fits", "hit ns", "miss ns",
+           "ins ns");
+
+    run<emhash5::HashMap<uint64_t, uint64_t>>("emhash5", filter, sizes, ops, caches, csv);
+    run<emhash6::HashMap<uint64_t, uint64_t>>("emhash6", filter, sizes, ops, caches, csv);
+    run<emhash7::HashMap<uint64_t, uint64_t>>("emhash7", filter, sizes, ops, caches, csv);
+    run<emhash8::HashMap<uint64_t, uint64_t>>("emhash8", filter, sizes, ops, caches, csv);
+    run<emilib::HashMap<uint64_t, uint64_t>>("emilib1", filter, sizes, ops, caches, csv);
+    run<emilib2::HashMap<uint64_t, uint64_t>>("emilib2", filter, sizes, ops, caches, csv);
+    run<emilib3::HashMap<uint64_t, uint64_t>>("emilib3", filter, sizes, ops, caches, csv);
+    run<emilib4::HashMap<uint64_t, uint64_t>>("emilib4", filter, sizes, ops, caches, csv);
+
+    if (csv)
+        fclose(csv);
+    if (results.enabled() && results.write())
+        printf("results written to %s\n", results.path().c_str());
+    printf("sink %llu\n", static_cast<unsigned long long>(g_sink));
+    return 0;
+}
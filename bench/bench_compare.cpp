@@ -0,0 +1,475 @@
+// Compares two sets of benchmark results written with EMH_JSON=<path> (see bench_result.h)
+// and flags the regressions that are statistically significant, per map and operation.
+//
+// Build:
+//   g++ -std=c++17 -O2 -Iinclude -Ibench bench/bench_compare.cpp -o bench_compare
+// Run:
+//   ./bench_compare [options] base.json [base2.json ...] -- new.json [new2.json ...]
+//
+//   --threshold=5     smallest slowdown in percent worth flagging
+//   --alpha=0.05      significance level of the Mann-Whitney U test
+//   --resamples=2000  bootstrap resamples for the confidence interval of the median ratio
+//   --filter=<text>   only maps containing <text>
+//   --all             print every measurement, not only the flagged ones
+//
+// Measurements are matched on (benchmark, map, op, size, key, value); every file and every
+// repeated row adds one sample. For each match the tool prints the median ns/op of both
+// sides, their ratio with a 95% bootstrap interval, and the two-sided Mann-Whitney p-value
+// (exact for small samples without ties, normal approximation otherwise). A measurement is
+// a regression when the new median is more than `threshold` slower, p < alpha and the whole
+// interval lies above 1; improvements are the mirror image. Rows with fewer than 2 samples
+// on either side are compared but never flagged: 4 or more runs per side are needed for
+// p < 0.05.
+//
+// A summary line per benchmark, map and op gives the geometric mean ratio over sizes and
+// the number of regressions and improvements. Exit status: 0 no regression, 1 regressions,
+// 2 unreadable input.
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <map>
+#include <sstream>
+#include <string>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+namespace {
+
+// ---- minimal JSON reader, enough for bench_result.h output ---------------------------
+
+struct Json {
+    enum Type { NUL, BOOL, NUMBER, STRING, ARRAY, OBJECT } type = NUL;
+    double number = 0;
+    std::string text;
+    std::vector<Json> items;
+    std::vector<std::pair<std::string, Json>> fields;
+
+    const Json* get(const char* name) const {
+        for (const auto& field : fields)
+            if (field.first == name)
+                return &field.second;
+        return nullptr;
+    }
+    std::string str(const char* name) const {
+        const auto* field = get(name);
+        return field && field->type == STRING ? field->text : std::string();
+    }
+    double num(const char* name, double fallback = 0) const {
+        const auto* field = get(name);
+        return field && field->type == NUMBER ? field->number : fallback;
+    }
+};
+
+class JsonParser {
+public:
+    explicit JsonParser(const std::string& text) : _p(text.c_str()), _end(text.c_str() + text.size()) {}
+
+    bool parse(Json& out) {
+        if (!value(out))
+            return false;
+        skip();
+        return _p == _end;
+    }
+
+private:
+    void skip() {
+        while (_p < _end && (*_p == ' ' || *_p == '\t' || *_p == '\n' || *_p == '\r'))
+            _p++;
+    }
+
+    bool literal(const char* word) {
+        const auto len = strlen(word);
+        if (static_cast<size_t>(_end - _p) < len || strncmp(_p, word, len) != 0)
+            return false;
+        _p += len;
+        return true;
+    }
+
+    bool string(std::string& out) {
+        if (*_p++ != '"')
+            return false;
+        while (_p < _end && *_p != '"') {
+            if (*_p != '\\') {
+                out += *_p++;
+                continue;
+            }
+            if (++_p >= _end)
+                return false;
+            const char c = *_p++;
+            switch (c) {
+            case 'n': out += '\n'; break;
+            case 't': out += '\t'; break;
+            case 'r': out += '\r'; break;
+            case 'b': out += '\b'; break;
+            case 'f': out += '\f'; break;
+            case 'u': // control characters only (what bench_result.h escapes); others become '?'
+                if (_end - _p < 4)
+                    return false;
+                {
+                    const auto code = strtoul(std::string(_p, 4).c_str(), nullptr, 16);
+                    out += code < 0x80 ? static_cast<char>(code) : '?';
+                }
+                _p += 4;
+                break;
+            default: out += c; break;
+            }
+        }
+        if (_p >= _end)
+            return false;
+        _p++;
+        return true;
+    }
+
+    bool value(Json& out) {
+        skip();
+        if (_p >= _end)
+            return false;
+        if (*_p == '{') {
+            out.type = Json::OBJECT;
+            _p++;
+            skip();
+            if (_p < _end && *_p == '}')
+                return ++_p, true;
+            while (true) {
+                skip();
+                std::string name;
+                if (_p >= _end || !string(name))
+                    return false;
+                skip();
+                if (_p >= _end || *_p++ != ':')
+                    return false;
+                out.fields.emplace_back(std::move(name), Json());
+                if (!value(out.fields.back().second))
+                    return false;
+                skip();
+                if (_p < _end && *_p == ',') {
+                    _p++;
+                    continue;
+                }
+                return _p < _end && *_p++ == '}';
+            }
+        }
+        if (*_p == '[') {
+            out.type = Json::ARRAY;
+            _p++;
+            skip();
+            if (_p < _end && *_p == ']')
+                return ++_p, true;
+            while (true) {
+                out.items.emplace_back();
+                if (!value(out.items.back()))
+                    return false;
+                skip();
+                if (_p < _end && *_p == ',') {
+                    _p++;
+                    continue;
+                }
+                return _p < _end && *_p++ == ']';
+            }
+        }
+        if (*_p == '"') {
+            out.type = Json::STRING;
+            return string(out.text);
+        }
+        if (literal("true") || literal("false")) {
+            out.type = Json::BOOL;
+            out.number = _p[-1] == 'e' && _p[-2] == 'u'; // "true" ends in "ue", "false" in "se"
+            return true;
+        }
+        if (literal("null"))
+            return true;
+        char* end = nullptr;
+        out.type = Json::NUMBER;
+        out.number = strtod(_p, &end);
+        if (end == _p)
+            return false;
+        _p = end;
+        return true;
+    }
+
+    const char* _p;
+    const char* _end;
+};
+
+// ---- samples ------------------------------------------------------------------------
+
+struct Key {
+    std::string bench, map, op, key, value;
+    uint64_t size;
+
+    bool operator<(const Key& o) const {
+        return std::tie(bench, map, op, size, key, value) < std::tie(o.bench, o.map, o.op, o.size, o.key, o.value);
+    }
+};
+
+struct Side {
+    std::map<Key, std::vector<double>> samples;
+    std::vector<std::string> contexts; // "cpu | compiler | flags | emhash" per file
+};
+
+bool load(const char* path, const char* filter, Side& side) {
+    std::ifstream in(path, std::ios::binary);
+    if (!in) {
+        fprintf(stderr, "cannot read %s\n", path);
+        return false;
+    }
+    std::stringstream buffer;
+    buffer << in.rdbuf();
+    const auto text = buffer.str();
+    Json doc;
+    if (!JsonParser(text).parse(doc) || doc.type != Json::OBJECT) {
+        fprintf(stderr, "%s is not a results file\n", path);
+        return false;
+    }
+    const auto* context = doc.get("context");
+    const auto* results = doc.get("results");
+    if (!context || !results || results->type != Json::ARRAY) {
+        fprintf(stderr, "%s has no context or results\n", path);
+        return false;
+    }
+    const auto bench = context->str("bench");
+    const auto isa = context->str("isa");
+    const auto summary = context->str("cpu") + " | " + context->str("compiler") + " | " + context->str("flags") +
+                         (isa.empty() ? "" : " " + isa) + " | emhash " + context->str("emhash");
+    if (std::find(side.contexts.begin(), side.contexts.end(), summary) == side.contexts.end())
+        side.contexts.push_back(summary);
+
+    for (const auto& row : results->items) {
+        const auto ns = row.num("ns_op", -1);
+        if (ns <= 0 || (filter && row.str("map").find(filter) == std::string::npos))
+            continue;
+        const Key key{bench, row.str("map"), row.str("op"), row.str("key"), row.str("value"),
+                      static_cast<uint64_t>(row.num("size"))};
+        side.samples[key].push_back(ns);
+    }
+    return true;
+}
+
+// ---- statistics ---------------------------------------------------------------------
+
+double median(std::vector<double> v) {
+    const auto mid = v.size() / 2;
+    std::nth_element(v.begin(), v.begin() + static_cast<std::ptrdiff_t>(mid), v.end());
+    if (v.size() % 2)
+        return v[mid];
+    const auto upper = v[mid];
+    return (*std::max_element(v.begin(), v.begin() + static_cast<std::ptrdiff_t>(mid)) + upper) / 2;
+}
+
+double normal_cdf(double z) { return 0.5 * std::erfc(-z / std::sqrt(2.0)); }
+
+// Two-sided Mann-Whitney U test p-value.
+double mann_whitney(const std::vector<double>& a, const std::vector<double>& b) {
+    const auto n1 = a.size(), n2 = b.size(), n = n1 + n2;
+    std::vector<std::pair<double, int>> all;
+    for (const auto x : a)
+        all.emplace_back(x, 0);
+    for (const auto x : b)
+        all.emplace_back(x, 1);
+    std::sort(all.begin(), all.end());
+
+    double rank_a = 0, tie_term = 0;
+    bool ties = false;
+    for (size_t i = 0; i < n;) {
+        auto j = i;
+        while (j < n && all[j].first == all[i].first)
+            j++;
+        const double rank = (static_cast<double>(i + j) + 1) / 2; // mid-rank of positions i+1..j
+        for (auto k = i; k < j; k++)
+            if (all[k].second == 0)
+                rank_a += rank;
+        const double t = static_cast<double>(j - i);
+        tie_term += t * t * t - t;
+        ties |= j - i > 1;
+        i = j;
+    }
+    const double u = rank_a - static_cast<double>(n1 * (n1 + 1)) / 2;
+    const double mean = static_cast<double>(n1 * n2) / 2;
+
+    if (!ties && n1 * n2 <= 2500) {
+        // exact: count[m][k] arrangements of m a's and k b's with U = u, built column by column
+        const size_t max_u = n1 * n2;
+        std::vector<std::vector<double>> prev(n2 + 1), cur(n2 + 1);
+        for (size_t k = 0; k <= n2; k++)
+            prev[k].assign(max_u + 1, 0), prev[k][0] = 1; // m = 0: U is 0
+        for (size_t m = 1; m <= n1; m++) {
+            for (size_t k = 0; k <= n2; k++) {
+                cur[k].assign(max_u + 1, 0);
+                for (size_t v = 0; v <= max_u; v++) {
+                    // the largest value is an a (adds k to U) or a b
+                    double count = v >= k ? prev[k][v - k] : 0;
+                    if (k > 0)
+                        count += cur[k - 1][v];
+                    cur[k][v] = count;
+                }
+            }
+            std::swap(prev, cur);
+        }
+        const auto& dist = prev[n2];
+        double total = 0, below = 0, above = 0;
+        for (size_t v = 0; v <= max_u; v++) {
+            total += dist[v];
+            if (static_cast<double>(v) <= u)
+                below += dist[v];
+            if (static_cast<double>(v) >= u)
+                above += dist[v];
+        }
+        return std::min(1.0, 2 * std::min(below, above) / total);
+    }
+
+    const double var = static_cast<double>(n1 * n2) / 12 *
+                       (static_cast<double>(n + 1) - tie_term / static_cast<double>(n * (n - 1)));
+    if (var <= 0)
+        return 1;
+    const double z = (std::fabs(u - mean) - 0.5) / std::sqrt(var);
+    return std::min(1.0, 2 * (1 - normal_cdf(std::max(0.0, z))));
+}
+
+struct Rng {
+    uint64_t state = 0x9E3779B97F4A7C15ull;
+    size_t below(size_t n) {
+        state ^= state << 13;
+        state ^= state >> 7;
+        state ^= state << 17;
+        return static_cast<size_t>((state >> 32) * n >> 32);
+    }
+};
+
+// 95% percentile bootstrap interval of median(b) / median(a).
+std::pair<double, double> bootstrap_ratio(const std::vector<double>& a, const std::vector<double>& b,
+                                          int resamples) {
+    Rng rng;
+    std::vector<double> ratios, ra(a.size()), rb(b.size());
+    ratios.reserve(static_cast<size_t>(resamples));
+    for (int r = 0; r < resamples; r++) {
+        for (auto& x : ra)
+            x = a[rng.below(a.size())];
+        for (auto& x : rb)
+            x = b[rng.below(b.size())];
+        ratios.push_back(median(rb) / median(ra));
+    }
+    std::sort(ratios.begin(), ratios.end());
+    const auto at = [&](double q) {
+        return ratios[std::min(ratios.size() - 1, static_cast<size_t>(q * static_cast<double>(ratios.size())))];
+    };
+    return {at(0.025), at(0.975)};
+}
+
+struct Summary {
+    double log_sum = 0;
+    int count = 0, regressions = 0, improvements = 0;
+};
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    double threshold = 5, alpha = 0.05;
+    int resamples = 2000;
+    const char* filter = nullptr;
+    bool all = false, second = false;
+    std::vector<const char*> base_files, new_files;
+
+    for (int i = 1; i < argc; i++) {
+        const char* arg = argv[i];
+        if (!strncmp(arg, "--threshold=", 12))
+            threshold = atof(arg + 12);
+        else if (!strncmp(arg, "--alpha=", 8))
+            alpha = atof(arg + 8);
+        else if (!strncmp(arg, "--resamples=", 12))
+            resamples = std::max(100, atoi(arg + 12));
+        else if (!strncmp(arg, "--filter=", 9))
+            filter = arg + 9;
+        else if (!strcmp(arg, "--all"))
+            all = true;
+        else if (!strcmp(arg, "--"))
+            second = true;
+        else
+            (second ? new_files : base_files).push_back(arg);
+    }
+    if (base_files.empty() || new_files.empty()) {
+        fprintf(stderr, "usage: %s [--threshold=5] [--alpha=0.05] [--resamples=2000] [--filter=map] [--all] "
+                        "base.json [...] -- new.json [...]\n", argv[0]);
+        return 2;
+    }
+
+    Side base, current;
+    for (const auto* path : base_files)
+        if (!load(path, filter, base))
+            return 2;
+    for (const auto* path : new_files)
+        if (!load(path, filter, current))
+            return 2;
+
+    for (const auto& context : base.contexts)
+        printf("base: %s\n", context.c_str());
+    for (const auto& context : current.contexts)
+        printf("new:  %s\n", context.c_str());
+    if (base.contexts != current.contexts)
+        printf("warning: the two sets ran on different machines, compilers or flags\n");
+    printf("regression: > %.1f%% slower, Mann-Whitney p < %.3g, 95%% bootstrap interval above 1\n\n", threshold,
+           alpha);
+
+    printf("%-12s %-14s %-10s %10s %-12s %5s %5s %10s %10s %7s %17s %8s\n", "bench", "map", "op", "size", "key",
+           "n1", "n2", "base ns", "new ns", "ratio", "95% interval", "p");
+    std::map<std::string, Summary> summaries;
+    int regressions = 0, unmatched = 0, thin = 0;
+    for (const auto& entry : base.samples) {
+        const auto it = current.samples.find(entry.first);
+        if (it == current.samples.end()) {
+            unmatched++;
+            continue;
+        }
+        const auto& k = entry.first;
+        const auto& a = entry.second;
+        const auto& b = it->second;
+        const double ratio = median(b) / median(a);
+        const bool enough = a.size() >= 2 && b.size() >= 2;
+        thin += !enough;
+        const double p = enough ? mann_whitney(a, b) : 1;
+        const auto interval = enough ? bootstrap_ratio(a, b, resamples) : std::make_pair(0.0, 0.0);
+
+        const char* verdict = "";
+        if (enough && p < alpha && ratio > 1 + threshold / 100 && interval.first > 1)
+            verdict = "REGRESSION";
+        else if (enough && p < alpha && ratio < 1 - threshold / 100 && interval.second < 1)
+            verdict = "improved";
+
+        auto& summary = summaries[k.bench + " " + k.map + " " + k.op];
+        summary.log_sum += std::log(ratio);
+        summary.count++;
+        summary.regressions += verdict[0] == 'R';
+        summary.improvements += verdict[0] == 'i';
+        regressions += verdict[0] == 'R';
+
+        if (!all && !verdict[0])
+            continue;
+        char range[32] = "-";
+        if (enough)
+            snprintf(range, sizeof(range), "[%.3f, %.3f]", interval.first, interval.second);
+        printf("%-12s %-14s %-10s %10llu %-12s %5zu %5zu %10.2f %10.2f %7.3f %17s %8.2g %s\n", k.bench.c_str(),
+               k.map.c_str(), k.op.c_str(), static_cast<unsigned long long>(k.size), k.key.c_str(), a.size(),
+               b.size(), median(a), median(b), ratio, range, p, verdict);
+    }
+    for (const auto& entry : current.samples)
+        unmatched += base.samples.find(entry.first) == base.samples.end();
+
+    printf("\n%-40s %6s %9s %11s %9s\n", "bench map op", "sizes", "geo ratio", "regressions", "improved");
+    for (const auto& entry : summaries) {
+        const auto& s = entry.second;
+        printf("%-40s %6d %9.3f %11d %9d%s\n", entry.first.c_str(), s.count, std::exp(s.log_sum / s.count),
+               s.regressions, s.improvements, s.regressions ? "  REGRESSED" : "");
+    }
+    if (unmatched)
+        printf("%d measurements are only in one of the sets\n", unmatched);
+    if (thin)
+        printf("%d measurements have fewer than 2 samples on a side and were not tested; "
+               "rerun with repeats\n", thin);
+    printf("%d regressions\n", regressions);
+    return regressions ? 1 : 0;
+}
@@ -0,0 +1,129 @@
+// emhash_counter::CountMap vs. HashMap<K, uint32_t> with map[key]++ on a Zipf token stream.
+//
+// Build:
+//   g++ -std=c++17 -O2 -march=native -Iinclude bench/bench_count_map.cpp -o countbench
+// Run:
+//   ./countbench [tokens=20000000] [vocabulary=5000000] [zipf_s=1.0] [k=100]
+//
+// With EMH_JSON=<path> the timings are also recorded for bench_compare in ns per token:
+// emhash8 count (map[key]++) and top_k (copy + partial_sort), CountMap increment,
+// increment_batch and top_k.
+
+#include "bench_result.h"
+
+#include "emhash/counter_map.hpp"
+#include "emhash/hash_table8.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+static BenchResults* g_results = nullptr;
+
+static double now_ms() {
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// Token ids drawn from a Zipf(s) distribution over [0, vocabulary) by inverting the CDF.
+static std::vector<uint32_t> zipf_ids(size_t tokens, size_t vocabulary, double s) {
+    std::vector<double> cdf(vocabulary);
+    double sum = 0;
+    for (size_t i = 0; i < vocabulary; i++)
+        cdf[i] = sum += 1.0 / std::pow(double(i + 1), s);
+    std::mt19937_64 rng(20260303);
+    std::uniform_real_distribution<double> uni(0, sum);
+    std::vector<uint32_t> ids(tokens);
+    for (auto& id : ids)
+        id = static_cast<uint32_t>(std::lower_bound(cdf.begin(), cdf.end(), uni(rng)) - cdf.begin());
+    return ids;
+}
+
+template <typename Key> static void run(const char* name, const std::vector<Key>& tokens, size_t k) {
+    emhash8::HashMap<Key, uint32_t> map;
+    auto t0 = now_ms();
+    for (const auto& token : tokens)
+        map[token]++;
+    const auto map_ms = now_ms() - t0;
+
+    emhash_counter::CountMap<Key> single;
+    t0 = now_ms();
+    for (const auto& token : tokens)
+        single.increment(token);
+    const auto single_ms = now_ms() - t0;
+
+    emhash_counter::CountMap<Key> counts;
+    t0 = now_ms();
+    counts.increment_batch(tokens.begin(), tokens.end());
+    const auto count_ms = now_ms() - t0;
+
+    t0 = now_ms();
+    std::vector<std::pair<uint32_t, Key>> all;
+    all.reserve(map.size());
+    for (const auto& kv : map)
+        all.emplace_back(kv.second, kv.first);
+    const auto kk = std::min(k, all.size());
+    std::partial_sort(all.begin(), all.begin() + kk, all.end(), [](const std::pair<uint32_t, Key>& a,
+                                                                   const std::pair<uint32_t, Key>& b) {
+        return a.first > b.first;
+    });
+    const auto sort_ms = now_ms() - t0;
+
+    t0 = now_ms();
+    const auto top = counts.top_k(k);
+    const auto topk_ms = now_ms() - t0;
+
+    const auto map_bytes = map.memory_usage().total(), count_bytes = counts.memory_usage().total();
+    printf("%-8s %zu distinct / %zu tokens, %zu wide\n", name, size_t(counts.size()), tokens.size(),
+           size_t(counts.wide_count()));
+    printf("  count     map[key]++ %8.2f ms (%5.2f ns/token)  increment %8.2f ms  x%.2f  increment_batch %8.2f ms"
+           " (%5.2f ns/token)  x%.2f\n",
+           map_ms, map_ms * 1e6 / tokens.size(), single_ms, map_ms / single_ms, count_ms,
+           count_ms * 1e6 / tokens.size(), map_ms / count_ms);
+    printf("  top_%-4zu  copy+partial_sort %8.2f ms  top_k %8.2f ms  x%.2f\n", k, sort_ms, topk_ms, sort_ms / topk_ms);
+    printf("  memory    map %.1f MB (%.1f B/key)  count map %.1f MB (%.1f B/key)\n", map_bytes / 1048576.0,
+           map_bytes * 1.0 / map.size(), count_bytes / 1048576.0, count_bytes * 1.0 / counts.size());
+
+    if (top.size() != kk || (kk && top[0].second != all[0].first) || (kk && top[kk - 1].second != all[kk - 1].first))
+        printf("  MISMATCH\n");
+
+    const char* key = std::is_same<Key, std::string>::value ? "std::string" : "uint64_t";
+    const auto record = [&](const char* map_name, const char* op, double ms) {
+        if (!tokens.empty())
+            g_results->add(map_name, op, tokens.size(), key, "uint32_t", ms * 1e6 / tokens.size());
+    };
+    record("emhash8", "count", map_ms);
+    record("emhash8", "top_k", sort_ms);
+    record("CountMap", "increment", single_ms);
+    record("CountMap", "increment_batch", count_ms);
+    record("CountMap", "top_k", topk_ms);
+}
+
+int main(int argc, char* argv[]) {
+    const size_t tokens = argc > 1 ? strtoull(argv[1], nullptr, 10) : 20000000;
+    const size_t vocabulary = argc > 2 ? strtoull(argv[2], nullptr, 10) : 5000000;
+    const double s = argc > 3 ? atof(argv[3]) : 1.0;
+    const size_t k = argc > 4 ? strtoull(argv[4], nullptr, 10) : 100;
+
+    BenchResults results("countbench");
+    g_results = &results;
+    const auto ids = zipf_ids(tokens, vocabulary, s);
+    std::vector<uint64_t> int_tokens(ids.size());
+    for (size_t i = 0; i < ids.size(); i++)
+        int_tokens[i] = ids[i] * 0x9E3779B97F4A7C15ull;
+    run("uint64", int_tokens, k);
+
+    std::vector<std::string> str_tokens(ids.size());
+    for (size_t i = 0; i < ids.size(); i++)
+        str_tokens[i] = "token_" + std::to_string(ids[i]);
+    run("string", str_tokens, k);
+    if (results.enabled() && results.write())
+        printf("results written to %s\n", results.path().c_str());
+    return 0;
+}
@@ -0,0 +1,118 @@
+// emhash7::HashMap with and without an emfilter::filtered<> Bloom front on miss-heavy finds.
+//
+// Build:
+//   g++ -std=c++17 -O2 -march=native -Iinclude bench/bench_filter_miss.cpp -o filterbench
+// Run:
+//   ./filterbench [keys=20000000] [miss_percent=90] [bits_per_key=10]
+//
+// The default run needs about 1.5 GB of memory. With EMH_JSON=<path> both columns are also
+// recorded for bench_compare (maps emhash7 and emhash7_bloom) in ns per operation.
+
+#include "bench_result.h"
+
+#include "emhash/bloom_filter.hpp"
+#include "emhash/hash_table7.hpp"
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <vector>
+
+using Map = emhash7::HashMap<uint64_t, uint64_t>;
+using Filtered = emfilter::filtered<Map>;
+
+static BenchResults* g_results = nullptr;
+
+static double now_ms() {
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+template <typename F> static double best_of(int rounds, F&& fn) {
+    double best = 1e30;
+    for (int r = 0; r < rounds; r++) {
+        const auto t0 = now_ms();
+        fn();
+        const auto t1 = now_ms();
+        if (t1 - t0 < best)
+            best = t1 - t0;
+    }
+    return best;
+}
+
+static void report(const char* name, double plain_ms, double filtered_ms, size_t ops) {
+    printf("%-16s plain %9.2f ms (%6.2f ns/op)  filtered %9.2f ms (%6.2f ns/op)  x%.2f\n", name, plain_ms,
+           plain_ms * 1e6 / ops, filtered_ms, filtered_ms * 1e6 / ops, plain_ms / filtered_ms);
+    if (ops) {
+        g_results->add("emhash7", name, ops, "uint64_t", "uint64_t", plain_ms * 1e6 / ops);
+        g_results->add("emhash7_bloom", name, ops, "uint64_t", "uint64_t", filtered_ms * 1e6 / ops);
+    }
+}
+
+int main(int argc, char* argv[]) {
+    const size_t num_keys = argc > 1 ? strtoull(argv[1], nullptr, 10) : 20000000;
+    const int miss_percent = argc > 2 ? atoi(argv[2]) : 90;
+    const double bits_per_key = argc > 3 ? atof(argv[3]) : 10.0;
+    const size_t num_probes = num_keys;
+    const int rounds = 3;
+
+    BenchResults results("filterbench");
+    g_results = &results;
+
+    // odd keys are stored, even keys always miss
+    std::mt19937_64 rng(20260202);
+    std::vector<uint64_t> keys(num_keys), probes(num_probes);
+    for (auto& key : keys)
+        key = rng() | 1;
+    for (auto& key : probes)
+        key = static_cast<int>(rng() % 100) < miss_percent ? rng() & ~1ull : keys[rng() % num_keys];
+
+    Map plain;
+    Filtered filtered(static_cast<uint32_t>(num_keys), bits_per_key);
+    auto plain_ms = best_of(1, [&] {
+        plain.reserve(static_cast<uint32_t>(num_keys));
+        for (auto key : keys)
+            plain.emplace(key, key);
+    });
+    auto filtered_ms = best_of(1, [&] {
+        filtered.reserve(static_cast<uint32_t>(num_keys));
+        for (auto key : keys)
+            filtered.emplace(key, key);
+    });
+    printf("%zu keys, %d%% misses, %.1f bits/key: filter %.1f MB (est. fpr %.4f), table %zu buckets\n",
+           size_t(plain.size()), miss_percent, bits_per_key, filtered.filter().memory_usage().total() / 1048576.0,
+           emfilter::block_bloom::estimated_fpr(bits_per_key), size_t(plain.bucket_count()));
+    report("insert", plain_ms, filtered_ms, num_keys);
+
+    size_t plain_hits = 0, filtered_hits = 0;
+    plain_ms = best_of(rounds, [&] {
+        plain_hits = 0;
+        for (auto key : probes)
+            plain_hits += plain.find(key) != plain.end();
+    });
+    filtered_ms = best_of(rounds, [&] {
+        filtered_hits = 0;
+        for (auto key : probes)
+            filtered_hits += filtered.contains(key);
+    });
+    report("find", plain_ms, filtered_ms, num_probes);
+    if (plain_hits != filtered_hits)
+        return 1;
+
+    std::vector<uint8_t> out(num_probes);
+    filtered_ms = best_of(rounds, [&] {
+        filtered_hits = filtered.contains_batch(probes.data(), num_probes, out.data());
+    });
+    report("contains_batch", plain_ms, filtered_ms, num_probes);
+
+    size_t maybes = 0;
+    for (auto key : probes)
+        maybes += filtered.may_contain(key);
+    printf("filter passed %.2f%% of probes, %.2f%% hit\n", maybes * 100.0 / num_probes,
+           plain_hits * 100.0 / num_probes);
+    if (results.enabled() && results.write())
+        printf("results written to %s\n", results.path().c_str());
+
+    return plain_hits == filtered_hits ? 0 : 1;
+}
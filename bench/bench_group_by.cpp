@@ -0,0 +1,183 @@
+// GROUP BY sum: serial `map[key] += value`, per-thread tables merged serially, and
+// emhash_agg::GroupBy, at low, medium and high group cardinality and at 1..N threads.
+//
+// Build:
+//   g++ -std=c++17 -O2 -march=native -pthread -Iinclude bench/bench_group_by.cpp -o groupbench
+// Run:
+//   ./groupbench [rows=20000000] [threads=hardware] [groupby.csv] [spill_groups=16384]
+//
+// Rows are (uint64_t key, int64_t value) with keys drawn uniformly from
+//   low     100 groups
+//   medium  100k groups (a few MiB of table, around L2/L3)
+//   high    rows / 2 groups (every group a couple of rows, far beyond the LLC at 20M)
+//
+//   serial    emhash7 `map[key] += value` on one thread, the baseline
+//   merge     each thread aggregates its slice into a full emhash7 table, then the
+//             thread tables are merged into the first one on the calling thread
+//   groupby   GroupBy on emhash7 and emhash8 tables (local tables spilled at
+//             spill_groups, partitions merged in parallel)
+//
+// Each line reports rows per second and the speedup over serial; the group count and
+// the checksum of all sums must match serial. With EMH_JSON=<path> every line is also
+// recorded as ns per row (map: variant, op: cardinality/threads, size: rows).
+
+#include "bench_result.h"
+
+#include "emhash/group_by.hpp"
+#include "emhash/hash_table7.hpp"
+#include "emhash/hash_table8.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+
+using Map7 = emhash7::HashMap<uint64_t, int64_t>;
+using Map8 = emhash8::HashMap<uint64_t, int64_t>;
+
+double now_s() {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+BenchResults* g_results = nullptr;
+
+struct Result {
+    double seconds;
+    size_t groups;
+    uint64_t checksum; // sum over groups of key * sum, order independent
+};
+
+template <typename Map> uint64_t checksum(const Map& map) {
+    uint64_t sum = 0;
+    for (const auto& kv : map)
+        sum += kv.first * static_cast<uint64_t>(kv.second);
+    return sum;
+}
+
+Result serial(const std::vector<uint64_t>& keys, const std::vector<int64_t>& values) {
+    const auto t0 = now_s();
+    Map7 map;
+    for (size_t i = 0; i < keys.size(); i++)
+        map[keys[i]] += values[i];
+    const auto t1 = now_s();
+    return {t1 - t0, static_cast<size_t>(map.size()), checksum(map)};
+}
+
+Result thread_merge(const std::vector<uint64_t>& keys, const std::vector<int64_t>& values, unsigned threads) {
+    const auto t0 = now_s();
+    std::vector<Map7> maps(threads);
+    const auto n = keys.size(), chunk = (n + threads - 1) / threads;
+    std::vector<std::thread> workers;
+    const auto work = [&](unsigned t) {
+        auto& map = maps[t];
+        for (auto i = std::min(n, t * chunk), end = std::min(n, (t + 1) * chunk); i < end; i++)
+            map[keys[i]] += values[i];
+    };
+    for (unsigned t = 1; t < threads; t++)
+        workers.emplace_back(work, t);
+    work(0);
+    for (auto& worker : workers)
+        worker.join();
+    for (unsigned t = 1; t < threads; t++)
+        for (const auto& kv : maps[t])
+            maps[0][kv.first] += kv.second;
+    const auto t1 = now_s();
+    return {t1 - t0, static_cast<size_t>(maps[0].size()), checksum(maps[0])};
+}
+
+template <typename Map>
+Result group_by(const std::vector<uint64_t>& keys, const std::vector<int64_t>& values, unsigned threads,
+                size_t spill_groups, size_t& spilled) {
+    emhash_agg::GroupByOptions options;
+    options.threads = threads;
+    options.spill_groups = spill_groups;
+    const auto t0 = now_s();
+    emhash_agg::GroupBy<uint64_t, int64_t, emhash_agg::Sum<int64_t>, Map> g(options);
+    g.add(keys, values);
+    const auto t1 = now_s();
+
+    uint64_t sum = 0;
+    g.for_each([&](uint64_t key, int64_t total) { sum += key * static_cast<uint64_t>(total); });
+    spilled = g.spilled();
+    return {t1 - t0, g.size(), sum};
+}
+
+void report(FILE* csv, const char* cardinality, const char* variant, unsigned threads, size_t rows, const Result& r,
+            const Result& base, size_t spilled) {
+    const auto mrows = static_cast<double>(rows) / 1e6 / r.seconds;
+    const bool ok = r.groups == base.groups && r.checksum == base.checksum;
+    printf("%-7s %-14s %3u %10zu %9.3f %9.1f %7.2fx %10zu %s\n", cardinality, variant, threads, r.groups, r.seconds,
+           mrows, base.seconds / r.seconds, spilled, ok ? "" : "MISMATCH");
+    if (csv) {
+        fprintf(csv, "%s,%s,%u,%zu,%zu,%.4f,%.2f,%.3f,%zu\n", cardinality, variant, threads, rows, r.groups, r.seconds,
+                mrows, base.seconds / r.seconds, spilled);
+        fflush(csv);
+    }
+    const auto op = std::string(cardinality) + "/" + std::to_string(threads) + "t";
+    g_results->add(variant, op, rows, "uint64_t", "int64_t", r.seconds * 1e9 / static_cast<double>(rows));
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    const size_t rows = argc > 1 ? strtoull(argv[1], nullptr, 10) : 20000000;
+    const unsigned max_threads =
+        argc > 2 ? std::max(1, atoi(argv[2])) : std::max(1u, std::thread::hardware_concurrency());
+    const char* csv_path = argc > 3 ? argv[3] : "groupby.csv";
+    const size_t spill_groups = argc > 4 ? strtoull(argv[4], nullptr, 10) : 1 << 14;
+
+    BenchResults results("groupbench");
+    g_results = &results;
+    FILE* csv = fopen(csv_path, "w");
+    if (!csv)
+        fprintf(stderr, "cannot write %s, printing only\n", csv_path);
+    else
+        fprintf(csv, "cardinality,variant,threads,rows,groups,seconds,mrows_s,speedup,spilled\n");
+
+    std::vector<unsigned> thread_counts;
+    for (unsigned t = 1; t < max_threads; t *= 2)
+        thread_counts.push_back(t);
+    thread_counts.push_back(max_threads);
+
+    const struct {
+        const char* name;
+        uint64_t groups;
+    } cardinalities[] = {{"low", 100}, {"medium", 100000}, {"high", std::max<uint64_t>(1, rows / 2)}};
+
+    printf("%zu rows, spill at %zu groups\n", rows, spill_groups);
+    printf("%-7s %-14s %3s %10s %9s %9s %8s %10s\n", "groups", "variant", "thr", "groups", "seconds", "Mrows/s",
+           "speedup", "spilled");
+    for (const auto& card : cardinalities) {
+        std::mt19937_64 rng(card.groups);
+        std::vector<uint64_t> keys(rows);
+        std::vector<int64_t> values(rows);
+        for (size_t i = 0; i < rows; i++) {
+            keys[i] = (rng() % card.groups) * 0x9E3779B97F4A7C15ull; // spread ids over 64 bits
+            values[i] = static_cast<int64_t>(rng() % 1000);
+        }
+
+        const auto base = serial(keys, values);
+        report(csv, card.name, "serial", 1, rows, base, base, 0);
+        for (const auto threads : thread_counts) {
+            size_t spilled = 0;
+            report(csv, card.name, "merge", threads, rows, thread_merge(keys, values, threads), base, 0);
+            const auto r7 = group_by<Map7>(keys, values, threads, spill_groups, spilled);
+            report(csv, card.name, "groupby/emh7", threads, rows, r7, base, spilled);
+            const auto r8 = group_by<Map8>(keys, values, threads, spill_groups, spilled);
+            report(csv, card.name, "groupby/emh8", threads, rows, r8, base, spilled);
+        }
+    }
+
+    if (csv)
+        fclose(csv);
+    if (results.enabled() && results.write())
+        printf("results written to %s\n", results.path().c_str());
+    return 0;
+}
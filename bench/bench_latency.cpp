@@ -0,0 +1,152 @@
+// Per-operation latency percentiles of emhash5-8 and emilib1-4, with JSON export.
+//
+// Build:
+//   g++ -std=c++17 -O2 -march=native -Iinclude -Ibench bench/bench_latency.cpp -o latbench
+// Run:
+//   ./latbench [keys=4000000] [batch=16] [latency.json] [interval_ns=0]
+//
+// Phases per map: insert (no reserve, so rehash pauses land in the tail), find_hit,
+// find_miss, churn (erase one key, insert a new one: tombstones and chain reshuffles at a
+// steady size) and erase. Operations are timed in batches by latency::BatchSampler; the
+// columns left of '|' are measured, the right ones corrected for coordinated omission
+// against interval_ns, the time between requests of an open-loop client. The default is
+// each phase's median op time, i.e. a client running the map at full load, where every
+// pause (a rehash, or the OS taking the core) delays a long queue of requests; pass the
+// interval of your target rate for a realistic tail. Open tsl_bench/latency.html and load
+// the JSON file to plot the curves. With EMH_JSON=<path> the mean and the measured p99 and
+// p99.9 of each phase are also recorded for bench_compare (ops insert, insert_p99, ...).
+
+#include "bench_result.h"
+#include "latency.h"
+
+#include "emhash/hash_table5.hpp"
+#include "emhash/hash_table6.hpp"
+#include "emhash/hash_table7.hpp"
+#include "emhash/hash_table8.hpp"
+#include "emilib/emihmap1.hpp"
+#include "emilib/emihmap2.hpp"
+#include "emilib/emihmap3.hpp"
+#include "emilib/emihmap4.hpp"
+
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace {
+
+double g_ticks_per_ns = 1.0;
+uint32_t g_batch = 16;
+uint64_t g_interval = 0; // expected ticks between requests, 0: median op time
+uint64_t g_sink = 0;
+std::vector<latency::Series> g_series;
+BenchResults* g_results = nullptr;
+
+void report(const char* name, const char* op, size_t keys, const latency::BatchSampler& sampler) {
+    latency::Series series{std::string("latency_") + op, name, sampler.histogram(g_interval),
+                           sampler.histogram(g_interval, false)};
+    const auto& raw = series.raw;
+    const auto& hist = series.hist;
+    const auto ns = [](uint64_t ticks) { return static_cast<double>(ticks) / g_ticks_per_ns; };
+    printf("%-8s %-9s %8.1f %6.1f %6.1f %7.1f %8.1f %9.1f %10.1f | %9.1f %9.1f %10.1f\n", name, op,
+           raw.mean() / g_ticks_per_ns, ns(raw.percentile(50)), ns(raw.percentile(90)), ns(raw.percentile(99)),
+           ns(raw.percentile(99.9)), ns(raw.percentile(99.99)), ns(raw.max()), ns(hist.percentile(99)),
+           ns(hist.percentile(99.9)), ns(hist.percentile(99.99)));
+    g_results->add(name, op, keys, "uint64_t", "uint64_t", raw.mean() / g_ticks_per_ns);
+    g_results->add(name, std::string(op) + "_p99", keys, "uint64_t", "uint64_t", ns(raw.percentile(99)));
+    g_results->add(name, std::string(op) + "_p99.9", keys, "uint64_t", "uint64_t", ns(raw.percentile(99.9)));
+    g_series.push_back(std::move(series));
+}
+
+template <typename Map>
+void run(const char* name, const std::vector<uint64_t>& keys, const std::vector<uint64_t>& miss) {
+    latency::BatchSampler sampler(g_batch, keys.size());
+    Map map;
+    uint64_t sum = 0;
+
+    sampler.begin();
+    for (const auto key : keys) {
+        (void)map.emplace(key, key);
+        sampler.tick();
+    }
+    sampler.end();
+    report(name, "insert", keys.size(), sampler);
+
+    sampler.begin();
+    for (const auto key : keys) {
+        sum += map.find(key)->second;
+        sampler.tick();
+    }
+    sampler.end();
+    report(name, "find_hit", keys.size(), sampler);
+
+    sampler.begin();
+    for (const auto key : miss) {
+        sum += map.find(key) != map.end();
+        sampler.tick();
+    }
+    sampler.end();
+    report(name, "find_miss", keys.size(), sampler);
+
+    sampler.begin();
+    for (size_t i = 0; i < keys.size(); i++) {
+        sum += map.erase(keys[i]);
+        (void)map.emplace(miss[i], i);
+        sampler.tick();
+    }
+    sampler.end();
+    report(name, "churn", keys.size(), sampler);
+
+    sampler.begin();
+    for (const auto key : miss) {
+        sum += map.erase(key);
+        sampler.tick();
+    }
+    sampler.end();
+    report(name, "erase", keys.size(), sampler);
+    g_sink += sum + map.size();
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    const size_t num = argc > 1 ? strtoull(argv[1], nullptr, 10) : 4000000;
+    g_batch = argc > 2 ? static_cast<uint32_t>(std::max(1, atoi(argv[2]))) : 16;
+    const char* json = argc > 3 ? argv[3] : "latency.json";
+
+    BenchResults results("latbench");
+    g_results = &results;
+    std::mt19937_64 rng(20260603);
+    std::vector<uint64_t> keys(num), miss(num);
+    for (auto& key : keys)
+        key = rng();
+    for (auto& key : miss)
+        key = rng();
+
+    g_ticks_per_ns = trace::ticks_per_ns();
+    g_interval = static_cast<uint64_t>((argc > 4 ? atof(argv[4]) : 0.0) * g_ticks_per_ns);
+    printf("%zu keys, batches of %u ops, clock %.2f ticks/ns, expected interval %s\n", num, g_batch,
+           g_ticks_per_ns, g_interval ? argv[4] : "median");
+    printf("%-8s %-9s %8s %6s %6s %7s %8s %9s %10s | %9s %9s %10s  (ns)\n", "map", "op", "mean", "p50", "p90", "p99",
+           "p99.9", "p99.99", "max", "cor p99", "cor p99.9", "cor p99.99");
+
+    run<emhash5::HashMap<uint64_t, uint64_t>>("emhash5", keys, miss);
+    run<emhash6::HashMap<uint64_t, uint64_t>>("emhash6", keys, miss);
+    run<emhash7::HashMap<uint64_t, uint64_t>>("emhash7", keys, miss);
+    run<emhash8::HashMap<uint64_t, uint64_t>>("emhash8", keys, miss);
+    run<emilib::HashMap<uint64_t, uint64_t>>("emilib1", keys, miss);
+    run<emilib2::HashMap<uint64_t, uint64_t>>("emilib2", keys, miss);
+    run<emilib3::HashMap<uint64_t, uint64_t>>("emilib3", keys, miss);
+    run<emilib4::HashMap<uint64_t, uint64_t>>("emilib4", keys, miss);
+
+    if (!latency::write_chart_json(json, g_series, g_ticks_per_ns)) {
+        fprintf(stderr, "cannot write %s\n", json);
+        return 1;
+    }
+    printf("percentiles written to %s (sink %llu)\n", json, static_cast<unsigned long long>(g_sink));
+    if (results.enabled() && results.write())
+        printf("results written to %s\n", results.path().c_str());
+    return 0;
+}
@@ -0,0 +1,216 @@
+// Memory footprint: bytes per element against load factor for every map, set and LRU cache,
+// from their memory_usage() breakdown.
+//
+// Build:
+//   g++ -std=c++17 -O2 -Iinclude bench/bench_memory.cpp -o membench
+// Run:
+//   ./membench [keys=1048576] [memory.csv] [memory.json]
+//
+// Each container grows one uint64_t key (maps: uint64_t -> uint64_t) at a time from empty to
+// `keys` and is sampled about 1% of the size apart. The CSV has one row per sample with the
+// full breakdown; the JSON holds the bytes-per-element curves over load factor in the
+// chart_data layout of the tsl_bench pages (open tsl_bench/memory.html and load it). The
+// table shows, per container, the payload size and bytes per element right after a rehash
+// (lowest load factor), averaged over all samples and at the fullest point, and the
+// breakdown at the last sample. With EMH_JSON=<path> the three bytes-per-element figures are
+// also recorded for bench_compare as ops bytes_low, bytes_avg and bytes_high, in the ns_op
+// field: more bytes is worse, so a growth is flagged like a slowdown.
+
+#include "bench_result.h"
+
+#include "emhash/hash_set2.hpp"
+#include "emhash/hash_set3.hpp"
+#include "emhash/hash_set4.hpp"
+#include "emhash/hash_set8.hpp"
+#include "emhash/hash_table5.hpp"
+#include "emhash/hash_table6.hpp"
+#include "emhash/hash_table7.hpp"
+#include "emhash/hash_table8.hpp"
+#include "emhash/lru_size.hpp"
+#include "emhash/lru_time.hpp"
+#include "emilib/emihmap1.hpp"
+#include "emilib/emihmap2.hpp"
+#include "emilib/emihmap3.hpp"
+#include "emilib/emihmap4.hpp"
+#include "emilib/emihset2.hpp"
+#include "emilib/emihset3.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace {
+
+struct Sample {
+    size_t size;
+    size_t buckets;
+    emhash::MemoryUsage usage;
+
+    double load_factor() const { return buckets ? static_cast<double>(size) / static_cast<double>(buckets) : 0.0; }
+    double per_element() const { return static_cast<double>(usage.total()) / static_cast<double>(size); }
+};
+
+struct Curve {
+    std::string name;
+    size_t payload;
+    std::vector<Sample> samples;
+};
+
+std::vector<Curve> g_curves;
+BenchResults* g_results = nullptr;
+
+template <typename C> Sample sample(const C& c) {
+    return {static_cast<size_t>(c.size()), static_cast<size_t>(c.bucket_count()), c.memory_usage()};
+}
+
+template <typename C> void add(C& c, uint64_t key, std::true_type) { c.insert(key); }
+template <typename C> void add(C& c, uint64_t key, std::false_type) { c.insert({key, key}); }
+
+template <typename C, bool IsSet> void run(const char* name, C c, const std::vector<uint64_t>& keys) {
+    Curve curve{name, IsSet ? sizeof(uint64_t) : 2 * sizeof(uint64_t), {}};
+    size_t next = 64;
+    for (const auto key : keys) {
+        add(c, key, std::integral_constant<bool, IsSet>());
+        if (static_cast<size_t>(c.size()) >= next) {
+            curve.samples.push_back(sample(c));
+            next = std::max(next + 1, next + next / 100);
+        }
+    }
+    if (curve.samples.empty() || curve.samples.back().size != static_cast<size_t>(c.size()))
+        curve.samples.push_back(sample(c));
+
+    double low = 0, sum = 0, high = 0, min_lf = 1e30, max_lf = 0;
+    for (const auto& s : curve.samples) {
+        sum += s.per_element();
+        if (s.load_factor() < min_lf) {
+            min_lf = s.load_factor();
+            low = s.per_element();
+        }
+        if (s.load_factor() > max_lf) {
+            max_lf = s.load_factor();
+            high = s.per_element();
+        }
+    }
+    const auto& last = curve.samples.back();
+    const auto& u = last.usage;
+    printf("%-10s %4zu %5.2f %7.1f %7.1f %5.2f %7.1f  %9zu %7.1f%% %7.1f%% %7.1f%% %7.1f%% %7.1f%%\n", name,
+           curve.payload, min_lf, low, sum / static_cast<double>(curve.samples.size()), max_lf, high, last.size,
+           100.0 * static_cast<double>(u.entries) / static_cast<double>(u.total()),
+           100.0 * static_cast<double>(u.metadata) / static_cast<double>(u.total()),
+           100.0 * static_cast<double>(u.index) / static_cast<double>(u.total()),
+           100.0 * static_cast<double>(u.padding) / static_cast<double>(u.total()),
+           100.0 * static_cast<double>(u.slack) / static_cast<double>(u.total()));
+    const char* value = curve.payload == sizeof(uint64_t) ? "void" : "uint64_t";
+    g_results->add(name, "bytes_low", keys.size(), "uint64_t", value, low);
+    g_results->add(name, "bytes_avg", keys.size(), "uint64_t", value, sum / static_cast<double>(curve.samples.size()));
+    g_results->add(name, "bytes_high", keys.size(), "uint64_t", value, high);
+    g_curves.push_back(std::move(curve));
+}
+
+template <typename Map> void run_map(const char* name, const std::vector<uint64_t>& keys) {
+    run<Map, false>(name, Map(), keys);
+}
+
+template <typename Set> void run_set(const char* name, const std::vector<uint64_t>& keys) {
+    run<Set, true>(name, Set(), keys);
+}
+
+bool write_csv(const char* path) {
+    FILE* fp = fopen(path, "w");
+    if (!fp)
+        return false;
+    fprintf(fp, "container,payload,size,buckets,load_factor,bytes,bytes_per_element,entries,metadata,index,padding,"
+                "slack\n");
+    for (const auto& curve : g_curves) {
+        for (const auto& s : curve.samples) {
+            fprintf(fp, "%s,%zu,%zu,%zu,%.4f,%zu,%.2f,%zu,%zu,%zu,%zu,%zu\n", curve.name.c_str(), curve.payload, s.size,
+                    s.buckets, s.load_factor(), s.usage.total(), s.per_element(), s.usage.entries, s.usage.metadata,
+                    s.usage.index, s.usage.padding, s.usage.slack);
+        }
+    }
+    return fclose(fp) == 0;
+}
+
+// {"memory_maps": [{"program": p, "label": p, "data": [[load_factor, bytes], ...]}, ...],
+//  "memory_sets": [...]}, points sorted by load factor.
+bool write_json(const char* path) {
+    FILE* fp = fopen(path, "w");
+    if (!fp)
+        return false;
+    fprintf(fp, "{");
+    const char* charts[] = {"memory_maps", "memory_sets"};
+    for (int set = 0; set < 2; set++) {
+        fprintf(fp, "%s\n  \"%s\": [", set ? "," : "", charts[set]);
+        bool first = true;
+        for (const auto& curve : g_curves) {
+            if ((curve.payload == sizeof(uint64_t)) != (set == 1))
+                continue;
+            auto samples = curve.samples;
+            std::sort(samples.begin(), samples.end(),
+                      [](const Sample& a, const Sample& b) { return a.load_factor() < b.load_factor(); });
+            fprintf(fp, "%s\n    {\"program\": \"%s\", \"label\": \"%s\", \"data\": [", first ? "" : ",",
+                    curve.name.c_str(), curve.name.c_str());
+            for (size_t i = 0; i < samples.size(); i++)
+                fprintf(fp, "%s[%.4f, %.2f]", i ? ", " : "", samples[i].load_factor(), samples[i].per_element());
+            fprintf(fp, "]}");
+            first = false;
+        }
+        fprintf(fp, "\n  ]");
+    }
+    fprintf(fp, "\n}\n");
+    return fclose(fp) == 0;
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    const size_t num = argc > 1 ? strtoull(argv[1], nullptr, 10) : (1u << 20);
+    const char* csv = argc > 2 ? argv[2] : "memory.csv";
+    const char* json = argc > 3 ? argv[3] : "memory.json";
+
+    BenchResults results("membench");
+    g_results = &results;
+    std::mt19937_64 rng(20260605);
+    std::vector<uint64_t> keys(num);
+    for (auto& key : keys)
+        key = rng();
+
+    printf("%zu keys, bytes per element at the lowest load factor, on average and at the highest;\n"
+           "breakdown of the last sample in percent of its total\n", num);
+    printf("%-10s %4s %5s %7s %7s %5s %7s  %9s %8s %8s %8s %8s %8s\n", "container", "pay", "lf", "B/elem", "avg",
+           "lf", "B/elem", "size", "entries", "meta", "index", "padding", "slack");
+
+    using K = uint64_t;
+    run_map<emhash5::HashMap<K, K>>("emhash5", keys);
+    run_map<emhash6::HashMap<K, K>>("emhash6", keys);
+    run_map<emhash7::HashMap<K, K>>("emhash7", keys);
+    run_map<emhash8::HashMap<K, K>>("emhash8", keys);
+    run_map<emilib::HashMap<K, K>>("emilib1", keys);
+    run_map<emilib2::HashMap<K, K>>("emilib2", keys);
+    run_map<emilib3::HashMap<K, K>>("emilib3", keys);
+    run_map<emilib4::HashMap<K, K>>("emilib4", keys);
+    const auto lru_max = static_cast<uint32_t>(std::min<size_t>(1u << 30, num * 2));
+    run<emlru_size::lru_cache<K, K>, false>("lru_size", emlru_size::lru_cache<K, K>(8, lru_max), keys);
+    run<emlru_time::lru_cache<K, K>, false>("lru_time", emlru_time::lru_cache<K, K>(8, lru_max), keys);
+
+    run_set<emhash2::HashSet<K>>("set2", keys);
+    run_set<emhash3::HashSet<K>>("set3", keys);
+    run_set<emhash4::HashSet<K>>("set4", keys);
+    run_set<emhash8::HashSet<K>>("set8", keys);
+    run_set<emilib2::HashSet<K>>("emiset2", keys);
+    run_set<emilib3::HashSet<K>>("emiset3", keys);
+
+    if (!write_csv(csv) || !write_json(json)) {
+        fprintf(stderr, "cannot write %s or %s\n", csv, json);
+        return 1;
+    }
+    printf("samples written to %s, curves to %s\n", csv, json);
+    if (results.enabled() && results.write())
+        printf("results written to %s\n", results.path().c_str());
+    return 0;
+}
@@ -0,0 +1,66 @@
+// emhash8::HashMap merge_bulk() vs. merge() for a large delta merged into a base map.
+//
+// Build:
+//   g++ -std=c++17 -O2 -march=native -Iinclude bench/bench_merge.cpp -o mergebench
+// Run:
+//   ./mergebench [base=10000000] [delta=10000000] [overlap_percent=10]
+//
+// Keys are random uint64_t; overlap_percent of the delta keys are already in the base map
+// and stay in the delta after the merge. Each variant merges into a fresh copy of both maps.
+// With EMH_JSON=<path> both are also recorded for bench_compare in ns per delta key.
+
+#include "bench_result.h"
+
+#include "emhash/hash_table8.hpp"
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <vector>
+
+using Map = emhash8::HashMap<uint64_t, uint64_t>;
+
+static BenchResults* g_results = nullptr;
+
+static double now_ms() {
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+template <typename F> static void run(const char* name, const Map& base, const Map& delta, F&& merge) {
+    Map into = base, from = delta;
+    const auto t0 = now_ms();
+    merge(into, from);
+    const auto ms = now_ms() - t0;
+    printf("%-10s %9.2f ms  size %zu, left in delta %zu\n", name, ms, (size_t)into.size(), (size_t)from.size());
+    if (!delta.empty())
+        g_results->add("emhash8", name, delta.size(), "uint64_t", "uint64_t", ms * 1e6 / delta.size());
+}
+
+int main(int argc, char* argv[]) {
+    const size_t num_base = argc > 1 ? strtoull(argv[1], nullptr, 10) : 10000000;
+    const size_t num_delta = argc > 2 ? strtoull(argv[2], nullptr, 10) : 10000000;
+    const size_t overlap = argc > 3 ? strtoull(argv[3], nullptr, 10) : 10;
+
+    BenchResults results("mergebench");
+    g_results = &results;
+    std::mt19937_64 rng(20260519);
+    std::vector<uint64_t> base_keys(num_base);
+    Map base, delta;
+    for (auto& key : base_keys) {
+        key = rng();
+        base.emplace(key, 1);
+    }
+    for (size_t i = 0; i < num_delta; i++) {
+        const auto key = num_base && rng() % 100 < overlap ? base_keys[rng() % num_base] : rng();
+        delta.emplace(key, 2);
+    }
+    printf("base %zu, delta %zu, %zu%% overlap\n", (size_t)base.size(), (size_t)delta.size(), overlap);
+
+    run("merge", base, delta, [](Map& into, Map& from) { into.merge(from); });
+    run("merge_bulk", base, delta, [](Map& into, Map& from) { into.merge_bulk(from); });
+    if (results.enabled() && results.write())
+        printf("results written to %s\n", results.path().c_str());
+    return 0;
+}
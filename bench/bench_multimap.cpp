@@ -0,0 +1,119 @@
+// One-to-many index: emhash7::HashMultiMap vs. emhash7::HashMap<K, std::vector<V>> vs.
+// std::unordered_multimap.
+//
+// Build:
+//   g++ -std=c++17 -O2 -march=native -Iinclude bench/bench_multimap.cpp -o mmapbench
+// Run:
+//   ./mmapbench [values=10000000] [values_per_key=4]
+//
+// Keys are random uint64_t with on average values_per_key values each (geometric). Times
+// are for building the index, then summing every key's values through equal_range (or the
+// vector), then erasing every key. With EMH_JSON=<path> the three phases are also recorded
+// for bench_compare (op build, scan, erase) in ns per value.
+
+#include "bench_result.h"
+
+#include "emhash/hash_multimap7.hpp"
+#include "emhash/hash_table7.hpp"
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+static BenchResults* g_results = nullptr;
+
+static double now_ms() {
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+static void report(const char* name, size_t values, double build_ms, double scan_ms, double erase_ms, uint64_t sum) {
+    printf("%-16s build %9.2f ms  scan %9.2f ms  erase %9.2f ms  (sum %llu)\n", name, build_ms, scan_ms, erase_ms,
+           static_cast<unsigned long long>(sum));
+    if (values == 0)
+        return;
+    g_results->add(name, "build", values, "uint64_t", "uint64_t", build_ms * 1e6 / values);
+    g_results->add(name, "scan", values, "uint64_t", "uint64_t", scan_ms * 1e6 / values);
+    g_results->add(name, "erase", values, "uint64_t", "uint64_t", erase_ms * 1e6 / values);
+}
+
+template <typename Multi>
+static void run_multi(const char* name, const std::vector<std::pair<uint64_t, uint64_t>>& rows,
+                      const std::vector<uint64_t>& keys) {
+    auto t0 = now_ms();
+    Multi index;
+    for (const auto& row : rows)
+        index.emplace(row.first, row.second);
+    const auto build_ms = now_ms() - t0;
+
+    t0 = now_ms();
+    uint64_t sum = 0;
+    for (const auto key : keys) {
+        for (auto range = index.equal_range(key); range.first != range.second; ++range.first)
+            sum += range.first->second;
+    }
+    const auto scan_ms = now_ms() - t0;
+
+    t0 = now_ms();
+    for (const auto key : keys)
+        index.erase(key);
+    report(name, rows.size(), build_ms, scan_ms, now_ms() - t0, sum);
+}
+
+static void run_vector(const char* name, const std::vector<std::pair<uint64_t, uint64_t>>& rows,
+                       const std::vector<uint64_t>& keys) {
+    auto t0 = now_ms();
+    emhash7::HashMap<uint64_t, std::vector<uint64_t>> index;
+    for (const auto& row : rows)
+        index[row.first].push_back(row.second);
+    const auto build_ms = now_ms() - t0;
+
+    t0 = now_ms();
+    uint64_t sum = 0;
+    for (const auto key : keys) {
+        const auto it = index.find(key);
+        if (it != index.end()) {
+            for (const auto val : it->second)
+                sum += val;
+        }
+    }
+    const auto scan_ms = now_ms() - t0;
+
+    t0 = now_ms();
+    for (const auto key : keys)
+        index.erase(key);
+    report(name, rows.size(), build_ms, scan_ms, now_ms() - t0, sum);
+}
+
+int main(int argc, char* argv[]) {
+    const size_t num = argc > 1 ? strtoull(argv[1], nullptr, 10) : 10000000;
+    const double per_key = argc > 2 ? atof(argv[2]) : 4.0;
+
+    BenchResults results("mmapbench");
+    g_results = &results;
+    std::mt19937_64 rng(20260526);
+    std::geometric_distribution<int> fanout(1.0 / per_key);
+    std::vector<std::pair<uint64_t, uint64_t>> rows;
+    std::vector<uint64_t> keys;
+    rows.reserve(num);
+    while (rows.size() < num) {
+        const auto key = rng();
+        keys.push_back(key);
+        for (int i = fanout(rng); i >= 0 && rows.size() < num; i--)
+            rows.emplace_back(key, rows.size());
+    }
+    std::shuffle(rows.begin(), rows.end(), rng);
+    std::shuffle(keys.begin(), keys.end(), rng);
+    printf("%zu values under %zu keys\n", rows.size(), keys.size());
+
+    run_multi<emhash7::HashMultiMap<uint64_t, uint64_t>>("emhash7 multimap", rows, keys);
+    run_vector("emhash7 + vector", rows, keys);
+    run_multi<std::unordered_multimap<uint64_t, uint64_t>>("std multimap", rows, keys);
+    if (results.enabled() && results.write())
+        printf("results written to %s\n", results.path().c_str());
+    return 0;
+}
@@ -0,0 +1,86 @@
+// assign_parallel() vs. a serial range insert for emhash8::HashMap/HashSet and emilib2::HashSet.
+//
+// Build:
+//   g++ -std=c++17 -O2 -march=native -pthread -Iinclude bench/bench_parallel_build.cpp -o pbuildbench
+// Run:
+//   ./pbuildbench [keys=50000000] [max_threads=hardware concurrency]
+//
+// Keys are random uint64_t with about 10% duplicates. Thread counts double from 1 up to
+// max_threads; the speedup column is serial insert time / assign_parallel time. With
+// EMH_JSON=<path> every row is also recorded for bench_compare (op insert/serial,
+// assign_parallel/4t, ...) in ns per input key.
+
+#include "bench_result.h"
+
+#include "emhash/hash_set8.hpp"
+#include "emhash/hash_table8.hpp"
+#include "emilib/emihset2.hpp"
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+static BenchResults* g_results = nullptr;
+
+static double now_ms() {
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+template <typename Table, typename Input>
+static void run(const char* name, const char* value, const Input& input, unsigned max_threads) {
+    const auto record = [&](const std::string& op, double ms) {
+        if (!input.empty())
+            g_results->add(name, op, input.size(), "uint64_t", value, ms * 1e6 / input.size());
+    };
+    double serial_ms;
+    size_t serial_size;
+    {
+        Table table;
+        const auto t0 = now_ms();
+        table.insert(input.begin(), input.end());
+        serial_ms = now_ms() - t0;
+        serial_size = table.size();
+    }
+    printf("%-10s serial insert %9.2f ms  (%zu keys)\n", name, serial_ms, serial_size);
+    record("insert/serial", serial_ms);
+
+    for (unsigned threads = 1; threads <= max_threads; threads *= 2) {
+        Table table;
+        const auto t0 = now_ms();
+        table.assign_parallel(input.begin(), input.end(), threads);
+        const auto ms = now_ms() - t0;
+        printf("%-10s %2u threads    %9.2f ms  x%.2f%s\n", name, threads, ms, serial_ms / ms,
+               table.size() == serial_size ? "" : "  MISMATCH");
+        record("assign_parallel/" + std::to_string(threads) + "t", ms);
+    }
+}
+
+int main(int argc, char* argv[]) {
+    const size_t num = argc > 1 ? strtoull(argv[1], nullptr, 10) : 50000000;
+    const unsigned max_threads =
+        argc > 2 ? static_cast<unsigned>(atoi(argv[2])) : std::max(1u, std::thread::hardware_concurrency());
+
+    BenchResults results("pbuildbench");
+    g_results = &results;
+    std::mt19937_64 rng(20260505);
+    std::vector<uint64_t> keys(num);
+    for (auto& key : keys)
+        key = rng() % (num * 9);
+    std::vector<std::pair<uint64_t, uint64_t>> pairs(num);
+    for (size_t i = 0; i < num; i++)
+        pairs[i] = {keys[i], i};
+    printf("%zu keys, up to %u threads\n", num, max_threads);
+
+    run<emhash8::HashMap<uint64_t, uint64_t>>("emhash8map", "uint64_t", pairs, max_threads);
+    run<emhash8::HashSet<uint64_t>>("emhash8set", "void", keys, max_threads);
+    run<emilib2::HashSet<uint64_t>>("emilib2set", "void", keys, max_threads);
+    if (results.enabled() && results.write())
+        printf("results written to %s\n", results.path().c_str());
+    return 0;
+}
@@ -0,0 +1,119 @@
+// parallel_for_each / parallel_reduce / parallel_erase_if vs. the serial loops for emhash7
+// and emhash8 HashMap.
+//
+// Build:
+//   g++ -std=c++17 -O2 -march=native -pthread -Iinclude bench/bench_parallel_scan.cpp -o scanbench
+// Run:
+//   ./scanbench [keys=20000000] [max_threads=hardware concurrency]
+//
+// Keys are random uint64_t. for_each bumps every value, reduce sums key + value, and
+// erase_if drops a quarter of the keys (a fresh copy of the table each round). Thread counts
+// double from 1 up to max_threads; the speedup column is serial time / parallel time. With
+// EMH_JSON=<path> every row is also recorded for bench_compare (op for_each/serial,
+// for_each/4t, ...) in ns per key.
+
+#include "bench_result.h"
+
+#include "emhash/hash_table7.hpp"
+#include "emhash/hash_table8.hpp"
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <string>
+#include <thread>
+
+static BenchResults* g_results = nullptr;
+
+static double now_ms() {
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+static void report(const char* name, const char* op, size_t keys, unsigned threads, double ms, double serial_ms,
+                   bool ok) {
+    if (threads == 0)
+        printf("%-8s %-9s serial     %9.2f ms\n", name, op, ms);
+    else
+        printf("%-8s %-9s %2u threads %9.2f ms  x%.2f%s\n", name, op, threads, ms, serial_ms / ms,
+               ok ? "" : "  MISMATCH");
+    const auto variant = std::string(op) + (threads ? "/" + std::to_string(threads) + "t" : "/serial");
+    if (keys)
+        g_results->add(name, variant, keys, "uint64_t", "uint64_t", ms * 1e6 / keys);
+}
+
+template <typename Map> static void run(const char* name, const Map& input, unsigned max_threads) {
+    const auto drop = [](const auto& kv) { return (kv.first & 3) == 0; };
+
+    Map map = input;
+    auto t0 = now_ms();
+    for (auto& kv : map)
+        kv.second++;
+    const auto each_ms = now_ms() - t0;
+    report(name, "for_each", input.size(), 0, each_ms, 0, true);
+
+    t0 = now_ms();
+    uint64_t serial_sum = 0;
+    for (const auto& kv : map)
+        serial_sum += kv.first + kv.second;
+    const auto reduce_ms = now_ms() - t0;
+    report(name, "reduce", input.size(), 0, reduce_ms, 0, true);
+
+    size_t serial_left;
+    double erase_ms;
+    {
+        Map copy = input;
+        t0 = now_ms();
+        copy.erase_if(drop);
+        erase_ms = now_ms() - t0;
+        serial_left = copy.size();
+    }
+    report(name, "erase_if", input.size(), 0, erase_ms, 0, true);
+
+    // every for_each round adds size() to the sum
+    uint64_t expect_sum = serial_sum;
+    for (unsigned threads = 1; threads <= max_threads; threads *= 2) {
+        t0 = now_ms();
+        const auto sum = map.parallel_reduce(
+            uint64_t(0), [](const auto& kv) { return kv.first + kv.second; },
+            [](uint64_t a, uint64_t b) { return a + b; }, threads);
+        report(name, "reduce", input.size(), threads, now_ms() - t0, reduce_ms, sum == expect_sum);
+
+        t0 = now_ms();
+        map.parallel_for_each([](auto& kv) { kv.second++; }, threads);
+        report(name, "for_each", input.size(), threads, now_ms() - t0, each_ms, true);
+        expect_sum += map.size();
+
+        Map copy = input;
+        t0 = now_ms();
+        copy.parallel_erase_if(drop, threads);
+        report(name, "erase_if", input.size(), threads, now_ms() - t0, erase_ms, copy.size() == serial_left);
+    }
+}
+
+int main(int argc, char* argv[]) {
+    const size_t num = argc > 1 ? strtoull(argv[1], nullptr, 10) : 20000000;
+    const unsigned max_threads =
+        argc > 2 ? static_cast<unsigned>(atoi(argv[2])) : std::max(1u, std::thread::hardware_concurrency());
+
+    BenchResults results("scanbench");
+    g_results = &results;
+    std::mt19937_64 rng(20260512);
+    emhash7::HashMap<uint64_t, uint64_t> map7;
+    emhash8::HashMap<uint64_t, uint64_t> map8;
+    map7.reserve(num);
+    map8.reserve(num);
+    for (size_t i = 0; i < num; i++) {
+        const auto key = rng();
+        map7.emplace(key, i);
+        map8.emplace(key, i);
+    }
+    printf("%zu keys, up to %u threads\n", num, max_threads);
+
+    run("emhash7", map7, max_threads);
+    run("emhash8", map8, max_threads);
+    if (results.enabled() && results.write())
+        printf("results written to %s\n", results.path().c_str());
+    return 0;
+}
@@ -0,0 +1,195 @@
+// Hash join: one shared table against emhash_join::RadixJoin, at build sizes from L2-resident
+// to far beyond the LLC and at 1..N threads.
+//
+// Build:
+//   g++ -std=c++17 -O2 -march=native -pthread -Iinclude bench/bench_radix_join.cpp -o joinbench
+// Run:
+//   ./joinbench [max_build=16000000] [threads=hardware] [join.csv] [match%=50]
+//
+// Build sizes go up by 4x from 16k rows to max_build; the probe side has as many rows as the
+// build side, with about match% of its keys present there (build keys repeat ~1.25 times, so
+// inner joins also walk duplicate chains). Rows are (uint64_t key, uint32_t row id).
+//
+//   shared    the approach of hash_join.cpp / hash_join2.cpp: one key -> row table built
+//             serially, probe rows split across the threads, every probe a random access
+//             into the whole table
+//   radix     RadixJoin: both sides partitioned, one table per partition, built and probed
+//             on the worker threads with batched lookups
+//
+// Each line reports build and probe time and the probe rate; the joins count matches per
+// thread and the counts must agree between all variants. With EMH_JSON=<path> build and
+// probe are also recorded as ns per row (map: variant/map, op: build|probe/threads).
+
+#include "bench_result.h"
+
+#include "emhash/hash_join.hpp"
+#include "emhash/hash_table8.hpp"
+#include "emilib/emihmap2.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace {
+
+using Row = std::pair<uint64_t, uint32_t>;
+
+uint64_t g_sink = 0;
+BenchResults* g_results = nullptr;
+
+double now_s() {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+struct Result {
+    double build_s;
+    double probe_s;
+    size_t matches;
+};
+
+template <typename F> void run_threads(unsigned num_threads, F&& fn) {
+    std::vector<std::thread> workers;
+    for (unsigned t = 1; t < num_threads; t++)
+        workers.emplace_back(fn, t);
+    fn(0u);
+    for (auto& worker : workers)
+        worker.join();
+}
+
+// One table over the whole build side; duplicate keys chain through next[] like RadixJoin.
+template <typename Map> Result shared_join(const std::vector<Row>& build, const std::vector<Row>& probe,
+                                           unsigned threads) {
+    const auto t0 = now_s();
+    Map table;
+    table.reserve(static_cast<decltype(table.size())>(build.size()));
+    std::vector<uint32_t> next(build.size(), UINT32_MAX);
+    for (uint32_t i = 0; i < build.size(); i++) {
+        const auto result = table.emplace(build[i].first, i);
+        if (!result.second) {
+            next[i] = result.first->second;
+            result.first->second = i;
+        }
+    }
+    const auto t1 = now_s();
+
+    std::vector<size_t> counts(threads, 0), payloads(threads, 0);
+    const auto chunk = (probe.size() + threads - 1) / threads;
+    run_threads(threads, [&](unsigned t) {
+        size_t count = 0, payload = 0;
+        for (auto i = std::min(probe.size(), t * chunk), end = std::min(probe.size(), (t + 1) * chunk); i < end;
+             i++) {
+            const auto it = table.find(probe[i].first);
+            if (it == table.end())
+                continue;
+            for (auto h = it->second; h != UINT32_MAX; h = next[h], count++)
+                payload += build[h].second;
+        }
+        counts[t] = count;
+        payloads[t] = payload;
+    });
+    const auto t2 = now_s();
+
+    size_t matches = 0;
+    for (unsigned t = 0; t < threads; t++) {
+        matches += counts[t];
+        g_sink += payloads[t];
+    }
+    return {t1 - t0, t2 - t1, matches};
+}
+
+template <typename Map> Result radix_join(const std::vector<Row>& build, const std::vector<Row>& probe,
+                                          unsigned threads) {
+    emhash_join::JoinOptions options;
+    options.threads = threads;
+    emhash_join::RadixJoin<uint64_t, uint32_t, uint32_t, Map> join(options);
+
+    const auto t0 = now_s();
+    join.build(build);
+    const auto t1 = now_s();
+    std::vector<size_t> payloads(threads, 0);
+    const auto matches = join.inner(probe, [&](const Row& b, const Row&, unsigned t) { payloads[t] += b.second; });
+    const auto t2 = now_s();
+    for (const auto payload : payloads)
+        g_sink += payload;
+    return {t1 - t0, t2 - t1, matches};
+}
+
+void report(FILE* csv, const char* variant, const char* map, size_t rows, unsigned threads, const Result& r,
+            size_t expected) {
+    const auto mrows = static_cast<double>(rows) / 1e6;
+    printf("%-7s %-8s %10zu %3u %9.3f %9.3f %9.1f %s\n", variant, map, rows, threads, r.build_s, r.probe_s,
+           mrows / r.probe_s, r.matches == expected ? "" : "MISMATCH");
+    if (csv) {
+        fprintf(csv, "%s,%s,%zu,%u,%.4f,%.4f,%.2f,%zu\n", variant, map, rows, threads, r.build_s, r.probe_s,
+                mrows / r.probe_s, r.matches);
+        fflush(csv);
+    }
+    const auto name = std::string(variant) + "/" + map, suffix = "/" + std::to_string(threads) + "t";
+    g_results->add(name, "build" + suffix, rows, "uint64_t", "uint32_t", r.build_s * 1e9 / static_cast<double>(rows));
+    g_results->add(name, "probe" + suffix, rows, "uint64_t", "uint32_t", r.probe_s * 1e9 / static_cast<double>(rows));
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    const size_t max_build = argc > 1 ? strtoull(argv[1], nullptr, 10) : 16000000;
+    const unsigned max_threads =
+        argc > 2 ? std::max(1, atoi(argv[2])) : std::max(1u, std::thread::hardware_concurrency());
+    const char* csv_path = argc > 3 ? argv[3] : "join.csv";
+    const unsigned match = argc > 4 ? static_cast<unsigned>(std::min(100, std::max(0, atoi(argv[4])))) : 50;
+
+    BenchResults results("joinbench");
+    g_results = &results;
+    FILE* csv = fopen(csv_path, "w");
+    if (!csv)
+        fprintf(stderr, "cannot write %s, printing only\n", csv_path);
+    else
+        fprintf(csv, "variant,map,build_rows,threads,build_s,probe_s,probe_mrows_s,matches\n");
+
+    std::vector<unsigned> thread_counts;
+    for (unsigned t = 1; t < max_threads; t *= 2)
+        thread_counts.push_back(t);
+    thread_counts.push_back(max_threads);
+
+    printf("%-7s %-8s %10s %3s %9s %9s %9s\n", "variant", "map", "rows", "thr", "build s", "probe s", "Mrows/s");
+    for (size_t rows = 16 << 10; rows <= max_build; rows *= 4) {
+        std::mt19937_64 rng(rows);
+        const auto distinct = rows * 4 / 5;
+        std::vector<uint64_t> keys(distinct);
+        for (auto& key : keys)
+            key = rng();
+
+        std::vector<Row> build(rows), probe(rows);
+        for (size_t i = 0; i < rows; i++)
+            build[i] = {keys[i < distinct ? i : rng() % distinct], static_cast<uint32_t>(i)};
+        for (size_t i = 0; i < rows; i++)
+            probe[i] = {rng() % 100 < match ? keys[rng() % distinct] : rng(), static_cast<uint32_t>(i)};
+        std::shuffle(build.begin(), build.end(), rng);
+
+        const auto expected = shared_join<emhash8::HashMap<uint64_t, uint32_t>>(build, probe, 1).matches;
+        for (const auto threads : thread_counts) {
+            report(csv, "shared", "emhash8", rows, threads,
+                   shared_join<emhash8::HashMap<uint64_t, uint32_t>>(build, probe, threads), expected);
+            report(csv, "shared", "emilib2", rows, threads,
+                   shared_join<emilib2::HashMap<uint64_t, uint32_t>>(build, probe, threads), expected);
+            report(csv, "radix", "emhash8", rows, threads,
+                   radix_join<emhash8::HashMap<uint64_t, uint32_t>>(build, probe, threads), expected);
+            report(csv, "radix", "emilib2", rows, threads,
+                   radix_join<emilib2::HashMap<uint64_t, uint32_t>>(build, probe, threads), expected);
+        }
+    }
+
+    if (csv)
+        fclose(csv);
+    if (results.enabled() && results.write())
+        printf("results written to %s\n", results.path().c_str());
+    printf("sink %llu\n", static_cast<unsigned long long>(g_sink));
+    return 0;
+}
@@ -0,0 +1,301 @@
+// Concurrent readers: find throughput of emhash5-8 and emilib1-4 from 1..N pinned threads,
+// with the table placed on one NUMA node, interleaved over all nodes, or replicated per node.
+//
+// Build:
+//   g++ -std=c++17 -O2 -march=native -pthread -Iinclude bench/bench_read_scaling.cpp -o readbench
+// Run:
+//   ./readbench [keys=4000000] [max_threads=all cpus] [seconds=1] [hit_percent=90] [map filter]
+//
+// Each map is built once per placement by a thread pinned to the target node (first touch
+// puts the pages there; "interleave" builds under MPOL_INTERLEAVE), then reader threads
+// pinned to cpus in node order (node 0's cpus first) look up their own random mix of hits
+// and misses until the time is up. Per thread count it prints aggregate Mops/s, the slowest
+// and fastest thread and their ratio (fairness, 1.00 = even), and for the node0 placement
+// the mean per-thread rate of readers on node 0 (local) and on other nodes (remote).
+// Topology comes from /sys/devices/system/node; without it, or on one node, only the node0
+// placement runs. With EMH_JSON=<path> every point is also recorded for bench_compare as op
+// find/<placement>/<threads>t, in wall ns per lookup over all threads.
+
+#include "bench_result.h"
+
+#include "emhash/hash_table5.hpp"
+#include "emhash/hash_table6.hpp"
+#include "emhash/hash_table7.hpp"
+#include "emhash/hash_table8.hpp"
+#include "emilib/emihmap1.hpp"
+#include "emilib/emihmap2.hpp"
+#include "emilib/emihmap3.hpp"
+#include "emilib/emihmap4.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <memory>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+#if defined(__linux__)
+#include <linux/mempolicy.h>
+#include <pthread.h>
+#include <sched.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+namespace {
+
+struct Cpu {
+    int id;
+    int node;
+};
+
+// "0-3,8-11" -> {0, 1, 2, 3, 8, 9, 10, 11}
+std::vector<int> parse_cpulist(const std::string& list) {
+    std::vector<int> cpus;
+    size_t pos = 0;
+    while (pos < list.size()) {
+        char* end = nullptr;
+        const long first = strtol(list.c_str() + pos, &end, 10);
+        if (end == list.c_str() + pos)
+            break;
+        long last = first;
+        if (*end == '-')
+            last = strtol(end + 1, &end, 10);
+        for (long cpu = first; cpu <= last; cpu++)
+            cpus.push_back(static_cast<int>(cpu));
+        pos = static_cast<size_t>(end - list.c_str()) + 1;
+    }
+    return cpus;
+}
+
+// cpus ordered by node, then id
+std::vector<Cpu> topology(int& num_nodes) {
+    std::vector<Cpu> cpus;
+    num_nodes = 0;
+    for (int node = 0; node < 64; node++) {
+        std::ifstream in("/sys/devices/system/node/node" + std::to_string(node) + "/cpulist");
+        std::string list;
+        if (!in || !std::getline(in, list))
+            continue;
+        const auto ids = parse_cpulist(list);
+        if (ids.empty())
+            continue;
+        for (const auto id : ids)
+            cpus.push_back({id, node});
+        num_nodes = node + 1;
+    }
+    if (cpus.empty()) {
+        num_nodes = 1;
+        for (unsigned id = 0; id < std::max(1u, std::thread::hardware_concurrency()); id++)
+            cpus.push_back({static_cast<int>(id), 0});
+    }
+    return cpus;
+}
+
+void pin(int cpu) {
+#if defined(__linux__)
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(cpu, &set);
+    pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+#else
+    (void)cpu;
+#endif
+}
+
+// Interleave the calling thread's new pages over all nodes (on) or back to the default.
+void interleave(bool on, int num_nodes) {
+#if defined(__linux__)
+    unsigned long mask = num_nodes >= 64 ? ~0ul : (1ul << num_nodes) - 1;
+    if (on)
+        syscall(SYS_set_mempolicy, MPOL_INTERLEAVE, &mask, sizeof(mask) * 8);
+    else
+        syscall(SYS_set_mempolicy, MPOL_DEFAULT, nullptr, 0);
+#else
+    (void)on;
+    (void)num_nodes;
+#endif
+}
+
+enum Placement { NODE0, INTERLEAVE, REPLICATE };
+const char* const PLACEMENT_NAMES[] = {"node0", "interleave", "replicate"};
+
+struct Options {
+    std::vector<Cpu> cpus;
+    int num_nodes = 1;
+    unsigned max_threads = 1;
+    double seconds = 1;
+    unsigned hit_percent = 90;
+};
+
+uint64_t g_sink = 0;
+BenchResults* g_results = nullptr;
+
+// Builds the map on a thread pinned to `node`'s first cpu (first touch) or interleaved.
+template <typename Map>
+std::unique_ptr<Map> build(const std::vector<uint64_t>& keys, const Options& opt, int node, bool interleaved) {
+    std::unique_ptr<Map> map;
+    std::thread builder([&] {
+        for (const auto& cpu : opt.cpus) {
+            if (cpu.node == node) {
+                pin(cpu.id);
+                break;
+            }
+        }
+        if (interleaved)
+            interleave(true, opt.num_nodes);
+        map.reset(new Map());
+        for (const auto key : keys)
+            (void)map->emplace(key, key);
+        if (interleaved)
+            interleave(false, opt.num_nodes);
+    });
+    builder.join();
+    return map;
+}
+
+template <typename Map>
+void read_threads(const char* name, Placement placement, const std::vector<const Map*>& per_node,
+                  const std::vector<uint64_t>& keys, unsigned threads, const Options& opt) {
+    constexpr size_t PROBES = 1 << 18, CHUNK = 1024;
+    std::atomic<unsigned> ready{0};
+    std::atomic<bool> go{false}, stop{false};
+    std::vector<uint64_t> ops(threads), found(threads);
+    std::vector<std::thread> pool;
+
+    for (unsigned t = 0; t < threads; t++) {
+        pool.emplace_back([&, t] {
+            const auto& cpu = opt.cpus[t % opt.cpus.size()];
+            pin(cpu.id);
+            const Map& map = *per_node[placement == REPLICATE ? cpu.node : 0];
+
+            // probes live on the reader's node: random hits, the rest misses
+            std::vector<uint64_t> probes(PROBES);
+            std::mt19937_64 rng(t + 1);
+            for (auto& probe : probes)
+                probe = rng() % 100 < opt.hit_percent ? keys[rng() % keys.size()] : rng();
+
+            ready++;
+            while (!go.load(std::memory_order_acquire))
+                ;
+            uint64_t count = 0, hits = 0;
+            size_t pos = 0;
+            while (!stop.load(std::memory_order_relaxed)) {
+                for (size_t i = 0; i < CHUNK; i++, pos = (pos + 1) & (PROBES - 1))
+                    hits += map.find(probes[pos]) != map.end();
+                count += CHUNK;
+            }
+            ops[t] = count;
+            found[t] = hits;
+        });
+    }
+
+    while (ready.load() < threads)
+        std::this_thread::yield();
+    const auto start = std::chrono::steady_clock::now();
+    go.store(true, std::memory_order_release);
+    std::this_thread::sleep_for(std::chrono::duration<double>(opt.seconds));
+    stop.store(true);
+    for (auto& thread : pool)
+        thread.join();
+    const double secs = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    uint64_t total = 0, slowest = UINT64_MAX, fastest = 0;
+    double local = 0, remote = 0;
+    unsigned num_local = 0, num_remote = 0;
+    for (unsigned t = 0; t < threads; t++) {
+        total += ops[t];
+        slowest = std::min(slowest, ops[t]);
+        fastest = std::max(fastest, ops[t]);
+        g_sink += found[t];
+        if (opt.cpus[t % opt.cpus.size()].node == 0) {
+            local += static_cast<double>(ops[t]);
+            num_local++;
+        } else {
+            remote += static_cast<double>(ops[t]);
+            num_remote++;
+        }
+    }
+
+    const auto mops = [secs](double count) { return count / secs / 1e6; };
+    printf("%-8s %-10s %3u threads %9.2f Mops/s  thread min %7.2f max %7.2f fair %.2f", name,
+           PLACEMENT_NAMES[placement], threads, mops(static_cast<double>(total)), mops(static_cast<double>(slowest)),
+           mops(static_cast<double>(fastest)), fastest ? static_cast<double>(slowest) / fastest : 0.0);
+    if (placement == NODE0 && num_remote > 0)
+        printf("  local %7.2f remote %7.2f", mops(local / num_local), mops(remote / num_remote));
+    printf("\n");
+    const auto op = std::string("find/") + PLACEMENT_NAMES[placement] + "/" + std::to_string(threads) + "t";
+    g_results->add(name, op, keys.size(), "uint64_t", "uint64_t", total ? secs * 1e9 / total : 0.0);
+}
+
+template <typename Map>
+void run(const char* name, const char* filter, const std::vector<uint64_t>& keys, const Options& opt) {
+    if (filter && !strstr(name, filter))
+        return;
+
+    std::vector<unsigned> counts;
+    for (unsigned threads = 1; threads < opt.max_threads; threads *= 2)
+        counts.push_back(threads);
+    counts.push_back(opt.max_threads);
+
+    const int placements = opt.num_nodes > 1 ? 3 : 1;
+    for (int p = 0; p < placements; p++) {
+        const auto placement = static_cast<Placement>(p);
+        std::vector<std::unique_ptr<Map>> maps;
+        if (placement == REPLICATE) {
+            for (int node = 0; node < opt.num_nodes; node++)
+                maps.push_back(build<Map>(keys, opt, node, false));
+        } else {
+            maps.push_back(build<Map>(keys, opt, 0, placement == INTERLEAVE));
+        }
+        std::vector<const Map*> per_node;
+        for (const auto& map : maps)
+            per_node.push_back(map.get());
+
+        for (const auto threads : counts)
+            read_threads<Map>(name, placement, per_node, keys, threads, opt);
+    }
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    const size_t num = argc > 1 ? strtoull(argv[1], nullptr, 10) : 4000000;
+    Options opt;
+    opt.cpus = topology(opt.num_nodes);
+    opt.max_threads = argc > 2 ? static_cast<unsigned>(std::max(1, atoi(argv[2]))) : opt.cpus.size();
+    opt.seconds = argc > 3 ? atof(argv[3]) : 1.0;
+    opt.hit_percent = argc > 4 ? static_cast<unsigned>(std::min(100, atoi(argv[4]))) : 90;
+    const char* filter = argc > 5 ? argv[5] : nullptr;
+
+    BenchResults results("readbench");
+    g_results = &results;
+    std::mt19937_64 rng(20260604);
+    std::vector<uint64_t> keys(num);
+    for (auto& key : keys)
+        key = rng();
+
+    printf("%zu keys, %zu cpus on %d node(s), up to %u threads, %.1f s per point, %u%% hits\n", num,
+           opt.cpus.size(), opt.num_nodes, opt.max_threads, opt.seconds, opt.hit_percent);
+    if (opt.max_threads > opt.cpus.size())
+        printf("more threads than cpus: readers share cores\n");
+
+    run<emhash5::HashMap<uint64_t, uint64_t>>("emhash5", filter, keys, opt);
+    run<emhash6::HashMap<uint64_t, uint64_t>>("emhash6", filter, keys, opt);
+    run<emhash7::HashMap<uint64_t, uint64_t>>("emhash7", filter, keys, opt);
+    run<emhash8::HashMap<uint64_t, uint64_t>>("emhash8", filter, keys, opt);
+    run<emilib::HashMap<uint64_t, uint64_t>>("emilib1", filter, keys, opt);
+    run<emilib2::HashMap<uint64_t, uint64_t>>("emilib2", filter, keys, opt);
+    run<emilib3::HashMap<uint64_t, uint64_t>>("emilib3", filter, keys, opt);
+    run<emilib4::HashMap<uint64_t, uint64_t>>("emilib4", filter, keys, opt);
+    if (results.enabled() && results.write())
+        printf("results written to %s\n", results.path().c_str());
+    return g_sink == 42 ? 1 : 0;
+}
@@ -0,0 +1,189 @@
+// Machine-readable benchmark results, for bench_compare.
+//
+//   BenchResults results("cachebench");        // records only when EMH_JSON=<path> is set
+//   results.add("emhash8", "find_hit", keys, "uint64_t", "uint64_t", ns_per_op);
+//   results.add("emhash8", "insert", keys, "uint64_t", "uint64_t", ns_per_op, &perf_sample, ops);
+//   ...                                        // written by write() or the destructor
+//
+// The file is one JSON object: a "context" with the benchmark, emhash version, CPU model,
+// core count, compiler, build flags and ISA extensions, and a "results" array with one
+// object per measurement ({map, op, size, key, value, ns_op} plus per-op hardware
+// counters when a PerfSample is given). Run the benchmark several times into separate
+// files, or call add() once per repetition, to give bench_compare samples to test.
+//
+// Build flags come from EMH_BENCH_FLAGS (set by CMake for the bench targets); manual builds
+// record the optimization level and the ISA macros the compiler defined.
+
+#pragma once
+
+#include "perf_counters.h"
+
+#include "emhash/version.hpp"
+
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <ctime>
+#include <fstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+class BenchResults {
+public:
+    explicit BenchResults(const char* bench, const char* path = nullptr) : _bench(bench) {
+        const char* env = getenv("EMH_JSON");
+        _path = path ? path : env ? env : "";
+    }
+
+    ~BenchResults() { write(); }
+
+    BenchResults(const BenchResults&) = delete;
+    BenchResults& operator=(const BenchResults&) = delete;
+
+    bool enabled() const { return !_path.empty(); }
+    const std::string& path() const { return _path; }
+
+    /// One measurement; counters are divided by `ops` (ignored when ops is 0).
+    void add(const std::string& map, const std::string& op, uint64_t size, const std::string& key,
+             const std::string& value, double ns_op, const PerfSample* counters = nullptr, double ops = 0) {
+        if (!enabled())
+            return;
+        std::string row = "{\"map\": " + quote(map) + ", \"op\": " + quote(op) + ", \"size\": " +
+                          std::to_string(size) + ", \"key\": " + quote(key) + ", \"value\": " + quote(value) +
+                          ", \"ns_op\": " + number(ns_op);
+        if (counters && counters->any()) {
+            std::string fields;
+            for (int i = 0; i < PERF_NUM_EVENTS; i++) {
+                if (counters->valid[i])
+                    fields += std::string(fields.empty() ? "" : ", ") + quote(PERF_EVENT_NAMES[i]) + ": " +
+                              number(ops > 0 ? counters->value[i] / ops : counters->value[i]);
+            }
+            row += ", \"counters\": {" + fields + "}";
+        }
+        _rows.push_back(row + "}");
+    }
+
+    /// Writes the file (once); false when it cannot be written.
+    bool write() {
+        if (!enabled() || _written)
+            return true;
+        _written = true;
+        FILE* fp = fopen(_path.c_str(), "w");
+        if (!fp) {
+            fprintf(stderr, "cannot write results to %s\n", _path.c_str());
+            return false;
+        }
+        fprintf(fp, "{\n  \"context\": %s,\n  \"results\": [", context().c_str());
+        for (size_t i = 0; i < _rows.size(); i++)
+            fprintf(fp, "%s\n    %s", i ? "," : "", _rows[i].c_str());
+        fprintf(fp, "\n  ]\n}\n");
+        return fclose(fp) == 0;
+    }
+
+    static std::string cpu_model() {
+        std::ifstream in("/proc/cpuinfo");
+        std::string line;
+        while (std::getline(in, line)) {
+            if (line.compare(0, 10, "model name") == 0 || line.compare(0, 9, "Processor") == 0) {
+                const auto colon = line.find(':');
+                if (colon != std::string::npos)
+                    return line.substr(line.find_first_not_of(" \t", colon + 1));
+            }
+        }
+        return "unknown";
+    }
+
+    static std::string compiler() {
+#if defined(__clang__)
+        return "clang " __clang_version__;
+#elif defined(__GNUC__)
+        return "gcc " __VERSION__;
+#elif defined(_MSC_VER)
+        return "msvc " + std::to_string(_MSC_FULL_VER);
+#else
+        return "unknown";
+#endif
+    }
+
+    static std::string flags() {
+        std::string out;
+#ifdef EMH_BENCH_FLAGS
+        out = EMH_BENCH_FLAGS;
+#else
+#if defined(__OPTIMIZE_SIZE__)
+        out = "-Os";
+#elif defined(__OPTIMIZE__)
+        out = "-O";
+#else
+        out = "-O0";
+#endif
+#ifdef NDEBUG
+        out += " -DNDEBUG";
+#endif
+#endif
+        return out;
+    }
+
+    static std::string isa() {
+        std::string out;
+        const auto add = [&out](const char* name) { out += std::string(out.empty() ? "" : " ") + name; };
+#ifdef __SSE4_2__
+        add("sse4.2");
+#endif
+#ifdef __AVX2__
+        add("avx2");
+#endif
+#ifdef __AVX512F__
+        add("avx512f");
+#endif
+#ifdef __BMI2__
+        add("bmi2");
+#endif
+#ifdef __ARM_NEON
+        add("neon");
+#endif
+        (void)add;
+        return out;
+    }
+
+private:
+    static std::string quote(const std::string& text) {
+        std::string out = "\"";
+        for (const char c : text) {
+            if (c == '"' || c == '\\') {
+                out += '\\';
+                out += c;
+            } else if (static_cast<unsigned char>(c) < 0x20) {
+                char buf[8];
+                snprintf(buf, sizeof(buf), "\\u%04x", c);
+                out += buf;
+            } else
+                out += c;
+        }
+        return out + "\"";
+    }
+
+    static std::string number(double value) {
+        char buf[32];
+        snprintf(buf, sizeof(buf), "%.6g", value);
+        return buf;
+    }
+
+    std::string context() const {
+        char date[32] = "";
+        const auto now = time(nullptr);
+        if (const auto* tm = gmtime(&now))
+            strftime(date, sizeof(date), "%Y-%m-%dT%H:%M:%SZ", tm);
+        return "{\"bench\": " + quote(_bench) + ", \"emhash\": " + quote(EMHASH_VERSION_STRING) +
+               ", \"date\": " + quote(date) + ", \"cpu\": " + quote(cpu_model()) +
+               ", \"cores\": " + std::to_string(std::thread::hardware_concurrency()) +
+               ", \"compiler\": " + quote(compiler()) + ", \"flags\": " + quote(flags()) +
+               ", \"isa\": " + quote(isa()) + "}";
+    }
+
+    std::string _bench;
+    std::string _path;
+    std::vector<std::string> _rows;
+    bool _written = false;
+};
@@ -0,0 +1,132 @@
+// emhash8::HashSet set algebra vs. the find() loop it replaces.
+//
+// Build:
+//   g++ -std=c++17 -O2 -march=native -Iinclude bench/bench_set_algebra.cpp -o setbench
+// Run:
+//   ./setbench [small=1000000] [large=100000000] [hit_percent=50]
+//
+// The default 1M x 100M run needs about 2.5 GB of memory. With EMH_JSON=<path> both columns
+// are also recorded for bench_compare (op intersect_into/naive, intersect_into/batch, ...)
+// in ns per key of the small set.
+
+#include "bench_result.h"
+
+#include "emhash/hash_set8.hpp"
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <string>
+#include <vector>
+
+using Set = emhash8::HashSet<uint64_t>;
+
+static BenchResults* g_results = nullptr;
+
+static double now_ms() {
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+template <typename F> static double best_of(int rounds, F&& fn) {
+    double best = 1e30;
+    for (int r = 0; r < rounds; r++) {
+        const auto t0 = now_ms();
+        fn();
+        const auto t1 = now_ms();
+        if (t1 - t0 < best)
+            best = t1 - t0;
+    }
+    return best;
+}
+
+static void report(const char* name, double naive_ms, double batch_ms, size_t keys, size_t result) {
+    printf("%-20s naive %9.2f ms (%6.2f ns/key)  batch %9.2f ms (%6.2f ns/key)  x%.2f  result %zu\n", name, naive_ms,
+           naive_ms * 1e6 / keys, batch_ms, batch_ms * 1e6 / keys, naive_ms / batch_ms, result);
+    if (keys) {
+        g_results->add("emhash8", std::string(name) + "/naive", keys, "uint64_t", "void", naive_ms * 1e6 / keys);
+        g_results->add("emhash8", std::string(name) + "/batch", keys, "uint64_t", "void", batch_ms * 1e6 / keys);
+    }
+}
+
+int main(int argc, char* argv[]) {
+    const size_t small_size = argc > 1 ? strtoull(argv[1], nullptr, 10) : 1000000;
+    const size_t large_size = argc > 2 ? strtoull(argv[2], nullptr, 10) : 100000000;
+    const int hit_percent = argc > 3 ? atoi(argv[3]) : 50;
+    const int rounds = 3;
+
+    BenchResults results("setbench");
+    g_results = &results;
+    std::mt19937_64 rng(20260101);
+    Set large(static_cast<uint32_t>(large_size));
+    std::vector<uint64_t> large_keys;
+    large_keys.reserve(large_size);
+    while (large.size() < large_size) {
+        const auto key = rng();
+        if (large.insert(key).second)
+            large_keys.push_back(key);
+    }
+
+    Set small(static_cast<uint32_t>(small_size));
+    while (small.size() < small_size) {
+        if (static_cast<int>(rng() % 100) < hit_percent)
+            small.insert(large_keys[rng() % large_keys.size()]);
+        else
+            small.insert(rng());
+    }
+    printf("small %zu x large %zu, %d%% hits\n", size_t(small.size()), size_t(large.size()), hit_percent);
+
+    size_t naive_count = 0, batch_count = 0;
+    auto naive = best_of(rounds, [&] {
+        naive_count = 0;
+        for (auto key : small)
+            naive_count += large.contains(key);
+    });
+    auto batch = best_of(rounds, [&] { batch_count = small.intersection_size(large); });
+    report("intersection_size", naive, batch, small.size(), batch_count);
+    if (naive_count != batch_count)
+        return 1;
+
+    naive = best_of(rounds, [&] {
+        Set out(static_cast<uint32_t>(small.size()));
+        for (auto key : small)
+            if (large.contains(key))
+                out.insert(key);
+        naive_count = out.size();
+    });
+    batch = best_of(rounds, [&] {
+        Set out(static_cast<uint32_t>(small.size()));
+        batch_count = small.intersect_into(large, out);
+    });
+    report("intersect_into", naive, batch, small.size(), batch_count);
+
+    naive = best_of(rounds, [&] {
+        Set out(static_cast<uint32_t>(small.size()));
+        for (auto key : small)
+            if (!large.contains(key))
+                out.insert(key);
+        naive_count = out.size();
+    });
+    batch = best_of(rounds, [&] {
+        Set out(static_cast<uint32_t>(small.size()));
+        batch_count = small.difference_into(large, out);
+    });
+    report("difference_into", naive, batch, small.size(), batch_count);
+
+    naive = best_of(1, [&] {
+        Set out = large;
+        for (auto key : small)
+            out.insert(key);
+        naive_count = out.size();
+    });
+    batch = best_of(1, [&] {
+        Set out;
+        batch_count = small.union_into(large, out);
+    });
+    report("union_into", naive, batch, small.size(), batch_count);
+    if (results.enabled() && results.write())
+        printf("results written to %s\n", results.path().c_str());
+
+    return naive_count == batch_count ? 0 : 1;
+}
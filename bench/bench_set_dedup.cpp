@@ -0,0 +1,102 @@
+// emihset2/emihset3 insert_batch/contains_batch vs. a per-key loop on a dedup stream.
+//
+// Build:
+//   g++ -std=c++17 -O2 -march=native -Iinclude bench/bench_set_dedup.cpp -o dedupbench
+// Run:
+//   ./dedupbench [distinct=20000000] [events=40000000] [batch=64]
+//
+// Events are drawn from `distinct` uint64_t ids, so the set grows to about `distinct`
+// keys while later events are mostly duplicates. A 100M-key run needs about 3 GB. With
+// EMH_JSON=<path> every column is also recorded for bench_compare (op insert/loop,
+// insert/batch, contains/loop, contains/batch) in ns per key.
+
+#include "bench_result.h"
+
+#include "emilib/emihset2.hpp"
+#include "emilib/emihset3.hpp"
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <vector>
+
+static BenchResults* g_results = nullptr;
+
+static double now_ms() {
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+template <typename Set>
+static void run(const char* name, const std::vector<uint64_t>& events, const std::vector<uint64_t>& probes,
+                size_t batch) {
+    std::vector<uint8_t> mask(batch);
+    size_t loop_new = 0, batch_new = 0, loop_hits = 0, batch_hits = 0;
+
+    Set loop_set;
+    auto t0 = now_ms();
+    for (size_t base = 0; base < events.size(); base += batch) {
+        const auto len = std::min(batch, events.size() - base);
+        for (size_t i = 0; i < len; i++)
+            loop_new += mask[i] = loop_set.insert(events[base + i]).second;
+    }
+    const auto loop_insert = now_ms() - t0;
+
+    t0 = now_ms();
+    for (size_t base = 0; base < probes.size(); base += batch) {
+        const auto len = std::min(batch, probes.size() - base);
+        for (size_t i = 0; i < len; i++)
+            loop_hits += mask[i] = loop_set.contains(probes[base + i]);
+    }
+    const auto loop_contains = now_ms() - t0;
+
+    Set batch_set;
+    t0 = now_ms();
+    for (size_t base = 0; base < events.size(); base += batch)
+        batch_new += batch_set.insert_batch(&events[base], std::min(batch, events.size() - base), mask.data());
+    const auto batch_insert = now_ms() - t0;
+
+    t0 = now_ms();
+    for (size_t base = 0; base < probes.size(); base += batch)
+        batch_hits += batch_set.contains_batch(&probes[base], std::min(batch, probes.size() - base), mask.data());
+    const auto batch_contains = now_ms() - t0;
+
+    printf("%-9s insert   loop %8.2f ms (%5.2f ns/key)  batch %8.2f ms (%5.2f ns/key)  x%.2f  new %zu%s\n", name,
+           loop_insert, loop_insert * 1e6 / events.size(), batch_insert, batch_insert * 1e6 / events.size(),
+           loop_insert / batch_insert, batch_new, loop_new == batch_new ? "" : "  MISMATCH");
+    printf("%-9s contains loop %8.2f ms (%5.2f ns/key)  batch %8.2f ms (%5.2f ns/key)  x%.2f  hits %zu%s\n", name,
+           loop_contains, loop_contains * 1e6 / probes.size(), batch_contains, batch_contains * 1e6 / probes.size(),
+           loop_contains / batch_contains, batch_hits, loop_hits == batch_hits ? "" : "  MISMATCH");
+
+    const auto record = [name](const char* op, size_t keys, double ms) {
+        if (keys)
+            g_results->add(name, op, keys, "uint64_t", "void", ms * 1e6 / keys);
+    };
+    record("insert/loop", events.size(), loop_insert);
+    record("insert/batch", events.size(), batch_insert);
+    record("contains/loop", probes.size(), loop_contains);
+    record("contains/batch", probes.size(), batch_contains);
+}
+
+int main(int argc, char* argv[]) {
+    const size_t distinct = argc > 1 ? strtoull(argv[1], nullptr, 10) : 20000000;
+    const size_t num_events = argc > 2 ? strtoull(argv[2], nullptr, 10) : 2 * distinct;
+    const size_t batch = argc > 3 ? strtoull(argv[3], nullptr, 10) : 64;
+
+    BenchResults results("dedupbench");
+    g_results = &results;
+    std::mt19937_64 rng(20260404);
+    std::vector<uint64_t> events(num_events), probes(num_events / 2);
+    for (auto& id : events)
+        id = (rng() % distinct) * 0x9E3779B97F4A7C15ull;
+    for (auto& id : probes)
+        id = (rng() % (2 * distinct)) * 0x9E3779B97F4A7C15ull; // about 40% hits
+    printf("%zu events over %zu ids, batches of %zu\n", num_events, distinct, batch);
+
+    run<emilib2::HashSet<uint64_t>>("emihset2", events, probes, batch);
+    run<emilib3::HashSet<uint64_t>>("emihset3", events, probes, batch);
+    if (results.enabled() && results.write())
+        printf("results written to %s\n", results.path().c_str());
+    return 0;
+}
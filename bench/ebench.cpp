@@ -10,6 +10,7 @@
 #pragma GCC diagnostic ignored "-Wunused-result"
 #pragma GCC diagnostic ignored "-Wunused-function"
 #include "util.h"
+#include "bench_result.h"
 
 #if __GNUC__ > 4 && __linux__
 #include <ext/pb_ds/assoc_container.hpp>
@@ -283,8 +284,30 @@ static std::map<std::string, int64_t> func_result;
 // func:hash -> time
 static std::map<std::string, std::map<std::string, int64_t>> once_func_hash_time;
 
+// hardware counters per phase, enabled by 'p' or EMH_PERF=1
+static PerfCounters* perf_counters = nullptr;
+static std::string perf_lines;
+
+// every phase as JSON for bench_compare when EMH_JSON=<path> is set, written at exit
+static BenchResults bench_results("ebench");
+static size_t bench_keys = 0;
+
+static int64_t phase_begin() {
+    if (perf_counters)
+        perf_counters->start();
+    return getus();
+}
+
 static void check_func_result(const std::string& hash_name, const std::string& func, size_t sum, int64_t ts1,
                               int weigh = 1) {
+    PerfSample sample;
+    if (perf_counters) {
+        sample = perf_counters->stop();
+        const auto line = sample.format();
+        if (!line.empty())
+            perf_lines += "    " + func + std::string(func.size() < 22 ? 22 - func.size() : 0, ' ') + line + "\n";
+    }
+
     // Compiler barrier: prevent optimizing away computations that feed into 'sum'
 #if defined(__GNUC__) || defined(__clang__)
     asm volatile("" : "+r"(sum));
@@ -303,6 +326,9 @@ static void check_func_result(const std::string& hash_name, const std::string& f
 
     auto& showname = maps[hash_name];
     once_func_hash_time[func][showname] += ts / weigh;
+    if (bench_keys > 0)
+        bench_results.add(hash_name, func, bench_keys, sKeyType, sValueType, ts * 1000.0 / weigh / bench_keys,
+                          &sample, static_cast<double>(bench_keys) * weigh);
     func_index++;
 
     if (func_first < func_last) {
@@ -310,15 +336,19 @@ static void check_func_result(const std::string& hash_name, const std::string& f
             printf("%8s  (%.3f): ", hash_name.data(), hlf);
         if (func_index >= func_first && func_index <= func_last)
             printf("%8s %4ld, ", func.data(), ts / 1000);
-        if (func_index == func_last)
-            printf("\n");
+        if (func_index == func_last) {
+            printf("\n%s", perf_lines.data());
+            perf_lines.clear();
+        }
     } else {
         if (func_index == 1)
             printf("%8s  (%.3f): ", hash_name.data(), hlf);
         if (func_index >= func_first || func_index <= func_last)
             printf("%8s %4ld, ", func.data(), ts / 1000);
-        if (func_index == func_size)
-            printf("\n");
+        if (func_index == func_size) {
+            printf("\n%s", perf_lines.data());
+            perf_lines.clear();
+        }
     }
 }
 
@@ -465,7 +495,7 @@ static void dump_all(std::map<std::string, std::map<std::string, int64_t>>& func
 }
 
 template <class hash_type> static void iter_all(const hash_type& ht_hash, const std::string& hash_name) {
-    auto ts1 = getus();
+    auto ts1 = phase_begin();
     size_t sum = 0;
     for (const auto& kv : ht_hash)
 #if KEY_INT
@@ -503,7 +533,7 @@ template <class hash_type> static void iter_all(const hash_type& ht_hash, const
 
 template <class hash_type>
 static void erase_50_reinsert(hash_type& ht_hash, const std::string& hash_name, const std::vector<keyType>& vList) {
-    auto ts1 = getus();
+    auto ts1 = phase_begin();
     size_t sum = 0;
     for (const auto& v : vList) {
 #ifndef SMAP
@@ -518,7 +548,7 @@ static void erase_50_reinsert(hash_type& ht_hash, const std::string& hash_name,
 
 template <class hash_type> static void insert_erase(const std::string& hash_name, const std::vector<keyType>& vList) {
     hash_type ht_hash;
-    auto ts1 = getus();
+    auto ts1 = phase_begin();
     size_t sum(0);
     // small dataset
     const auto vsmall = 128 + vList.size() % 1024;
@@ -561,7 +591,7 @@ template <class hash_type> static void insert_erase(const std::string& hash_name
 template <class hash_type>
 static void insert_no_reserve(const std::string& hash_name, const std::vector<keyType>& vList) {
     hash_type ht_hash;
-    auto ts1 = getus();
+    auto ts1 = phase_begin();
     size_t sum = 0;
 #if KEY_INT == 0
     for (const auto& v : vList)
@@ -577,7 +607,7 @@ static void insert_no_reserve(const std::string& hash_name, const std::vector<ke
 
 template <class hash_type>
 static void insert_reserve(hash_type& ht_hash, const std::string& hash_name, const std::vector<keyType>& vList) {
-    auto ts1 = getus();
+    auto ts1 = phase_begin();
     size_t sum = 0;
 #ifndef SMAP
     // ht_hash.max_load_factor(0.80f);
@@ -604,7 +634,7 @@ constexpr bool has_insert_unique_v = decltype(has_insert_unique<HMAP, Key, Value
 
 template <class hash_type>
 static void insert_unique(hash_type& ht_hash, const std::string& hash_name, const std::vector<keyType>& vList) {
-    auto ts1 = getus();
+    auto ts1 = phase_begin();
     size_t sum = 0;
 #ifndef SMAP
     ht_hash.reserve(vList.size());
@@ -622,7 +652,7 @@ static void insert_unique(hash_type& ht_hash, const std::string& hash_name, cons
 
 template <class hash_type>
 static void insert_hit(hash_type& ht_hash, const std::string& hash_name, const std::vector<keyType>& vList) {
-    auto ts1 = getus();
+    auto ts1 = phase_begin();
     size_t sum = 0;
     for (const auto& v : vList) {
         ht_hash[v] = TO_VAL(0);
@@ -632,7 +662,7 @@ static void insert_hit(hash_type& ht_hash, const std::string& hash_name, const s
 
 template <class hash_type>
 static void insert_accident(hash_type& ht_hash, const std::string& hash_name, const std::vector<keyType>& vList) {
-    auto ts1 = getus();
+    auto ts1 = phase_begin();
     size_t sum = 0;
     hash_type h;
     for (const auto& v : ht_hash) {
@@ -646,7 +676,7 @@ template <class hash_type>
 static void multi_small_ife(const std::string& hash_name, const std::vector<keyType>& vList) {
 #if KEY_INT
     size_t sum = 0;
-    const auto ts1 = getus();
+    const auto ts1 = phase_begin();
 
     if (test_case % 2) {
         const auto hash_size = vList.size() / 10003 + 4;
@@ -694,7 +724,7 @@ static void multi_small_ife(const std::string& hash_name, const std::vector<keyT
 
 template <class hash_type>
 static void insert_find_erase(const hash_type& ht_hash, const std::string& hash_name, std::vector<keyType>& vList) {
-    auto ts1 = getus();
+    auto ts1 = phase_begin();
     size_t sum = 1;
     hash_type tmp(ht_hash);
     for (const auto& v : vList) {
@@ -733,7 +763,7 @@ template <class hash_type>
 static void insert_backtrace(const std::string& hash_name, const std::vector<keyType>& vList) {
 #if KEY_INT && TTVal < 2
     hash_type ht_hash;
-    auto ts1 = getus();
+    auto ts1 = phase_begin();
     size_t sum = 0;
 
     WyRand srng(vList.size());
@@ -756,7 +786,7 @@ static void insert_backtrace(const std::string& hash_name, const std::vector<key
 template <class hash_type>
 static void insert_erase_first(const std::string& hash_name, const std::vector<keyType>& vList) {
     hash_type ht_hash;
-    auto ts1 = getus();
+    auto ts1 = phase_begin();
     size_t sum = 0;
     auto nsize = vList.size() % 1234567;
     for (int i = nsize - 1; i >= 0; i--) {
@@ -772,7 +802,7 @@ static void insert_erase_first(const std::string& hash_name, const std::vector<k
 template <class hash_type>
 static void insert_erase_continue(const std::string& hash_name, const std::vector<keyType>& vList) {
     hash_type ht_hash;
-    auto ts1 = getus();
+    auto ts1 = phase_begin();
     size_t sum = 0;
     const auto nsize = (int)vList.size();
     int i = 0;
@@ -809,7 +839,7 @@ static void insert_cache_size(const std::string& hash_name, const std::vector<ke
     const auto lsize = cache_size + vList.size() % min_size;
     hash_type tmp, empty;
 
-    auto ts1 = getus();
+    auto ts1 = phase_begin();
     size_t sum = 0;
     for (const auto& v : vList) {
         sum += tmp.emplace(v, TO_VAL(0)).second;
@@ -860,7 +890,7 @@ static void insert_high_load(const std::string& hash_name, const std::vector<key
         }
     }
 
-    auto ts1 = getus();
+    auto ts1 = phase_begin();
     for (; i < maxn; i++) {
         auto& v = vList[i - minn];
 #if KEY_INT
@@ -899,7 +929,7 @@ template <class hash_type> static void insert_erase_high(const std::string& hash
     }
 
     auto sum = 0;
-    auto ts1 = getus();
+    auto ts1 = phase_begin();
     WyRand srng2(vSize);
     for (size_t i = 0; i < vSize; i++) {
         ht_hash[(keyType)srng()];
@@ -918,7 +948,7 @@ static void find_miss(const hash_type& ht_hash, const std::string& hash_name, co
     size_t sum = 0;
 
 #if KEY_STR
-    auto ts1 = getus();
+    auto ts1 = phase_begin();
     for (auto& v : vList) {
         // Keys with "miss_" prefix don't exist in the map (which has "key_" prefix)
         auto miss_key = "miss_" + v;
@@ -926,7 +956,7 @@ static void find_miss(const hash_type& ht_hash, const std::string& hash_name, co
     }
 #else
     // Generate keys guaranteed not in the map: use values above the data range
-    auto ts1 = getus();
+    auto ts1 = phase_begin();
     uint64_t offset = 0;
     for (auto& v : vList) {
 #if KEY_INT
@@ -946,7 +976,7 @@ static void find_miss(const hash_type& ht_hash, const std::string& hash_name, co
 template <class hash_type>
 static void update_value(hash_type& ht_hash, const std::string& hash_name, const std::vector<keyType>& vList) {
     // Pure in-place value update: all keys exist, only overwrite values
-    auto ts1 = getus();
+    auto ts1 = phase_begin();
     size_t sum = 0;
     for (size_t i = 0; i < vList.size(); i++) {
         ht_hash[vList[i]] = TO_VAL(i + 1);
@@ -957,7 +987,7 @@ static void update_value(hash_type& ht_hash, const std::string& hash_name, const
 
 template <class hash_type> static void erase_by_iterator(hash_type& ht_hash, const std::string& hash_name) {
     // Pure iterator-based deletion: erase all elements via iterator traversal
-    auto ts1 = getus();
+    auto ts1 = phase_begin();
     size_t sum = 0;
 #if CXX17
     for (auto it = ht_hash.begin(); it != ht_hash.end();) {
@@ -974,7 +1004,7 @@ template <class hash_type> static void erase_by_iterator(hash_type& ht_hash, con
 template <class hash_type>
 static void find_mixed(const hash_type& ht_hash, const std::string& hash_name, const std::vector<keyType>& vList) {
     // 50% hit + 50% miss: interleave existing keys with non-existing keys
-    auto ts1 = getus();
+    auto ts1 = phase_begin();
     size_t sum = 0;
 #if KEY_INT
     uint64_t offset = 0;
@@ -1016,7 +1046,7 @@ static void find_hit_100(const hash_type& ht_hash, const std::string& hash_name,
     auto vl = vList;
     shuffle(vl.begin(), vl.end());
 
-    auto ts1 = getus();
+    auto ts1 = phase_begin();
     size_t sum = 0;
     for (const auto& v : vl) {
         sum += ht_hash.count(v);
@@ -1030,7 +1060,7 @@ static void find_hit_100(const hash_type& ht_hash, const std::string& hash_name,
 
 template <class hash_type>
 static void erase_all(hash_type& ht_hash, const std::string& hash_name, const std::vector<keyType>& vList) {
-    auto ts1 = getus();
+    auto ts1 = phase_begin();
     size_t sum = 0;
     // Phase 1: erase first half by key
     size_t half = vList.size() / 2;
@@ -1052,7 +1082,7 @@ static void erase_all(hash_type& ht_hash, const std::string& hash_name, const st
 
 template <class hash_type> static void hash_clear(hash_type& ht_hash, const std::string& hash_name) {
     if (ht_hash.size() > 1000000) {
-        auto ts1 = getus();
+        auto ts1 = phase_begin();
         size_t sum = ht_hash.size();
         ht_hash.clear();
         ht_hash.clear();
@@ -1062,7 +1092,7 @@ template <class hash_type> static void hash_clear(hash_type& ht_hash, const std:
 
 template <class hash_type> static void copy_clear(hash_type& ht_hash, const std::string& hash_name) {
     size_t sum = 0;
-    auto ts1 = getus();
+    auto ts1 = phase_begin();
     hash_type thash = ht_hash;
     sum += thash.size();
 
@@ -1321,6 +1351,7 @@ static int benchHashMap(int n) {
 
     std::vector<keyType> vList;
     auto flag = buildTestData(n, vList);
+    bench_keys = vList.size();
 
     // more than 10 hash
 #if KEY_CLA
@@ -1664,7 +1695,8 @@ int main(int argc, char* argv[]) {
         maxn = (1 << 30) / type_size;
 
     float load_factor = 0.0945f;
-    printf("./ebench maxn = %d c(0-1000) f(0-100) d[2-9 mpatseblku] a(0-3) b t(n %dkB - %dMB)\n", (int)maxn,
+    bool use_perf = PerfCounters::requested();
+    printf("./ebench maxn = %d c(0-1000) f(0-100) d[2-9 mpatseblku] a(0-3) b p t(n %dkB - %dMB)\n", (int)maxn,
            minn * type_size >> 10, maxn * type_size >> 20);
 
     for (int i = 1; i < argc; i++) {
@@ -1687,6 +1719,8 @@ int main(int argc, char* argv[]) {
             maxn = value;
         else if (cmd == 't')
             test_extra = 1 - test_extra;
+        else if (cmd == 'p')
+            use_perf = !use_perf;
         else if (cmd == 'd') {
             for (int c = argv[i][1], j = 1; c != '\0'; c = argv[i][++j]) {
                 if (c >= '5' && c <= '9') {
@@ -1746,6 +1780,12 @@ int main(int argc, char* argv[]) {
         }
     }
 
+    PerfCounters counters;
+    if (use_perf && counters.available())
+        perf_counters = &counters;
+    else if (use_perf)
+        printf("hardware counters unavailable (no PMU access or perf_event_paranoid > 2), timings only\n");
+
     Sfc4 srng(rnd);
     for (auto& m : maps)
         printf("  %s\n", m.second.data());
@@ -1788,6 +1828,8 @@ int main(int argc, char* argv[]) {
     }
 
     printf("total time = %.3lf s", (getus() - start) / 1000000.0);
+    if (bench_results.enabled() && bench_results.write())
+        printf("\nresults written to %s", bench_results.path().c_str());
     return 0;
 }
 
@@ -0,0 +1,266 @@
+// Latency histograms for benchmarks that care about the tail (rehash pauses, long chains,
+// tombstone-heavy probes), not just the average.
+//
+//   latency::BatchSampler sampler(16, n);   // one clock read per 16 operations
+//   sampler.begin();
+//   for (...) { op(); sampler.tick(); }
+//   sampler.end();
+//   const auto hist = sampler.histogram();  // corrected for coordinated omission
+//   hist.percentile(99.9) / ticks_per_ns    // ns
+//
+// HdrHistogram keeps log-linear buckets (256 per power of two, <0.8% relative error) over the
+// whole uint64_t range in a fixed 58 KiB array, so recording is O(1) and histograms merge by
+// adding counts. write_chart_json() exports percentile curves in the chart_data layout of the
+// tsl_bench charts; tsl_bench/latency.html plots them.
+
+#pragma once
+
+#include "trace.h" // ticks(), ticks_per_ns()
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace latency {
+
+class HdrHistogram {
+public:
+    static constexpr int SUB_BITS = 8;
+    static constexpr uint64_t SUB_COUNT = 1ull << SUB_BITS;
+    static constexpr uint64_t HALF_COUNT = SUB_COUNT / 2;
+
+    HdrHistogram() : _counts(SUB_COUNT + (64 - SUB_BITS) * HALF_COUNT, 0) {}
+
+    void record(uint64_t value, uint64_t count = 1) {
+        if (count == 0)
+            return;
+        _counts[index(value)] += count;
+        _total += count;
+        _sum += static_cast<double>(value) * static_cast<double>(count);
+        _min = std::min(_min, value);
+        _max = std::max(_max, value);
+    }
+
+    // As HdrHistogram's recordValueWithExpectedInterval: a value longer than the interval at
+    // which requests arrive also delayed the requests that should have been issued meanwhile,
+    // so it is recorded together with value - interval, value - 2 * interval, ...
+    void record_corrected(uint64_t value, uint64_t interval, uint64_t count = 1) {
+        record(value, count);
+        if (interval == 0)
+            return;
+        for (uint64_t missing = value > interval ? value - interval : 0; missing >= interval; missing -= interval)
+            record(missing, count);
+    }
+
+    void merge(const HdrHistogram& rhs) {
+        for (size_t i = 0; i < _counts.size(); i++)
+            _counts[i] += rhs._counts[i];
+        _total += rhs._total;
+        _sum += rhs._sum;
+        _min = std::min(_min, rhs._min);
+        _max = std::max(_max, rhs._max);
+    }
+
+    uint64_t total() const { return _total; }
+    uint64_t min() const { return _total ? _min : 0; }
+    uint64_t max() const { return _max; }
+    double mean() const { return _total ? _sum / static_cast<double>(_total) : 0.0; }
+
+    // Smallest bucket bound below which pct percent of the values fall (0 < pct <= 100).
+    uint64_t percentile(double pct) const {
+        if (_total == 0)
+            return 0;
+        const auto want = std::ceil(pct / 100.0 * static_cast<double>(_total));
+        const auto rank = std::max<uint64_t>(1, static_cast<uint64_t>(want));
+        uint64_t seen = 0;
+        for (size_t i = 0; i < _counts.size(); i++) {
+            seen += _counts[i];
+            if (seen >= rank)
+                return std::min(upper(i), _max);
+        }
+        return _max;
+    }
+
+private:
+    static int msb(uint64_t value) {
+#if defined(__GNUC__) || defined(__clang__)
+        return 63 - __builtin_clzll(value);
+#else
+        int bit = 0;
+        while (value >>= 1)
+            bit++;
+        return bit;
+#endif
+    }
+
+    // [0, SUB_COUNT) exact, then HALF_COUNT buckets per power of two
+    static size_t index(uint64_t value) {
+        if (value < SUB_COUNT)
+            return static_cast<size_t>(value);
+        const int shift = msb(value) - SUB_BITS + 1;
+        return static_cast<size_t>(SUB_COUNT + (shift - 1) * HALF_COUNT + ((value >> shift) - HALF_COUNT));
+    }
+
+    static uint64_t upper(size_t idx) {
+        if (idx < SUB_COUNT)
+            return idx;
+        const auto rel = idx - SUB_COUNT;
+        const auto shift = static_cast<int>(rel / HALF_COUNT) + 1;
+        const auto mantissa = rel % HALF_COUNT + HALF_COUNT;
+        return ((mantissa + 1) << shift) - 1;
+    }
+
+    std::vector<uint64_t> _counts;
+    uint64_t _total = 0;
+    double _sum = 0;
+    uint64_t _min = UINT64_MAX;
+    uint64_t _max = 0;
+};
+
+// Times a loop in batches of `batch` operations, one clock read per batch, and turns the
+// batch durations into a per-operation histogram afterwards, so the timed loop only pays
+// an increment and a store per batch.
+//
+// A batch of N ops up to twice N times the median per-op time S records N ops at its mean.
+// A slower batch is taken as one stalled operation (a rehash, a long chain walk) plus N - 1
+// ops at S. The stalled one is recorded with coordinated-omission correction against the
+// expected interval I between requests (by default S, i.e. a client keeping the map busy;
+// pass 1 / target rate otherwise), as if requests kept arriving while the map was stuck.
+class BatchSampler {
+public:
+    explicit BatchSampler(uint32_t batch = 16, size_t expected_ops = 0) : _batch(std::max<uint32_t>(1, batch)) {
+        _batches.reserve(expected_ops / _batch + 1);
+        uint64_t best = UINT64_MAX;
+        for (int i = 0; i < 1000; i++) {
+            const auto t0 = trace::ticks();
+            best = std::min(best, trace::ticks() - t0);
+        }
+        _clock_cost = best;
+    }
+
+    void begin() {
+        _batches.clear();
+        _tail_ops = 0;
+        _in_batch = 0;
+        _start = trace::ticks();
+    }
+
+    void tick() {
+        if (++_in_batch == _batch) {
+            const auto now = trace::ticks();
+            _batches.push_back(now - _start);
+            _start = now;
+            _in_batch = 0;
+        }
+    }
+
+    void end() {
+        _tail_ops = _in_batch;
+        _tail_ticks = _in_batch ? trace::ticks() - _start : 0;
+    }
+
+    uint64_t ops() const { return _batches.size() * _batch + _tail_ops; }
+
+    // Median per-op ticks over the full batches.
+    uint64_t median_interval() const {
+        if (_batches.empty())
+            return _tail_ops ? net(_tail_ticks) / _tail_ops : 0;
+        std::vector<uint64_t> copy(_batches);
+        std::nth_element(copy.begin(), copy.begin() + static_cast<std::ptrdiff_t>(copy.size() / 2), copy.end());
+        return std::max<uint64_t>(1, net(copy[copy.size() / 2]) / _batch);
+    }
+
+    // interval 0: use median_interval(); correct false: same attribution, no CO correction.
+    HdrHistogram histogram(uint64_t interval = 0, bool correct = true) const {
+        HdrHistogram hist;
+        const auto service = median_interval();
+        if (interval == 0)
+            interval = service;
+        for (const auto ticks : _batches)
+            add_batch(hist, net(ticks), _batch, service, correct ? interval : 0);
+        if (_tail_ops)
+            add_batch(hist, net(_tail_ticks), _tail_ops, service, correct ? interval : 0);
+        return hist;
+    }
+
+private:
+    uint64_t net(uint64_t ticks) const { return ticks > _clock_cost ? ticks - _clock_cost : 0; }
+
+    // interval 0: no correction
+    static void add_batch(HdrHistogram& hist, uint64_t ticks, uint64_t ops, uint64_t service, uint64_t interval) {
+        if (ops == 1) {
+            hist.record_corrected(ticks, interval);
+        } else if (ticks <= 2 * ops * service) {
+            hist.record(ticks / ops, ops);
+        } else {
+            hist.record(service, ops - 1);
+            hist.record_corrected(ticks - (ops - 1) * service, interval);
+        }
+    }
+
+    uint32_t _batch;
+    uint32_t _in_batch = 0;
+    uint64_t _start = 0;
+    uint64_t _clock_cost = 0;
+    uint64_t _tail_ops = 0;
+    uint64_t _tail_ticks = 0;
+    std::vector<uint64_t> _batches;
+};
+
+// Percentiles printed by benchmarks and exported to JSON.
+static const double PERCENTILES[] = {50, 75, 90, 99, 99.9, 99.99, 99.999, 100};
+
+// One histogram of one operation on one map.
+struct Series {
+    std::string chart;   // e.g. "latency_insert"
+    std::string program; // e.g. "emhash8"
+    HdrHistogram hist;
+    HdrHistogram raw; // without coordinated-omission correction
+};
+
+// Writes {"<chart>": [{"program": p, "label": p, "data": [[percentile, ns], ...],
+// "raw": [[percentile, ns], ...]}, ...]}, the chart_data layout of the tsl_bench pages.
+inline bool write_chart_json(const char* path, const std::vector<Series>& all, double ticks_per_ns) {
+    FILE* fp = fopen(path, "w");
+    if (!fp)
+        return false;
+    std::vector<std::string> charts;
+    for (const auto& series : all)
+        if (std::find(charts.begin(), charts.end(), series.chart) == charts.end())
+            charts.push_back(series.chart);
+
+    const auto curve = [&](const HdrHistogram& hist) {
+        std::string out = "[";
+        char buf[64];
+        for (const auto pct : PERCENTILES) {
+            snprintf(buf, sizeof(buf), "%s[%g, %.1f]", out.size() > 1 ? ", " : "", pct,
+                     static_cast<double>(hist.percentile(pct)) / ticks_per_ns);
+            out += buf;
+        }
+        return out + "]";
+    };
+
+    fprintf(fp, "{");
+    for (size_t c = 0; c < charts.size(); c++) {
+        fprintf(fp, "%s\n  \"%s\": [", c ? "," : "", charts[c].c_str());
+        bool first = true;
+        for (const auto& series : all) {
+            if (series.chart != charts[c])
+                continue;
+            fprintf(fp, "%s\n    {\"program\": \"%s\", \"label\": \"%s\", \"count\": %llu, \"data\": %s, \"raw\": %s}",
+                    first ? "" : ",", series.program.c_str(), series.program.c_str(),
+                    static_cast<unsigned long long>(series.hist.total()), curve(series.hist).c_str(),
+                    curve(series.raw).c_str());
+            first = false;
+        }
+        fprintf(fp, "\n  ]");
+    }
+    fprintf(fp, "\n}\n");
+    return fclose(fp) == 0;
+}
+
+} // namespace latency
@@ -0,0 +1,179 @@
+// Hardware counters for benchmark phases, via Linux perf_event_open.
+//
+//   PerfCounters pc;             // opens the counters once; all optional
+//   pc.start();
+//   ... phase ...
+//   const PerfSample s = pc.stop();
+//   printf("%s\n", s.format(num_ops).c_str());
+//
+// Counts user space only, so perf_event_paranoid <= 2 is enough. Each event is opened on its
+// own: events the CPU, VM or kernel does not offer are skipped and printed as "-", and when
+// none can be opened (other OS, containers without PMU access) start/stop do nothing and
+// format() returns an empty string. Counters multiplexed by the kernel are scaled by the
+// phase's enabled/running time and the sample is marked with '~'.
+
+#pragma once
+
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+
+#if defined(__linux__)
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#define EMH_HAVE_PERF_EVENT 1
+#endif
+
+enum PerfEvent { PERF_CYCLES = 0, PERF_INSTRUCTIONS, PERF_L1D_MISSES, PERF_LLC_MISSES, PERF_BRANCH_MISSES,
+                 PERF_DTLB_MISSES, PERF_NUM_EVENTS };
+
+static const char* const PERF_EVENT_NAMES[PERF_NUM_EVENTS] = {"cycles", "instr", "L1D-miss", "LLC-miss",
+                                                              "br-miss", "dTLB-miss"};
+
+struct PerfSample {
+    double value[PERF_NUM_EVENTS] = {};
+    bool valid[PERF_NUM_EVENTS] = {};
+    bool multiplexed = false;
+
+    bool any() const {
+        for (const auto ok : valid)
+            if (ok)
+                return true;
+        return false;
+    }
+
+    // One line: per-op counts when ops > 0 (else totals in millions), plus IPC.
+    std::string format(double ops = 0) const {
+        if (!any())
+            return std::string();
+        std::string out;
+        char buf[64];
+        for (int i = 0; i < PERF_NUM_EVENTS; i++) {
+            if (!valid[i])
+                snprintf(buf, sizeof(buf), "%s%s -", out.empty() ? "" : "  ", PERF_EVENT_NAMES[i]);
+            else if (ops > 0)
+                snprintf(buf, sizeof(buf), "%s%s %.2f", out.empty() ? "" : "  ", PERF_EVENT_NAMES[i], value[i] / ops);
+            else
+                snprintf(buf, sizeof(buf), "%s%s %.2fM", out.empty() ? "" : "  ", PERF_EVENT_NAMES[i], value[i] / 1e6);
+            out += buf;
+        }
+        if (valid[PERF_CYCLES] && valid[PERF_INSTRUCTIONS] && value[PERF_CYCLES] > 0) {
+            snprintf(buf, sizeof(buf), "  IPC %.2f", value[PERF_INSTRUCTIONS] / value[PERF_CYCLES]);
+            out += buf;
+        }
+        out += ops > 0 ? " /op" : "";
+        if (multiplexed)
+            out += " ~";
+        return out;
+    }
+};
+
+class PerfCounters {
+public:
+    PerfCounters() {
+        for (auto& fd : _fd)
+            fd = -1;
+#ifdef EMH_HAVE_PERF_EVENT
+        const auto cache = [](uint64_t cache_id, uint64_t op, uint64_t result) {
+            return cache_id | (op << 8) | (result << 16);
+        };
+        open(PERF_CYCLES, PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES);
+        open(PERF_INSTRUCTIONS, PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS);
+        open(PERF_L1D_MISSES, PERF_TYPE_HW_CACHE,
+             cache(PERF_COUNT_HW_CACHE_L1D, PERF_COUNT_HW_CACHE_OP_READ, PERF_COUNT_HW_CACHE_RESULT_MISS));
+        open(PERF_LLC_MISSES, PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES);
+        open(PERF_BRANCH_MISSES, PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES);
+        open(PERF_DTLB_MISSES, PERF_TYPE_HW_CACHE,
+             cache(PERF_COUNT_HW_CACHE_DTLB, PERF_COUNT_HW_CACHE_OP_READ, PERF_COUNT_HW_CACHE_RESULT_MISS));
+#endif
+    }
+
+    ~PerfCounters() {
+#ifdef EMH_HAVE_PERF_EVENT
+        for (const auto fd : _fd)
+            if (fd >= 0)
+                close(fd);
+#endif
+    }
+
+    PerfCounters(const PerfCounters&) = delete;
+    PerfCounters& operator=(const PerfCounters&) = delete;
+
+    // true when at least one event could be opened
+    bool available() const {
+        for (const auto fd : _fd)
+            if (fd >= 0)
+                return true;
+        return false;
+    }
+
+    // Counters are requested with EMH_PERF=1 in the environment (benchmarks may add a flag).
+    static bool requested() {
+        const char* env = getenv("EMH_PERF");
+        return env && env[0] && env[0] != '0';
+    }
+
+    void start() {
+#ifdef EMH_HAVE_PERF_EVENT
+        // PERF_EVENT_IOC_RESET clears the count but not the enabled/running times, so keep
+        // all three and let stop() scale this phase by its own deltas
+        for (int i = 0; i < PERF_NUM_EVENTS; i++) {
+            if (_fd[i] >= 0 && read(_fd[i], _base[i], sizeof(_base[i])) != static_cast<ssize_t>(sizeof(_base[i])))
+                memset(_base[i], 0, sizeof(_base[i]));
+        }
+        for (const auto fd : _fd)
+            if (fd >= 0)
+                ioctl(fd, PERF_EVENT_IOC_ENABLE, 0);
+#endif
+    }
+
+    PerfSample stop() {
+        PerfSample sample;
+#ifdef EMH_HAVE_PERF_EVENT
+        for (const auto fd : _fd)
+            if (fd >= 0)
+                ioctl(fd, PERF_EVENT_IOC_DISABLE, 0);
+        for (int i = 0; i < PERF_NUM_EVENTS; i++) {
+            uint64_t data[3]; // value, time enabled, time running
+            if (_fd[i] < 0 || read(_fd[i], data, sizeof(data)) != static_cast<ssize_t>(sizeof(data)))
+                continue;
+            const auto count = data[0] - _base[i][0];
+            const auto enabled = data[1] - _base[i][1], running = data[2] - _base[i][2];
+            if (running == 0) // not scheduled during this phase
+                continue;
+            sample.valid[i] = true;
+            sample.value[i] = static_cast<double>(count);
+            if (running < enabled) {
+                sample.value[i] *= static_cast<double>(enabled) / static_cast<double>(running);
+                sample.multiplexed = true;
+            }
+        }
+#endif
+        return sample;
+    }
+
+private:
+#ifdef EMH_HAVE_PERF_EVENT
+    void open(int slot, uint32_t type, uint64_t config) {
+        perf_event_attr attr;
+        memset(&attr, 0, sizeof(attr));
+        attr.size = sizeof(attr);
+        attr.type = type;
+        attr.config = config;
+        attr.disabled = 1;
+        attr.exclude_kernel = 1;
+        attr.exclude_hv = 1;
+        attr.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+        _fd[slot] = static_cast<int>(syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0));
+    }
+#endif
+
+    int _fd[PERF_NUM_EVENTS];
+#ifdef EMH_HAVE_PERF_EVENT
+    uint64_t _base[PERF_NUM_EVENTS][3] = {}; // value, time enabled, time running at start()
+#endif
+};
@@ -0,0 +1,196 @@
+// Operation traces for trace_bench / trace_gen.
+//
+// File layout (little endian):
+//   header  24 bytes   "EMHT", uint32 version (1), uint64 num_records, uint64 num_load
+//   record  12 bytes   uint64 key, uint32 (op << 28 | value_size)
+//
+// The first num_load records are the load phase (inserts that build the table); the rest
+// are replayed and timed. value_size (< 2^28) is the value length in bytes for inserts and
+// updates, 0 for a fixed 8 byte value; a trace with any non-zero size is replayed with
+// std::string values. To replay production traffic, convert the recorded operation log to
+// this layout: one record per operation, keys already reduced to 64 bits.
+
+#pragma once
+
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <vector>
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__)
+#include <x86intrin.h>
+#define TRACE_HAVE_RDTSC 1
+#endif
+
+namespace trace {
+
+enum Op : uint8_t {
+    READ = 0,  // find
+    UPDATE,    // insert_or_assign
+    INSERT,    // emplace
+    DELETE,    // erase
+    SCAN,      // find, one record per key of a YCSB-E scan
+    RMW,       // find, then assign or emplace (read-modify-write)
+    NUM_OPS
+};
+
+static const char* const OP_NAMES[NUM_OPS] = {"read", "update", "insert", "delete", "scan", "rmw"};
+
+struct Record {
+    uint64_t key;
+    uint32_t value_size;
+    Op op;
+};
+
+struct Trace {
+    std::vector<Record> records;
+    uint64_t num_load = 0;
+    bool has_values = false; // some record carries a value size
+};
+
+static constexpr char MAGIC[4] = {'E', 'M', 'H', 'T'};
+static constexpr uint32_t VERSION = 1;
+static constexpr uint32_t SIZE_MASK = (1u << 28) - 1;
+
+inline bool save(const char* path, const Trace& trace) {
+    FILE* fp = fopen(path, "wb");
+    if (!fp)
+        return false;
+    char header[24];
+    const uint64_t num = trace.records.size();
+    memcpy(header, MAGIC, 4);
+    memcpy(header + 4, &VERSION, 4);
+    memcpy(header + 8, &num, 8);
+    memcpy(header + 16, &trace.num_load, 8);
+    bool ok = fwrite(header, sizeof(header), 1, fp) == 1;
+
+    std::vector<char> buf;
+    buf.reserve(12 << 16);
+    for (size_t i = 0; ok && i < trace.records.size(); i++) {
+        const auto& rec = trace.records[i];
+        const uint32_t word = static_cast<uint32_t>(rec.op) << 28 | (rec.value_size & SIZE_MASK);
+        char out[12];
+        memcpy(out, &rec.key, 8);
+        memcpy(out + 8, &word, 4);
+        buf.insert(buf.end(), out, out + 12);
+        if (buf.size() >= (12 << 16) || i + 1 == trace.records.size()) {
+            ok = fwrite(buf.data(), buf.size(), 1, fp) == 1;
+            buf.clear();
+        }
+    }
+    return fclose(fp) == 0 && ok;
+}
+
+inline bool load(const char* path, Trace& trace) {
+    FILE* fp = fopen(path, "rb");
+    if (!fp)
+        return false;
+    char header[24];
+    uint32_t version = 0;
+    uint64_t num = 0;
+    bool ok = fread(header, sizeof(header), 1, fp) == 1 && memcmp(header, MAGIC, 4) == 0;
+    if (ok) {
+        memcpy(&version, header + 4, 4);
+        memcpy(&num, header + 8, 8);
+        memcpy(&trace.num_load, header + 16, 8);
+        ok = version == VERSION && trace.num_load <= num;
+    }
+
+    // the header's record count must fit in the file before it sizes the buffer
+    const auto body = ok && fseek(fp, 0, SEEK_END) == 0 ? ftell(fp) - static_cast<long>(sizeof(header)) : -1L;
+    ok = ok && body >= 0 && num <= static_cast<uint64_t>(body) / 12 && fseek(fp, sizeof(header), SEEK_SET) == 0;
+    if (!ok) {
+        fclose(fp);
+        return false;
+    }
+
+    std::vector<char> buf(12 * num);
+    ok = ok && (num == 0 || fread(buf.data(), buf.size(), 1, fp) == 1);
+    fclose(fp);
+    if (!ok)
+        return false;
+
+    trace.records.resize(num);
+    trace.has_values = false;
+    for (uint64_t i = 0; i < num; i++) {
+        auto& rec = trace.records[i];
+        uint32_t word;
+        memcpy(&rec.key, &buf[12 * i], 8);
+        memcpy(&word, &buf[12 * i + 8], 4);
+        rec.op = static_cast<Op>(word >> 28);
+        rec.value_size = word & SIZE_MASK;
+        if (rec.op >= NUM_OPS)
+            return false;
+        trace.has_values |= rec.value_size != 0;
+    }
+    return true;
+}
+
+// ------------------------------------------------------------
+// Timestamps: rdtsc where available (a few ns per read), else steady_clock.
+
+inline uint64_t ticks() {
+#ifdef TRACE_HAVE_RDTSC
+    return __rdtsc();
+#else
+    return static_cast<uint64_t>(std::chrono::steady_clock::now().time_since_epoch().count());
+#endif
+}
+
+// Ticks per nanosecond, measured against steady_clock over about 50 ms.
+inline double ticks_per_ns() {
+    const auto c0 = std::chrono::steady_clock::now();
+    const auto t0 = ticks();
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    const auto t1 = ticks();
+    const auto ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - c0).count();
+    return static_cast<double>(t1 - t0) / ns;
+}
+
+// ------------------------------------------------------------
+// YCSB key choosers (Gray et al., "Quickly generating billion-record synthetic databases").
+
+inline uint64_t fnv64(uint64_t val) {
+    uint64_t hash = 0xCBF29CE484222325ull;
+    for (int i = 0; i < 8; i++) {
+        hash ^= val & 0xff;
+        hash *= 1099511628211ull;
+        val >>= 8;
+    }
+    return hash;
+}
+
+// Zipfian over [0, items): item 0 is the most popular.
+class Zipfian {
+public:
+    Zipfian(uint64_t items, double theta) : _items(items), _theta(theta) {
+        for (uint64_t i = 1; i <= items; i++)
+            _zetan += 1.0 / std::pow(static_cast<double>(i), theta);
+        const double zeta2 = 1.0 + 1.0 / std::pow(2.0, theta);
+        _alpha = 1.0 / (1.0 - theta);
+        _eta = (1.0 - std::pow(2.0 / static_cast<double>(items), 1.0 - theta)) / (1.0 - zeta2 / _zetan);
+    }
+
+    // u uniform in [0, 1)
+    uint64_t next(double u) const {
+        const double uz = u * _zetan;
+        if (uz < 1.0)
+            return 0;
+        if (uz < 1.0 + std::pow(0.5, _theta))
+            return 1;
+        const auto item = static_cast<uint64_t>(static_cast<double>(_items) * std::pow(_eta * u - _eta + 1.0, _alpha));
+        return item < _items ? item : _items - 1;
+    }
+
+private:
+    uint64_t _items;
+    double _theta;
+    double _zetan = 0;
+    double _alpha, _eta;
+};
+
+} // namespace trace
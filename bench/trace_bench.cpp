@@ -0,0 +1,225 @@
+// Replays an operation trace (see trace.h, written by trace_gen or converted from production
+// logs) against emhash5-8 and emilib1-4.
+//
+// Build:
+//   g++ -std=c++17 -O2 -march=native -Iinclude -Ibench bench/trace_bench.cpp -o trace_bench
+// Run:
+//   ./trace_bench <file.trace> [map name filter, e.g. emhash8] [repeat=1]
+//
+// Each map runs the load phase untimed per op, then replays the rest with every operation
+// timed on its own (rdtsc on x86, minus the measured cost of reading the clock). Per
+// operation class it prints the count, throughput over the time spent in that class, and
+// p50/p99/p99.9 latency; the replay line is wall-clock throughput over all classes.
+// With EMH_PERF=1 the replay is also counted with hardware counters (see perf_counters.h).
+// With EMH_JSON=<path> the load, the replay and every operation class are also written as JSON
+// for bench_compare (see bench_result.h), one sample per repeat.
+
+#include "bench_result.h"
+#include "perf_counters.h"
+#include "trace.h"
+
+#include "emhash/hash_table5.hpp"
+#include "emhash/hash_table6.hpp"
+#include "emhash/hash_table7.hpp"
+#include "emhash/hash_table8.hpp"
+#include "emilib/emihmap1.hpp"
+#include "emilib/emihmap2.hpp"
+#include "emilib/emihmap3.hpp"
+#include "emilib/emihmap4.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+namespace {
+
+double g_ticks_per_ns = 1.0;
+uint64_t g_tick_cost = 0; // ticks for two back-to-back reads
+uint64_t g_sink = 0;
+PerfCounters* g_counters = nullptr;
+BenchResults* g_results = nullptr;
+
+template <typename V> struct Values;
+
+template <> struct Values<uint64_t> {
+    static uint64_t make(uint32_t, uint64_t seq) { return seq; }
+    static uint64_t digest(uint64_t val) { return val; }
+    static void modify(uint64_t& val) { val++; }
+};
+
+template <> struct Values<std::string> {
+    static const std::string& filler() {
+        static const std::string str(1 << 20, 'v');
+        return str;
+    }
+    static std::string make(uint32_t size, uint64_t) {
+        return size <= filler().size() ? filler().substr(0, size) : std::string(size, 'v');
+    }
+    static uint64_t digest(const std::string& val) { return val.size(); }
+    static void modify(std::string& val) {
+        if (!val.empty())
+            val[0] ^= 1;
+    }
+};
+
+uint64_t measure_tick_cost() {
+    uint64_t best = ~0ull;
+    for (int i = 0; i < 10000; i++) {
+        const auto t0 = trace::ticks();
+        const auto t1 = trace::ticks();
+        best = std::min(best, t1 - t0);
+    }
+    return best;
+}
+
+double percentile_ns(std::vector<uint32_t>& lat, double pct) {
+    if (lat.empty())
+        return 0;
+    const auto nth = std::min(lat.size() - 1, static_cast<size_t>(pct / 100.0 * static_cast<double>(lat.size())));
+    std::nth_element(lat.begin(), lat.begin() + static_cast<std::ptrdiff_t>(nth), lat.end());
+    return lat[nth] / g_ticks_per_ns;
+}
+
+template <typename Map, typename V> void replay(const char* name, const trace::Trace& trace) {
+    using Vals = Values<V>;
+    const auto& recs = trace.records;
+    Map map;
+
+    auto t0 = trace::ticks();
+    for (uint64_t i = 0; i < trace.num_load; i++)
+        (void)map.emplace(recs[i].key, Vals::make(recs[i].value_size, i));
+    const double load_ms = (trace::ticks() - t0) / g_ticks_per_ns / 1e6;
+
+    std::vector<uint32_t> lat[trace::NUM_OPS];
+    for (auto& vec : lat)
+        vec.reserve((recs.size() - trace.num_load) / 4);
+    uint64_t sink = 0;
+
+    if (g_counters)
+        g_counters->start();
+    const auto start = trace::ticks();
+    for (uint64_t i = trace.num_load; i < recs.size(); i++) {
+        const auto& rec = recs[i];
+        t0 = trace::ticks();
+        switch (rec.op) {
+        case trace::READ:
+        case trace::SCAN: {
+            const auto it = map.find(rec.key);
+            if (it != map.end())
+                sink += Vals::digest(it->second);
+            break;
+        }
+        case trace::UPDATE:
+            (void)map.insert_or_assign(rec.key, Vals::make(rec.value_size, i));
+            break;
+        case trace::INSERT:
+            (void)map.emplace(rec.key, Vals::make(rec.value_size, i));
+            break;
+        case trace::DELETE:
+            sink += map.erase(rec.key);
+            break;
+        default: { // RMW
+            const auto it = map.find(rec.key);
+            if (it != map.end())
+                Vals::modify(it->second);
+            else
+                (void)map.emplace(rec.key, Vals::make(rec.value_size, i));
+            break;
+        }
+        }
+        const auto spent = trace::ticks() - t0;
+        lat[rec.op].push_back(static_cast<uint32_t>(std::min<uint64_t>(spent > g_tick_cost ? spent - g_tick_cost : 0,
+                                                                       UINT32_MAX)));
+    }
+    const double replay_ms = (trace::ticks() - start) / g_ticks_per_ns / 1e6;
+    const auto num_ops = recs.size() - trace.num_load;
+    const auto counted = g_counters ? g_counters->stop() : PerfSample();
+    g_sink += sink + map.size();
+
+    printf("%-8s load %9.2f ms  replay %9.2f ms  %7.2f Mops/s  size %zu\n", name, load_ms, replay_ms,
+           replay_ms > 0 ? num_ops / replay_ms / 1e3 : 0.0, static_cast<size_t>(map.size()));
+    if (counted.any()) // includes the two clock reads per op
+        printf("  %s\n", counted.format(static_cast<double>(num_ops)).c_str());
+    const char* value_type = std::is_same<V, std::string>::value ? "string" : "uint64_t";
+    if (trace.num_load > 0)
+        g_results->add(name, "load", trace.num_load, "uint64_t", value_type, load_ms * 1e6 / trace.num_load);
+    if (num_ops > 0)
+        g_results->add(name, "replay", trace.num_load, "uint64_t", value_type, replay_ms * 1e6 / num_ops, &counted,
+                       static_cast<double>(num_ops));
+    for (int op = 0; op < trace::NUM_OPS; op++) {
+        auto& vec = lat[op];
+        if (vec.empty())
+            continue;
+        double total = 0;
+        for (const auto ticks : vec)
+            total += ticks;
+        const double total_ns = total / g_ticks_per_ns;
+        const double p50 = percentile_ns(vec, 50), p99 = percentile_ns(vec, 99), p999 = percentile_ns(vec, 99.9);
+        printf("  %-7s %10zu ops  %8.2f Mops/s  p50 %7.1f  p99 %8.1f  p99.9 %9.1f ns\n", trace::OP_NAMES[op],
+               vec.size(), total_ns > 0 ? vec.size() / total_ns * 1e3 : 0.0, p50, p99, p999);
+        g_results->add(name, trace::OP_NAMES[op], trace.num_load, "uint64_t", value_type, total_ns / vec.size());
+    }
+}
+
+template <typename Map, typename V>
+void run(const char* name, const trace::Trace& trace, const char* filter, int repeat) {
+    if (filter && !strstr(name, filter))
+        return;
+    for (int i = 0; i < repeat; i++)
+        replay<Map, V>(name, trace);
+}
+
+template <typename V> void run_all(const trace::Trace& trace, const char* filter, int repeat) {
+    run<emhash5::HashMap<uint64_t, V>, V>("emhash5", trace, filter, repeat);
+    run<emhash6::HashMap<uint64_t, V>, V>("emhash6", trace, filter, repeat);
+    run<emhash7::HashMap<uint64_t, V>, V>("emhash7", trace, filter, repeat);
+    run<emhash8::HashMap<uint64_t, V>, V>("emhash8", trace, filter, repeat);
+    run<emilib::HashMap<uint64_t, V>, V>("emilib1", trace, filter, repeat);
+    run<emilib2::HashMap<uint64_t, V>, V>("emilib2", trace, filter, repeat);
+    run<emilib3::HashMap<uint64_t, V>, V>("emilib3", trace, filter, repeat);
+    run<emilib4::HashMap<uint64_t, V>, V>("emilib4", trace, filter, repeat);
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    if (argc < 2) {
+        fprintf(stderr, "usage: %s <file.trace> [map filter] [repeat]\n", argv[0]);
+        return 1;
+    }
+    trace::Trace trace;
+    if (!trace::load(argv[1], trace)) {
+        fprintf(stderr, "cannot read trace %s\n", argv[1]);
+        return 1;
+    }
+    const char* filter = argc > 2 && argv[2][0] ? argv[2] : nullptr;
+    const int repeat = argc > 3 ? std::max(1, atoi(argv[3])) : 1;
+
+    g_ticks_per_ns = trace::ticks_per_ns();
+    g_tick_cost = measure_tick_cost();
+    printf("%s: %llu load + %llu ops, %s values, clock %.2f ticks/ns, %.1f ns per read subtracted\n", argv[1],
+           static_cast<unsigned long long>(trace.num_load),
+           static_cast<unsigned long long>(trace.records.size() - trace.num_load),
+           trace.has_values ? "string" : "uint64", g_ticks_per_ns, g_tick_cost / g_ticks_per_ns);
+
+    BenchResults results("trace_bench");
+    g_results = &results;
+    PerfCounters counters;
+    if (PerfCounters::requested() && counters.available())
+        g_counters = &counters;
+    else if (PerfCounters::requested())
+        printf("hardware counters unavailable, timings only\n");
+
+    if (trace.has_values)
+        run_all<std::string>(trace, filter, repeat);
+    else
+        run_all<uint64_t>(trace, filter, repeat);
+    if (results.enabled() && results.write())
+        printf("results written to %s\n", results.path().c_str());
+    return g_sink == 42 ? 1 : 0;
+}
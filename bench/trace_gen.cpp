@@ -0,0 +1,98 @@
+// Writes a YCSB style operation trace for trace_bench.
+//
+// Build:
+//   g++ -std=c++17 -O2 -Ibench bench/trace_gen.cpp -o trace_gen
+// Run:
+//   ./trace_gen <workload A-F> <out.trace> [records=1000000] [ops=10000000] [theta=0.99] [value_size=0]
+//
+// The load phase inserts `records` keys, then `ops` operations follow:
+//   A  50% read, 50% update             zipfian
+//   B  95% read,  5% update             zipfian
+//   C 100% read                         zipfian
+//   D  95% read,  5% insert             latest (reads favour recent inserts)
+//   E  95% scan,  5% insert             zipfian start, 1..100 keys per scan
+//   F  50% read, 50% read-modify-write  zipfian
+// Keys are fnv64(record id) as in YCSB, and the zipfian ranks are scrambled over the key
+// space so the hot keys are not neighbours. value_size 0 stores 8 byte integers.
+
+#include "trace.h"
+
+#include <cctype>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+
+int main(int argc, char* argv[]) {
+    if (argc < 3 || strlen(argv[1]) != 1 || toupper(argv[1][0]) < 'A' || toupper(argv[1][0]) > 'F') {
+        fprintf(stderr, "usage: %s <workload A-F> <out.trace> [records] [ops] [theta] [value_size]\n", argv[0]);
+        return 1;
+    }
+    const char workload = static_cast<char>(toupper(argv[1][0]));
+    const uint64_t records = argc > 3 ? strtoull(argv[3], nullptr, 10) : 1000000;
+    const uint64_t ops = argc > 4 ? strtoull(argv[4], nullptr, 10) : 10000000;
+    const double theta = argc > 5 ? atof(argv[5]) : 0.99;
+    const auto value_size = static_cast<uint32_t>(argc > 6 ? strtoul(argv[6], nullptr, 10) : 0);
+    if (records == 0 || theta <= 0 || theta >= 1 || value_size > trace::SIZE_MASK) {
+        fprintf(stderr, "records must be > 0, theta in (0, 1), value_size < 2^28\n");
+        return 1;
+    }
+
+    trace::Trace out;
+    out.num_load = records;
+    out.records.reserve(records + ops);
+    for (uint64_t id = 0; id < records; id++)
+        out.records.push_back({trace::fnv64(id), value_size, trace::INSERT});
+
+    std::mt19937_64 rng(20260602);
+    std::uniform_real_distribution<double> uniform(0.0, 1.0);
+    const trace::Zipfian zipf(records, theta);
+    uint64_t next_id = records; // ids [0, next_id) are inserted
+
+    const auto scrambled = [&] { return trace::fnv64(trace::fnv64(zipf.next(uniform(rng))) % records); };
+    const auto latest = [&] {
+        const auto back = zipf.next(uniform(rng));
+        return trace::fnv64(back < next_id ? next_id - 1 - back : 0);
+    };
+
+    while (out.records.size() < records + ops) {
+        const double u = uniform(rng);
+        switch (workload) {
+        case 'A':
+            out.records.push_back({scrambled(), u < 0.5 ? 0 : value_size, u < 0.5 ? trace::READ : trace::UPDATE});
+            break;
+        case 'B':
+            out.records.push_back({scrambled(), u < 0.95 ? 0 : value_size, u < 0.95 ? trace::READ : trace::UPDATE});
+            break;
+        case 'C':
+            out.records.push_back({scrambled(), 0, trace::READ});
+            break;
+        case 'D':
+            if (u < 0.95)
+                out.records.push_back({latest(), 0, trace::READ});
+            else
+                out.records.push_back({trace::fnv64(next_id++), value_size, trace::INSERT});
+            break;
+        case 'E':
+            if (u < 0.95) {
+                const auto start = zipf.next(uniform(rng)) % next_id;
+                const auto length = 1 + rng() % 100;
+                for (uint64_t i = 0; i < length && out.records.size() < records + ops; i++)
+                    out.records.push_back({trace::fnv64((start + i) % next_id), 0, trace::SCAN});
+            } else {
+                out.records.push_back({trace::fnv64(next_id++), value_size, trace::INSERT});
+            }
+            break;
+        default: // 'F'
+            out.records.push_back({scrambled(), u < 0.5 ? 0 : value_size, u < 0.5 ? trace::READ : trace::RMW});
+            break;
+        }
+    }
+
+    if (!trace::save(argv[2], out)) {
+        fprintf(stderr, "cannot write %s\n", argv[2]);
+        return 1;
+    }
+    printf("workload %c: %llu load + %llu ops -> %s\n", workload, static_cast<unsigned long long>(records),
+           static_cast<unsigned long long>(ops), argv[2]);
+    return 0;
+}
@@ -19,6 +19,8 @@
 #include <unordered_map>
 #include <unordered_set>
 
+#include "perf_counters.h"
+
 #if STR_SIZE < 5
 #define STR_SIZE 15
 #endif
@@ -308,3 +308,86 @@ using emhash_detail::emh_wyhash64;
 #endif // EMH_NO_BUILTIN_WYHASH
 
 #endif // EMH_CONFIG_INCLUDED
+
+// Footprint breakdown returned by memory_usage() of the tables, sets and LRU caches.
+// Outside the EMH_CONFIG_INCLUDED block so a user config does not have to provide it.
+#ifndef EMH_MEMORY_USAGE_DEFINED
+#define EMH_MEMORY_USAGE_DEFINED
+#include <cstddef>
+namespace emhash {
+/// Bytes a container holds for its elements (heap arrays plus any inline small buffer),
+/// split by role. total() is exact for the allocations the container makes itself;
+/// allocator/malloc headers and memory owned by the elements (string buffers) are not
+/// included.
+struct MemoryUsage {
+    size_t entries = 0;  ///< live elements: size() * sizeof(value_type)
+    size_t metadata = 0; ///< per-slot control: links, state bytes, bitmasks, offsets
+    size_t index = 0;    ///< separate index arrays (emhash8 _index)
+    size_t padding = 0;  ///< tail sentinels, simd groups, alignment, unused small buffer
+    size_t slack = 0;    ///< empty element slots: (capacity - size()) * sizeof(value_type)
+
+    size_t total() const { return entries + metadata + index + padding + slack; }
+
+    /// Adds the footprint of a member container, role by role.
+    MemoryUsage& operator+=(const MemoryUsage& other) {
+        entries += other.entries;
+        metadata += other.metadata;
+        index += other.index;
+        padding += other.padding;
+        slack += other.slack;
+        return *this;
+    }
+
+    /// `slots` slots of `slot_bytes`, `filled` of them holding a value of `value_bytes`;
+    /// whatever a slot holds beyond the value (bucket links, order ids) is metadata.
+    void add_slots(size_t slots, size_t filled, size_t slot_bytes, size_t value_bytes) {
+        const size_t payload = value_bytes < slot_bytes ? value_bytes : slot_bytes;
+        entries += filled * payload;
+        slack += (slots - filled) * payload;
+        metadata += slots * (slot_bytes - payload);
+    }
+};
+} // namespace emhash
+#endif // EMH_MEMORY_USAGE_DEFINED
+
+// Thread fan-out shared by the bulk and parallel operations (assign_parallel(),
+// parallel_for_each(), the radix join and group by).
+#ifndef EMH_RUN_PARALLEL_DEFINED
+#define EMH_RUN_PARALLEL_DEFINED
+#include <exception>
+#include <thread>
+#include <vector>
+namespace emhash_detail {
+// Run fn(t) for t in [0, num_threads), t = 0 on the calling thread; rethrows the first
+// exception after all threads have joined.
+template <typename F> void run_parallel(unsigned num_threads, F&& fn) {
+    if (num_threads <= 1) {
+        fn(0u);
+        return;
+    }
+    std::vector<std::exception_ptr> errors(num_threads);
+    std::vector<std::thread> workers;
+    workers.reserve(num_threads);
+    const auto guarded = [&](unsigned t) {
+        try {
+            fn(t);
+        } catch (...) {
+            errors[t] = std::current_exception();
+        }
+    };
+    try {
+        for (unsigned t = 1; t < num_threads; t++)
+            workers.emplace_back(guarded, t);
+    } catch (...) {
+        errors[0] = std::current_exception(); // could not start a thread
+    }
+    if (!errors[0])
+        guarded(0);
+    for (auto& worker : workers)
+        worker.join();
+    for (const auto& error : errors)
+        if (error)
+            std::rethrow_exception(error);
+}
+} // namespace emhash_detail
+#endif // EMH_RUN_PARALLEL_DEFINED
@@ -0,0 +1,253 @@
+// emhash counter map
+// https://github.com/ktprime/emhash
+// SPDX-License-Identifier: MIT
+// Copyright (c) 2019-2026 Huang Yuanbing & bailuzhou AT 163.com
+//
+// A frequency map for word_count style workloads. Keys live in an emhash8::HashSet,
+// whose keys sit in one dense array and keep their slot until an erase moves the last
+// key into the hole. The counts are a parallel array with one byte per key. A count
+// that reaches 255 widens: the byte stays 255 and the full 64 bit count moves into a
+// block of 64 uint64_t counters, allocated the first time one of its 64 slots widens.
+// Hot keys tend to arrive first and share low slots, so few blocks get allocated.
+// Most keys in a long tail are seen only a few times, so a uint64_t key costs about
+// 9 bytes of payload instead of 16 in HashMap<uint64_t, uint32_t>, and a std::string
+// key 33 instead of 40.
+//
+//   increment(key)      one probe: find or append in the set, then bump counts[slot]
+//   top_k(k)            one pass over the count bytes with a k-entry min heap;
+//                       keys are only read for counts that make it into the heap
+
+#pragma once
+
+#include "hash_set8.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <functional>
+#include <iterator>
+#include <limits>
+#include <utility>
+#include <vector>
+
+namespace emhash_counter {
+
+template <typename KeyT, typename HashT = std::hash<KeyT>, typename EqT = std::equal_to<KeyT>> class CountMap {
+    using KeySet = emhash8::HashSet<KeyT, HashT, EqT>;
+
+public:
+    using key_type = KeyT;
+    using count_type = uint64_t;
+    using size_type = typename KeySet::size_type;
+    using value_type = std::pair<KeyT, count_type>;
+
+    /// Byte value that marks a count held in a wide block.
+    static constexpr uint8_t WIDE = 255;
+    /// Slots per lazily allocated block of 64 bit counts.
+    static constexpr size_type WIDE_BLOCK = 64;
+
+    explicit CountMap(size_type bucket = 2) : _keys(bucket) { _small.reserve(bucket); }
+
+    /// Add `delta` to the count of `key` (inserting it at 0 first) and return the new
+    /// count. Counts saturate at UINT64_MAX instead of wrapping.
+    count_type increment(const KeyT& key, count_type delta = 1) {
+        const auto res = _keys.insert(key);
+        const auto slot = static_cast<size_type>(&*res.first - _keys.values());
+        if (res.second)
+            _small.push_back(0);
+        return add(slot, delta);
+    }
+
+    /// increment(key, 1) for every key of a token stream (random access iterators).
+    /// Keys are hashed and their buckets prefetched a batch ahead, see HashSet::insert_each.
+    template <typename RandomIt> void increment_batch(RandomIt first, RandomIt last) {
+        _keys.insert_each(first, last, [this](size_type slot, bool inserted) {
+            if (inserted)
+                _small.push_back(0);
+            add(slot, 1);
+        });
+    }
+
+    void increment_batch(const KeyT* keys, size_t n) { increment_batch(keys, keys + n); }
+
+    /// Subtract `delta` (saturating at 0) and erase the key when its count reaches 0.
+    /// Returns the new count; absent keys return 0.
+    count_type decrement(const KeyT& key, count_type delta = 1) {
+        const auto it = _keys.find(key);
+        if (it == _keys.end())
+            return 0;
+        const auto slot = static_cast<size_type>(&*it - _keys.values());
+        const auto old = count_at(slot);
+        if (old <= delta) {
+            erase_at(it, slot);
+            return 0;
+        }
+        set(slot, old - delta);
+        _total -= delta < _total ? delta : _total;
+        return old - delta;
+    }
+
+    /// Count of `key`, 0 if absent.
+    count_type get(const KeyT& key) const {
+        const auto it = _keys.find(key);
+        return it == _keys.end() ? 0 : count_at(static_cast<size_type>(&*it - _keys.values()));
+    }
+
+    bool contains(const KeyT& key) const { return _keys.contains(key); }
+
+    size_type erase(const KeyT& key) {
+        const auto it = _keys.find(key);
+        if (it == _keys.end())
+            return 0;
+        erase_at(it, static_cast<size_type>(&*it - _keys.values()));
+        return 1;
+    }
+
+    /// The `k` keys with the highest counts, highest first; ties keep no particular order.
+    std::vector<value_type> top_k(size_t k) const {
+        std::vector<std::pair<count_type, size_type>> heap;
+        if (k == 0)
+            return {};
+        heap.reserve(std::min<size_t>(k, size()) + 1);
+        const auto by_count = [](const std::pair<count_type, size_type>& a,
+                                 const std::pair<count_type, size_type>& b) { return a.first > b.first; };
+
+        const auto num = static_cast<size_type>(_small.size());
+        count_type floor = 0; // smallest count in a full heap
+        for (size_type slot = 0; slot < num; slot++) {
+            if (heap.size() == k && _small[slot] <= floor && _small[slot] != WIDE)
+                continue;
+            const auto count = count_at(slot);
+            if (heap.size() < k) {
+                heap.emplace_back(count, slot);
+                std::push_heap(heap.begin(), heap.end(), by_count);
+            } else if (count > heap.front().first) {
+                std::pop_heap(heap.begin(), heap.end(), by_count);
+                heap.back() = {count, slot};
+                std::push_heap(heap.begin(), heap.end(), by_count);
+            } else {
+                continue;
+            }
+            if (heap.size() == k)
+                floor = heap.front().first;
+        }
+
+        std::sort_heap(heap.begin(), heap.end(), by_count);
+        std::vector<value_type> result;
+        result.reserve(heap.size());
+        const auto* keys = _keys.values();
+        for (const auto& entry : heap)
+            result.emplace_back(keys[entry.second], entry.first);
+        return result;
+    }
+
+    /// Call fn(key, count) for every key, in slot order.
+    template <typename F> void for_each(F&& fn) const {
+        const auto num = static_cast<size_type>(_small.size());
+        const auto* keys = _keys.values();
+        for (size_type slot = 0; slot < num; slot++)
+            fn(keys[slot], count_at(slot));
+    }
+
+    void reserve(size_type num_keys) {
+        _keys.reserve(num_keys);
+        _small.reserve(num_keys);
+    }
+
+    void clear() {
+        _keys.clear();
+        _small.clear();
+        _wide.clear();
+        _num_wide = 0;
+        _total = 0;
+    }
+
+    size_type size() const { return _keys.size(); }
+    bool empty() const { return _keys.empty(); }
+    /// Sum of all counts (saturating).
+    count_type total() const { return _total; }
+    /// Keys whose count no longer fits a byte.
+    size_type wide_count() const { return _num_wide; }
+    const KeySet& keys() const { return _keys; }
+
+    /// Footprint of the key set plus the count bytes (one per key) and the wide blocks,
+    /// whose counters in use are entries and the rest of each block slack.
+    emhash::MemoryUsage memory_usage() const {
+        auto usage = _keys.memory_usage();
+        usage.entries += _small.size() + size_t(_num_wide) * sizeof(count_type);
+        usage.slack += _small.capacity() - _small.size();
+        usage.metadata += _wide.capacity() * sizeof(_wide[0]);
+        for (const auto& block : _wide)
+            usage.slack += block.capacity() * sizeof(count_type);
+        usage.slack -= size_t(_num_wide) * sizeof(count_type);
+        return usage;
+    }
+
+private:
+    static count_type sat_add(count_type a, count_type b) {
+        return a > std::numeric_limits<count_type>::max() - b ? std::numeric_limits<count_type>::max() : a + b;
+    }
+
+    count_type count_at(size_type slot) const {
+        const auto small = _small[slot];
+        return small != WIDE ? small : _wide[slot / WIDE_BLOCK][slot % WIDE_BLOCK];
+    }
+
+    count_type& wide_at(size_type slot) {
+        const auto block = slot / WIDE_BLOCK;
+        if (block >= _wide.size())
+            _wide.resize(block + 1);
+        if (_wide[block].empty())
+            _wide[block].resize(WIDE_BLOCK);
+        return _wide[block][slot % WIDE_BLOCK];
+    }
+
+    count_type add(size_type slot, count_type delta) {
+        _total = sat_add(_total, delta);
+        auto& small = _small[slot];
+        if (EMH_LIKELY(small != WIDE && delta < count_type(WIDE) - small)) {
+            small = static_cast<uint8_t>(small + delta);
+            return small;
+        }
+        if (small == WIDE) {
+            auto& wide = _wide[slot / WIDE_BLOCK][slot % WIDE_BLOCK];
+            return wide = sat_add(wide, delta);
+        }
+        const auto count = sat_add(small, delta);
+        set(slot, count);
+        return count;
+    }
+
+    void set(size_type slot, count_type count) {
+        auto& small = _small[slot];
+        if (count < WIDE) {
+            _num_wide -= small == WIDE;
+            small = static_cast<uint8_t>(count);
+        } else {
+            _num_wide += small != WIDE;
+            small = WIDE;
+            wide_at(slot) = count;
+        }
+    }
+
+    template <typename It> void erase_at(It it, size_type slot) {
+        const auto last = static_cast<size_type>(_small.size() - 1);
+        const auto count = count_at(slot);
+        _total -= count < _total ? count : _total;
+        _num_wide -= _small[slot] == WIDE;
+        _keys.erase(it); // moves the last key into `slot`
+        if (slot != last) {
+            _small[slot] = _small[last];
+            if (_small[last] == WIDE)
+                wide_at(slot) = _wide[last / WIDE_BLOCK][last % WIDE_BLOCK];
+        }
+        _small.pop_back();
+    }
+
+    KeySet _keys;
+    std::vector<uint8_t> _small;
+    std::vector<std::vector<count_type>> _wide; // empty until a slot in the block widens
+    size_type _num_wide = 0;
+    count_type _total = 0;
+};
+
+} // namespace emhash_counter
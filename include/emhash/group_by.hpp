@@ -0,0 +1,241 @@
+// emhash parallel hash aggregation (GROUP BY)
+// https://github.com/ktprime/emhash
+// SPDX-License-Identifier: MIT
+// Copyright (c) 2019-2026 Huang Yuanbing & bailuzhou AT 163.com
+//
+// `map[key] += value` over many rows on all cores, without locks and without one shared
+// table that every thread writes to.
+//
+//   add(keys, values, n)   each worker aggregates its slice of the rows into a small local
+//                          table; when that table reaches `spill_groups` groups it is spilled
+//                          into per-partition buffers (the top bits of a mixed key hash pick
+//                          the partition) and cleared. At the end each partition is merged
+//                          into its final table by one worker, so no two threads ever touch
+//                          the same table. A local table that folded fewer than 2 rows per
+//                          group before its spill is not refilled: that worker sends the rest
+//                          of its rows to the partitions one by one. With one worker the rows
+//                          go straight into the final tables.
+//
+// Low-cardinality inputs collapse in the local tables and spill almost nothing; for
+// high-cardinality inputs the spill keeps the local tables cache-sized and the merge
+// stays partition-local. Final tables persist across add() calls, so input can be fed in
+// batches.
+//
+// The aggregate is a functor with a `state_type` and
+//     state_type init() const;                             the state of an empty group
+//     void update(state_type&, const ValueT&) const;       fold one row in
+//     void merge(state_type&, const state_type&) const;    fold another partial state in
+// Sum, Count, Min and Max are provided. The table type defaults to emhash7::HashMap.
+
+#pragma once
+
+#include "hash_table7.hpp"
+#include "radix_partition.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace emhash_agg {
+
+template <typename T> struct Sum {
+    using state_type = T;
+    state_type init() const { return T(); }
+    void update(state_type& s, const T& v) const { s += v; }
+    void merge(state_type& s, const state_type& o) const { s += o; }
+};
+
+/// Number of rows per group; the values are not read.
+template <typename T> struct Count {
+    using state_type = uint64_t;
+    state_type init() const { return 0; }
+    void update(state_type& s, const T&) const { s++; }
+    void merge(state_type& s, const state_type& o) const { s += o; }
+};
+
+template <typename T> struct Min {
+    using state_type = T;
+    state_type init() const { return std::numeric_limits<T>::max(); }
+    void update(state_type& s, const T& v) const { s = v < s ? v : s; }
+    void merge(state_type& s, const state_type& o) const { s = o < s ? o : s; }
+};
+
+template <typename T> struct Max {
+    using state_type = T;
+    state_type init() const { return std::numeric_limits<T>::lowest(); }
+    void update(state_type& s, const T& v) const { s = s < v ? v : s; }
+    void merge(state_type& s, const state_type& o) const { s = s < o ? o : s; }
+};
+
+struct GroupByOptions {
+    unsigned threads = 0;          ///< worker threads, 0: hardware_concurrency()
+    unsigned radix_bits = ~0u;     ///< partitions = 2^radix_bits, ~0u: 4 per thread
+    size_t spill_groups = 1 << 14; ///< groups in a local table before it is spilled
+};
+
+template <typename KeyT, typename ValueT, typename AggT = Sum<ValueT>,
+          typename MapT = emhash7::HashMap<KeyT, typename AggT::state_type>, typename HashT = std::hash<KeyT>>
+class GroupBy {
+public:
+    using key_type = KeyT;
+    using value_type = ValueT;
+    using state_type = typename AggT::state_type;
+    using map_type = MapT;
+
+    static constexpr unsigned MAX_RADIX_BITS = 16;
+
+    explicit GroupBy(const GroupByOptions& options = GroupByOptions(), const AggT& agg = AggT())
+        : _options(options), _agg(agg) {
+        if (_options.threads == 0)
+            _options.threads = std::max(1u, std::thread::hardware_concurrency());
+        _options.spill_groups = std::max<size_t>(1, _options.spill_groups);
+        if (_options.radix_bits <= MAX_RADIX_BITS)
+            _bits = _options.radix_bits;
+        else
+            while (_options.threads > 1 && (1u << _bits) < _options.threads * 4 && _bits < MAX_RADIX_BITS)
+                _bits++;
+        _tables.resize(size_t(1) << _bits);
+    }
+
+    /// Folds rows (keys[i], values[i]), i in [0, n), into the groups.
+    void add(const KeyT* keys, const ValueT* values, size_t n) {
+        const size_t parts = _tables.size();
+        const unsigned num_threads =
+            static_cast<unsigned>(std::max<size_t>(1, std::min<size_t>(_options.threads, n / 4096)));
+        if (num_threads == 1) { // no other writer: fold straight into the final tables
+            for (size_t i = 0; i < n; i++)
+                _agg.update(_tables[part_of(keys[i])].try_emplace(keys[i], _agg.init()).first->second, values[i]);
+            _spilled += n;
+            return;
+        }
+
+        const auto chunk = (n + num_threads - 1) / num_threads;
+        if (_locals.size() < num_threads)
+            _locals.resize(num_threads);
+        std::vector<std::vector<Spill>> spills(num_threads * parts);
+        std::vector<size_t> spilled(num_threads, 0);
+
+        emhash_detail::run_parallel(num_threads, [&](unsigned t) {
+            auto& local = _locals[t];
+            auto* out = &spills[t * parts];
+            size_t rows = 0; // rows folded into the local table since its last spill
+            bool bypass = false;
+            const auto spill = [&]() {
+                for (const auto& kv : local)
+                    out[part_of(kv.first)].emplace_back(kv.first, kv.second);
+                spilled[t] += local.size();
+                // fewer than 2 rows per group: the groups do not repeat within a local table
+                // and pre-aggregating only adds a pass, so hand the rest over row by row
+                bypass = rows < 2 * static_cast<size_t>(local.size());
+                rows = 0;
+                local.clear();
+            };
+            for (auto i = std::min(n, t * chunk), end = std::min(n, (t + 1) * chunk); i < end; i++) {
+                if (bypass) {
+                    auto state = _agg.init();
+                    _agg.update(state, values[i]);
+                    out[part_of(keys[i])].emplace_back(keys[i], state);
+                    spilled[t]++;
+                    continue;
+                }
+                _agg.update(local.try_emplace(keys[i], _agg.init()).first->second, values[i]);
+                rows++;
+                if (static_cast<size_t>(local.size()) >= _options.spill_groups)
+                    spill();
+            }
+            spill();
+        });
+
+        // partition p is merged by one worker from every thread's buffer p
+        emhash_detail::for_each_partition(parts, _options.threads, [&](size_t p, unsigned) {
+            auto& table = _tables[p];
+            for (unsigned t = 0; t < num_threads; t++) {
+                for (const auto& kv : spills[t * parts + p]) {
+                    const auto result = table.try_emplace(kv.first, kv.second);
+                    if (!result.second)
+                        _agg.merge(result.first->second, kv.second);
+                }
+                std::vector<Spill>().swap(spills[t * parts + p]);
+            }
+        });
+
+        for (const auto count : spilled)
+            _spilled += count;
+    }
+
+    void add(const std::vector<KeyT>& keys, const std::vector<ValueT>& values) {
+        add(keys.data(), values.data(), std::min(keys.size(), values.size()));
+    }
+
+    /// The state of `key`'s group, nullptr if no row had that key.
+    const state_type* find(const KeyT& key) const {
+        const auto& table = _tables[part_of(key)];
+        const auto it = table.find(key);
+        return it == table.end() ? nullptr : &it->second;
+    }
+
+    /// fn(const KeyT&, const state_type&) for every group, partition by partition.
+    template <typename F> void for_each(F&& fn) const {
+        for (const auto& table : _tables)
+            for (const auto& kv : table)
+                fn(kv.first, kv.second);
+    }
+
+    size_t size() const noexcept {
+        size_t groups = 0;
+        for (const auto& table : _tables)
+            groups += static_cast<size_t>(table.size());
+        return groups;
+    }
+
+    bool empty() const noexcept { return size() == 0; }
+    size_t partitions() const noexcept { return _tables.size(); }
+    unsigned radix_bits() const noexcept { return _bits; }
+    unsigned threads() const noexcept { return _options.threads; }
+
+    /// Final table of partition p; a key lives in exactly one partition.
+    const MapT& partition(size_t p) const { return _tables[p]; }
+
+    /// Partial states handed from the local tables to the merge so far; close to the row
+    /// count when pre-aggregation does not help, close to size() when it does. Rows folded
+    /// directly by a single worker count as handed over.
+    size_t spilled() const noexcept { return _spilled; }
+
+    /// Drops all groups; the local tables keep their buckets.
+    void clear() {
+        for (auto& table : _tables)
+            table.clear();
+        _spilled = 0;
+    }
+
+    /// Footprint of the final and local tables.
+    emhash::MemoryUsage memory_usage() const noexcept {
+        emhash::MemoryUsage usage;
+        for (const auto& table : _tables)
+            usage += table.memory_usage();
+        for (const auto& local : _locals)
+            usage += local.memory_usage();
+        return usage;
+    }
+
+private:
+    using Spill = std::pair<KeyT, state_type>;
+
+    size_t part_of(const KeyT& key) const noexcept {
+        return emhash_detail::radix_partition(static_cast<uint64_t>(_hasher(key)), _bits);
+    }
+
+    GroupByOptions _options;
+    AggT _agg;
+    HashT _hasher;
+    unsigned _bits = 0;
+    size_t _spilled = 0;
+    std::vector<MapT> _tables; // final groups, one table per partition
+    std::vector<MapT> _locals; // per-thread pre-aggregation tables, empty between add() calls
+};
+
+} // namespace emhash_agg
@@ -0,0 +1,243 @@
+// emhash radix-partitioned hash join
+// https://github.com/ktprime/emhash
+// SPDX-License-Identifier: MIT
+// Copyright (c) 2019-2026 Huang Yuanbing & bailuzhou AT 163.com
+//
+// An equi-join of a build and a probe input of (key, payload) rows that stays in cache
+// when the build side is far larger than the LLC. Both inputs are radix-partitioned on the
+// top bits of a mixed key hash, so each build partition's table plus its rows fits in
+// `partition_bytes` (L2-sized by default), and probe partition p only touches table p.
+//
+//   build(rows, n)         scatter the build rows (one pass per thread, no locks: each
+//                          thread counts, then writes its own range of each partition),
+//                          then build one table per partition on the worker threads;
+//                          duplicate keys chain through a per-row next index
+//   inner/semi/anti(...)   scatter the probe rows the same way, then look up each probe
+//                          partition in batches of `batch` keys and emit the matches
+//
+// The table type is a template parameter mapping key -> uint32_t row, e.g. emhash8::HashMap
+// (default) or emilib2::HashMap. Emit callbacks run concurrently on the worker threads and
+// get the worker index, so they can write to per-thread outputs without locking. Rows are
+// copied, so BuildT and ProbeT should be small (a row id or a pointer for wide rows).
+
+#pragma once
+
+#include "hash_table8.hpp"
+#include "radix_partition.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <functional>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace emhash_join {
+
+enum class JoinType { inner, semi, anti };
+
+struct JoinOptions {
+    unsigned threads = 0;               ///< worker threads, 0: hardware_concurrency()
+    unsigned radix_bits = ~0u;          ///< partitions = 2^radix_bits, ~0u: sized from partition_bytes
+    size_t partition_bytes = 256 << 10; ///< target bytes of one partition's table and build rows
+    unsigned batch = 32;                ///< probe keys looked up before their matches are emitted
+};
+
+template <typename KeyT, typename BuildT, typename ProbeT, typename MapT = emhash8::HashMap<KeyT, uint32_t>,
+          typename HashT = std::hash<KeyT>>
+class RadixJoin {
+public:
+    using key_type = KeyT;
+    using build_row = std::pair<KeyT, BuildT>;
+    using probe_row = std::pair<KeyT, ProbeT>;
+
+    static constexpr unsigned MAX_RADIX_BITS = 16;
+
+    explicit RadixJoin(const JoinOptions& options = JoinOptions()) : _options(options) {
+        if (_options.threads == 0)
+            _options.threads = std::max(1u, std::thread::hardware_concurrency());
+        _options.batch = std::max(1u, _options.batch);
+    }
+
+    /// Partitions rows[0, n) and builds the per-partition tables; replaces any earlier build.
+    void build(const build_row* rows, size_t n) {
+        _bits = _options.radix_bits <= MAX_RADIX_BITS ? _options.radix_bits : auto_bits(n);
+        partition(rows, n, _rows, _bounds);
+        _next.assign(n, NONE);
+        _tables.clear();
+        _tables.resize(_bounds.size() - 1);
+
+        emhash_detail::for_each_partition(_tables.size(), _options.threads, [this](size_t p, unsigned) {
+            const auto first = _bounds[p], last = _bounds[p + 1];
+            auto& table = _tables[p];
+            table.reserve(static_cast<decltype(table.size())>(last - first));
+            for (auto i = first; i < last; i++) {
+                const auto local = static_cast<uint32_t>(i - first);
+                const auto result = table.emplace(_rows[i].first, local);
+                if (!result.second) {
+                    _next[i] = result.first->second;
+                    result.first->second = local;
+                }
+            }
+        });
+    }
+
+    void build(const std::vector<build_row>& rows) { build(rows.data(), rows.size()); }
+
+    /// emit(const build_row&, const probe_row&, unsigned thread) for every matching pair.
+    /// Returns the number of pairs.
+    template <typename F> size_t inner(const probe_row* rows, size_t n, F&& emit) const {
+        return probe<JoinType::inner>(rows, n, emit);
+    }
+
+    /// emit(const probe_row&, unsigned thread) once for each probe row with a match.
+    template <typename F> size_t semi(const probe_row* rows, size_t n, F&& emit) const {
+        return probe<JoinType::semi>(rows, n, emit);
+    }
+
+    /// emit(const probe_row&, unsigned thread) for each probe row without a match.
+    template <typename F> size_t anti(const probe_row* rows, size_t n, F&& emit) const {
+        return probe<JoinType::anti>(rows, n, emit);
+    }
+
+    template <typename F> size_t inner(const std::vector<probe_row>& rows, F&& emit) const {
+        return inner(rows.data(), rows.size(), std::forward<F>(emit));
+    }
+    template <typename F> size_t semi(const std::vector<probe_row>& rows, F&& emit) const {
+        return semi(rows.data(), rows.size(), std::forward<F>(emit));
+    }
+    template <typename F> size_t anti(const std::vector<probe_row>& rows, F&& emit) const {
+        return anti(rows.data(), rows.size(), std::forward<F>(emit));
+    }
+
+    size_t build_size() const noexcept { return _rows.size(); }
+    size_t partitions() const noexcept { return _tables.size(); }
+    unsigned radix_bits() const noexcept { return _bits; }
+    unsigned threads() const noexcept { return _options.threads; }
+
+    /// Footprint of the partitioned build side: all tables, plus the build rows (spare
+    /// capacity as slack) and their chain links (metadata).
+    emhash::MemoryUsage memory_usage() const noexcept {
+        emhash::MemoryUsage usage;
+        for (const auto& table : _tables)
+            usage += table.memory_usage();
+        usage.entries += _rows.size() * sizeof(build_row);
+        usage.slack += (_rows.capacity() - _rows.size()) * sizeof(build_row);
+        usage.metadata += _next.capacity() * sizeof(uint32_t);
+        return usage;
+    }
+
+private:
+    static constexpr uint32_t NONE = UINT32_MAX;
+
+    size_t part_of(const KeyT& key) const noexcept {
+        return emhash_detail::radix_partition(static_cast<uint64_t>(_hasher(key)), _bits);
+    }
+
+    // Enough partitions for partition_bytes each (a row, its link and ~2 table slots per
+    // build row), and at least 4 per thread once the input is large enough to split.
+    unsigned auto_bits(size_t n) const noexcept {
+        const size_t row_bytes = sizeof(build_row) + sizeof(uint32_t) + 2 * sizeof(std::pair<KeyT, uint32_t>);
+        size_t parts = n * row_bytes / std::max<size_t>(1, _options.partition_bytes) + 1;
+        if (_options.threads > 1 && n >= size_t(_options.threads) * 4 * 1024)
+            parts = std::max(parts, size_t(_options.threads) * 4);
+        unsigned bits = 0;
+        while ((size_t(1) << bits) < parts && bits < MAX_RADIX_BITS)
+            bits++;
+        return bits;
+    }
+
+    // rows[0, n) -> out, grouped by partition; partition p is out[bounds[p], bounds[p + 1]).
+    template <typename Row> void partition(const Row* rows, size_t n, std::vector<Row>& out,
+                                           std::vector<size_t>& bounds) const {
+        const size_t parts = size_t(1) << _bits;
+        const unsigned num_threads =
+            static_cast<unsigned>(std::max<size_t>(1, std::min<size_t>(_options.threads, n / 4096)));
+        const auto chunk = (n + num_threads - 1) / num_threads;
+        std::vector<size_t> offsets(num_threads * parts, 0);
+
+        emhash_detail::run_parallel(num_threads, [&](unsigned t) {
+            auto* count = &offsets[t * parts];
+            for (auto i = std::min(n, t * chunk), end = std::min(n, (t + 1) * chunk); i < end; i++)
+                count[part_of(rows[i].first)]++;
+        });
+
+        bounds.assign(parts + 1, 0);
+        size_t sum = 0;
+        for (size_t p = 0; p < parts; p++) {
+            bounds[p] = sum;
+            for (unsigned t = 0; t < num_threads; t++) {
+                const auto count = offsets[t * parts + p];
+                offsets[t * parts + p] = sum;
+                sum += count;
+            }
+        }
+        bounds[parts] = sum;
+
+        out.resize(n);
+        emhash_detail::run_parallel(num_threads, [&](unsigned t) {
+            auto* offset = &offsets[t * parts];
+            for (auto i = std::min(n, t * chunk), end = std::min(n, (t + 1) * chunk); i < end; i++)
+                out[offset[part_of(rows[i].first)]++] = rows[i];
+        });
+    }
+
+    template <JoinType Type, typename F> size_t probe(const probe_row* rows, size_t n, F& emit) const {
+        if (_tables.empty()) { // nothing built: no row matches
+            if constexpr (Type == JoinType::anti) {
+                for (size_t i = 0; i < n; i++)
+                    emit(rows[i], 0u);
+                return n;
+            }
+            return 0;
+        }
+        std::vector<probe_row> parted;
+        std::vector<size_t> bounds;
+        partition(rows, n, parted, bounds);
+
+        std::vector<size_t> counts(_options.threads, 0);
+        emhash_detail::for_each_partition(_tables.size(), _options.threads, [&](size_t p, unsigned t) {
+            const auto& table = _tables[p];
+            const auto* build = _rows.data() + _bounds[p];
+            const auto* next = _next.data() + _bounds[p];
+            uint32_t heads[256];
+            const auto batch = std::min(_options.batch, 256u);
+            size_t count = 0;
+
+            for (auto i = bounds[p], last = bounds[p + 1]; i < last; i += batch) {
+                const auto m = static_cast<unsigned>(std::min<size_t>(batch, last - i));
+                // lookups first, so independent probes overlap; matches after
+                for (unsigned j = 0; j < m; j++) {
+                    const auto it = table.find(parted[i + j].first);
+                    heads[j] = it == table.end() ? NONE : it->second;
+                }
+                for (unsigned j = 0; j < m; j++) {
+                    const auto& row = parted[i + j];
+                    if constexpr (Type == JoinType::inner) {
+                        for (auto h = heads[j]; h != NONE; h = next[h], count++)
+                            emit(build[h], row, t);
+                    } else if ((heads[j] != NONE) == (Type == JoinType::semi)) {
+                        emit(row, t);
+                        count++;
+                    }
+                }
+            }
+            counts[t] += count;
+        });
+
+        size_t total = 0;
+        for (const auto count : counts)
+            total += count;
+        return total;
+    }
+
+    JoinOptions _options;
+    HashT _hasher;
+    unsigned _bits = 0;
+    std::vector<build_row> _rows;    // build rows grouped by partition
+    std::vector<size_t> _bounds;     // partition p is _rows[_bounds[p], _bounds[p + 1])
+    std::vector<uint32_t> _next;     // next row of the same key within the partition
+    std::vector<MapT> _tables;       // key -> first row of the key, per partition
+};
+
+} // namespace emhash_join
@@ -0,0 +1,600 @@
+// emhash7::HashMultiMap for C++17/20
+// https://github.com/ktprime/emhash
+// SPDX-License-Identifier: MIT
+// Copyright (c) 2020-2026 Huang Yuanbing & bailuzhou AT 163.com
+//
+// A multimap on emhash7's linked-bucket layout: every element sits in its own bucket with
+// a link to the next bucket of its chain, and a chain holds exactly the keys of one main
+// bucket. Duplicate keys are kept as one run of adjacent chain entries, so
+//
+//   equal_range(key)   finds the first entry of the run and walks just that run
+//   count(key)         is the same walk, one pass and no second lookup
+//   insert(key, val)   links the new entry right behind the first entry of its run
+//   erase(key)         unlinks the whole run at once
+//
+// Compared with emhash7::HashMap<K, std::vector<V>> this saves the vector's heap block and
+// the extra cache miss to reach it; the key is stored once per value instead. The values of
+// one key come back in no particular order; a rehash keeps their relative order.
+
+#pragma once
+
+#include "hash_table7.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <functional>
+#include <initializer_list>
+#include <iterator>
+#include <memory>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace emhash7 {
+
+/// @brief Multimap (duplicate keys allowed) with emhash7's no-tombstone linked buckets.
+///
+/// @tparam KeyT    Key type
+/// @tparam ValueT  Mapped value type
+/// @tparam HashT   Hash functor (default: std::hash<KeyT>)
+/// @tparam EqT     Key equality functor (default: std::equal_to<KeyT>)
+/// @tparam AllocT  Allocator type (default: std::allocator<std::pair<KeyT, ValueT>>)
+template <typename KeyT, typename ValueT, typename HashT = std::hash<KeyT>, typename EqT = std::equal_to<KeyT>,
+          typename AllocT = std::allocator<std::pair<KeyT, ValueT>>>
+class HashMultiMap {
+public:
+    using htype = HashMultiMap<KeyT, ValueT, HashT, EqT, AllocT>;
+    using key_type = KeyT;
+    using mapped_type = ValueT;
+    using value_type = std::pair<KeyT, ValueT>;
+    using value_pair = entry<KeyT, ValueT>;
+    using size_type = emhash7::size_type;
+    using hasher = HashT;
+    using key_equal = EqT;
+    using allocator_type = AllocT;
+
+    constexpr static float DEFAULT_LOAD_FACTOR = 0.80f;
+
+private:
+    using PairT = value_pair;
+    using PairAlloc = typename std::allocator_traits<AllocT>::template rebind_alloc<PairT>;
+    using PairAllocTraits = std::allocator_traits<PairAlloc>;
+
+    static constexpr size_type SIZE_BIT = sizeof(size_t) * 8;
+
+public:
+    /// Visits every element in bucket order.
+    template <bool IsConst> class table_iterator {
+    public:
+        using iterator_category = std::forward_iterator_tag;
+        using difference_type = std::ptrdiff_t;
+        using value_type = value_pair;
+        using pointer = std::conditional_t<IsConst, const value_pair*, value_pair*>;
+        using reference = std::conditional_t<IsConst, const value_pair&, value_pair&>;
+        using map_pointer = std::conditional_t<IsConst, const htype*, htype*>;
+
+        table_iterator() = default;
+        table_iterator(map_pointer map, size_type bucket) : _map(map), _bucket(bucket) {}
+        template <bool C = IsConst, typename = std::enable_if_t<C>>
+        table_iterator(const table_iterator<false>& it) : _map(it._map), _bucket(it._bucket) {}
+
+        reference operator*() const { return _map->_pairs[_bucket]; }
+        pointer operator->() const { return &_map->_pairs[_bucket]; }
+
+        table_iterator& operator++() {
+            _bucket = _map->next_filled(_bucket + 1);
+            return *this;
+        }
+
+        table_iterator operator++(int) {
+            auto old = *this;
+            ++*this;
+            return old;
+        }
+
+        bool operator==(const table_iterator& rhs) const { return _bucket == rhs._bucket; }
+        bool operator!=(const table_iterator& rhs) const { return _bucket != rhs._bucket; }
+        size_type bucket() const { return _bucket; }
+
+    private:
+        template <bool> friend class table_iterator;
+        map_pointer _map = nullptr;
+        size_type _bucket = 0;
+    };
+
+    /// Follows chain links; equal_range() hands out a pair of these around one key's run.
+    template <bool IsConst> class chain_iterator {
+    public:
+        using iterator_category = std::forward_iterator_tag;
+        using difference_type = std::ptrdiff_t;
+        using value_type = value_pair;
+        using pointer = std::conditional_t<IsConst, const value_pair*, value_pair*>;
+        using reference = std::conditional_t<IsConst, const value_pair&, value_pair&>;
+        using map_pointer = std::conditional_t<IsConst, const htype*, htype*>;
+
+        chain_iterator() = default;
+        chain_iterator(map_pointer map, size_type bucket) : _map(map), _bucket(bucket) {}
+        template <bool C = IsConst, typename = std::enable_if_t<C>>
+        chain_iterator(const chain_iterator<false>& it) : _map(it._map), _bucket(it._bucket) {}
+
+        reference operator*() const { return _map->_pairs[_bucket]; }
+        pointer operator->() const { return &_map->_pairs[_bucket]; }
+
+        chain_iterator& operator++() {
+            const auto next_bucket = _map->_pairs[_bucket].bucket;
+            _bucket = next_bucket == _bucket ? INACTIVE : next_bucket;
+            return *this;
+        }
+
+        chain_iterator operator++(int) {
+            auto old = *this;
+            ++*this;
+            return old;
+        }
+
+        bool operator==(const chain_iterator& rhs) const { return _bucket == rhs._bucket; }
+        bool operator!=(const chain_iterator& rhs) const { return _bucket != rhs._bucket; }
+        size_type bucket() const { return _bucket; }
+
+    private:
+        template <bool> friend class chain_iterator;
+        map_pointer _map = nullptr;
+        size_type _bucket = INACTIVE;
+    };
+
+    using iterator = table_iterator<false>;
+    using const_iterator = table_iterator<true>;
+    using range_iterator = chain_iterator<false>;
+    using const_range_iterator = chain_iterator<true>;
+
+    // ------------------------------------------------------------
+    explicit HashMultiMap(size_type bucket = 2, float mlf = DEFAULT_LOAD_FACTOR) noexcept(false) {
+        max_load_factor(mlf);
+        reserve(bucket);
+    }
+
+    HashMultiMap(std::initializer_list<value_type> ilist) : HashMultiMap(static_cast<size_type>(ilist.size())) {
+        for (const auto& kv : ilist)
+            emplace(kv.first, kv.second);
+    }
+
+    HashMultiMap(const HashMultiMap& rhs)
+        : _empty(rhs._empty), _mask(rhs._mask), _num_buckets(rhs._num_buckets), _mlf(rhs._mlf),
+          _hasher(rhs._hasher), _eq(rhs._eq), _alloc(rhs._alloc) {
+        if (_num_buckets == 0)
+            return;
+        _pairs = PairAllocTraits::allocate(_alloc, _num_buckets);
+        try {
+            for (auto bucket = next_filled(0); bucket < _num_buckets; bucket = next_filled(bucket + 1)) {
+                new (_pairs + bucket) PairT(rhs._pairs[bucket]);
+                _num_filled++;
+            }
+        } catch (...) {
+            auto bucket = next_filled(0);
+            for (size_type done = 0; done < _num_filled; done++, bucket = next_filled(bucket + 1))
+                _pairs[bucket].~PairT();
+            PairAllocTraits::deallocate(_alloc, _pairs, _num_buckets);
+            throw;
+        }
+    }
+
+    HashMultiMap(HashMultiMap&& rhs) noexcept { swap(rhs); }
+
+    HashMultiMap& operator=(const HashMultiMap& rhs) {
+        if (this != &rhs) {
+            HashMultiMap copy(rhs);
+            swap(copy);
+        }
+        return *this;
+    }
+
+    HashMultiMap& operator=(HashMultiMap&& rhs) noexcept {
+        if (this != &rhs) {
+            HashMultiMap tmp(std::move(rhs));
+            swap(tmp);
+        }
+        return *this;
+    }
+
+    ~HashMultiMap() noexcept {
+        destroy_all();
+        if (_pairs)
+            PairAllocTraits::deallocate(_alloc, _pairs, _num_buckets);
+    }
+
+    void swap(HashMultiMap& rhs) noexcept {
+        std::swap(_pairs, rhs._pairs);
+        std::swap(_empty, rhs._empty);
+        std::swap(_mask, rhs._mask);
+        std::swap(_num_buckets, rhs._num_buckets);
+        std::swap(_num_filled, rhs._num_filled);
+        std::swap(_mlf, rhs._mlf);
+        std::swap(_hasher, rhs._hasher);
+        std::swap(_eq, rhs._eq);
+        std::swap(_alloc, rhs._alloc);
+    }
+
+    // ------------------------------------------------------------
+    iterator begin() noexcept { return {this, _num_filled ? next_filled(0) : _num_buckets}; }
+    const_iterator begin() const noexcept { return {this, _num_filled ? next_filled(0) : _num_buckets}; }
+    const_iterator cbegin() const noexcept { return begin(); }
+    iterator end() noexcept { return {this, _num_buckets}; }
+    const_iterator end() const noexcept { return {this, _num_buckets}; }
+    const_iterator cend() const noexcept { return end(); }
+
+    size_type size() const noexcept { return _num_filled; }
+    bool empty() const noexcept { return _num_filled == 0; }
+    size_type bucket_count() const noexcept { return _num_buckets; }
+    float load_factor() const noexcept { return _num_buckets ? static_cast<float>(_num_filled) / _num_buckets : 0.0f; }
+    float max_load_factor() const noexcept { return _mlf; }
+
+    void max_load_factor(float mlf) noexcept {
+        if (mlf > 0.2f && mlf < 0.999f)
+            _mlf = mlf;
+    }
+
+    HashT hash_function() const { return _hasher; }
+    EqT key_eq() const { return _eq; }
+
+    // ------------------------------------------------------------
+    /// Insert (key, val), also when key is already present. Returns an iterator to it.
+    template <typename K, typename V> iterator emplace(K&& key, V&& val) {
+        check_expand_need();
+        const auto main_bucket = hash_main(key);
+        size_type link;
+        const auto bucket = allocate_bucket(key, main_bucket, link);
+        new (_pairs + bucket) PairT(std::forward<K>(key), std::forward<V>(val), link);
+        set_filled(bucket);
+        _num_filled++;
+        return {this, bucket};
+    }
+
+    iterator insert(const value_type& value) { return emplace(value.first, value.second); }
+    iterator insert(value_type&& value) { return emplace(std::move(value.first), std::move(value.second)); }
+
+    template <typename Iter> void insert(Iter first, Iter last) {
+        for (; first != last; ++first)
+            emplace(first->first, first->second);
+    }
+
+    // ------------------------------------------------------------
+    /// Number of values stored under key: one walk to the end of its run.
+    size_type count(const KeyT& key) const noexcept {
+        auto bucket = find_first(key);
+        if (bucket == INACTIVE)
+            return 0;
+        size_type num = 1;
+        for (auto next_bucket = _pairs[bucket].bucket; next_bucket != bucket; next_bucket = _pairs[bucket].bucket) {
+            if (!_eq(key, _pairs[next_bucket].first))
+                break;
+            bucket = next_bucket;
+            num++;
+        }
+        return num;
+    }
+
+    bool contains(const KeyT& key) const noexcept { return find_first(key) != INACTIVE; }
+
+    /// The first value stored under key, or end().
+    iterator find(const KeyT& key) noexcept {
+        const auto bucket = find_first(key);
+        return {this, bucket == INACTIVE ? _num_buckets : bucket};
+    }
+
+    const_iterator find(const KeyT& key) const noexcept {
+        const auto bucket = find_first(key);
+        return {this, bucket == INACTIVE ? _num_buckets : bucket};
+    }
+
+    /// All values stored under key, as a walk along its run; empty when key is absent.
+    std::pair<range_iterator, range_iterator> equal_range(const KeyT& key) noexcept {
+        const auto range = find_run(key);
+        return {{this, range.first}, {this, range.second}};
+    }
+
+    std::pair<const_range_iterator, const_range_iterator> equal_range(const KeyT& key) const noexcept {
+        const auto range = find_run(key);
+        return {{this, range.first}, {this, range.second}};
+    }
+
+    // ------------------------------------------------------------
+    /// Erase every value of key; returns how many there were.
+    size_type erase(const KeyT& key) {
+        if (_num_filled == 0)
+            return 0;
+        const auto main_bucket = hash_main(key);
+        if (is_empty(main_bucket))
+            return 0;
+
+        auto prev_bucket = INACTIVE, first = main_bucket;
+        while (!_eq(key, _pairs[first].first)) {
+            const auto next_bucket = _pairs[first].bucket;
+            if (next_bucket == first)
+                return 0;
+            prev_bucket = first;
+            first = next_bucket;
+        }
+
+        // unlink [first, last] from the chain, then clear it
+        auto last = first;
+        size_type num = 1;
+        for (auto next_bucket = _pairs[last].bucket; next_bucket != last && _eq(key, _pairs[next_bucket].first);
+             next_bucket = _pairs[last].bucket) {
+            last = next_bucket;
+            num++;
+        }
+        const auto after = _pairs[last].bucket == last ? INACTIVE : _pairs[last].bucket;
+
+        if (prev_bucket != INACTIVE)
+            _pairs[prev_bucket].bucket = after == INACTIVE ? prev_bucket : after;
+        for (auto bucket = first;;) {
+            const auto next_bucket = _pairs[bucket].bucket;
+            if (bucket != main_bucket || after == INACTIVE)
+                clear_bucket(bucket);
+            if (bucket == last)
+                break;
+            bucket = next_bucket;
+        }
+
+        // the run held the chain's head and more keys follow: pull the next one into the head
+        if (prev_bucket == INACTIVE && after != INACTIVE) {
+            _pairs[main_bucket] = std::move(_pairs[after]);
+            if (_pairs[main_bucket].bucket == after)
+                _pairs[main_bucket].bucket = main_bucket;
+            clear_bucket(after);
+        }
+        return num;
+    }
+
+    /// Erase one (key, val) element; returns 0 if there is none.
+    size_type erase(const KeyT& key, const ValueT& val) {
+        if (_num_filled == 0)
+            return 0;
+        const auto main_bucket = hash_main(key);
+        if (is_empty(main_bucket))
+            return 0;
+
+        for (auto bucket = main_bucket;;) {
+            if (_eq(key, _pairs[bucket].first) && _pairs[bucket].second == val) {
+                erase_bucket(bucket, main_bucket);
+                return 1;
+            }
+            const auto next_bucket = _pairs[bucket].bucket;
+            if (next_bucket == bucket)
+                return 0;
+            bucket = next_bucket;
+        }
+    }
+
+    void clear() noexcept {
+        destroy_all();
+        std::fill(_empty.begin(), _empty.end() - (_empty.empty() ? 0 : 1), ~size_t(0));
+        _num_filled = 0;
+    }
+
+    /// Make room for num_elems elements without another rehash.
+    void reserve(size_type num_elems) {
+        if (num_elems + 1 > static_cast<uint64_t>(_num_buckets * _mlf))
+            rehash(num_elems);
+    }
+
+    /// Rebuild for at least num_elems elements (and at least size()), chain by chain so each
+    /// key's run keeps its order.
+    void rehash(size_type num_elems) {
+        num_elems = std::max(num_elems, _num_filled);
+        uint64_t buckets = SIZE_BIT;
+        while (static_cast<double>(buckets) * _mlf < num_elems + 1.0)
+            buckets *= 2;
+
+        auto* const old_pairs = _pairs;
+        auto old_empty = std::move(_empty);
+        const auto old_num_buckets = _num_buckets;
+
+        _pairs = PairAllocTraits::allocate(_alloc, static_cast<size_type>(buckets));
+        _empty.assign(buckets / SIZE_BIT + 1, ~size_t(0));
+        _empty.back() = 0; // stops next_filled() at bucket_count()
+        _num_buckets = static_cast<size_type>(buckets);
+        _mask = _num_buckets - 1;
+        _num_filled = 0;
+        if (old_pairs == nullptr)
+            return;
+
+        const auto old_filled = [&](size_type bucket) {
+            return (old_empty[bucket / SIZE_BIT] >> (bucket % SIZE_BIT) & 1) == 0;
+        };
+        std::vector<uint8_t> linked(old_num_buckets);
+        for (size_type bucket = 0; bucket < old_num_buckets; bucket++) {
+            if (old_filled(bucket) && old_pairs[bucket].bucket != bucket)
+                linked[old_pairs[bucket].bucket] = 1;
+        }
+
+        for (size_type head = 0; head < old_num_buckets; head++) {
+            if (!old_filled(head) || linked[head])
+                continue;
+            auto prev_new = INACTIVE;
+            for (auto bucket = head;;) {
+                auto& pair = old_pairs[bucket];
+                size_type link;
+                const auto new_bucket = prev_new != INACTIVE && _eq(pair.first, _pairs[prev_new].first)
+                                            ? link_after(prev_new, link)
+                                            : allocate_bucket(pair.first, hash_main(pair.first), link);
+                new (_pairs + new_bucket) PairT(std::move(pair.first), std::move(pair.second), link);
+                set_filled(new_bucket);
+                _num_filled++;
+                prev_new = new_bucket;
+
+                const auto next_bucket = pair.bucket;
+                pair.~PairT();
+                if (next_bucket == bucket)
+                    break;
+                bucket = next_bucket;
+            }
+        }
+        PairAllocTraits::deallocate(_alloc, old_pairs, old_num_buckets);
+    }
+
+private:
+    template <typename K> size_type hash_main(const K& key) const {
+        if constexpr (std::is_same<K, std::string>::value) {
+#if EMH_WY_HASH
+            return static_cast<size_type>(emh_wyhash(key.data(), key.size(), 0)) & _mask;
+#else
+            return static_cast<size_type>(_hasher(key)) & _mask;
+#endif
+        } else {
+            return static_cast<size_type>(_hasher(key)) & _mask;
+        }
+    }
+
+    bool is_empty(size_type bucket) const { return (_empty[bucket / SIZE_BIT] >> (bucket % SIZE_BIT) & 1) != 0; }
+    void set_filled(size_type bucket) { _empty[bucket / SIZE_BIT] &= ~(size_t(1) << (bucket % SIZE_BIT)); }
+
+    void clear_bucket(size_type bucket) {
+        _pairs[bucket].~PairT();
+        _empty[bucket / SIZE_BIT] |= size_t(1) << (bucket % SIZE_BIT);
+        _num_filled--;
+    }
+
+    void destroy_all() noexcept {
+        if (std::is_trivially_destructible<PairT>::value || _num_filled == 0)
+            return;
+        for (auto bucket = next_filled(0); bucket < _num_buckets; bucket = next_filled(bucket + 1))
+            _pairs[bucket].~PairT();
+    }
+
+    void check_expand_need() {
+        if (_num_filled + 1 > static_cast<uint64_t>(_num_buckets * _mlf))
+            rehash(_num_filled + 1);
+    }
+
+    // First filled bucket at or after bucket; the zero word after the bitmap stops the scan.
+    size_type next_filled(size_type bucket) const {
+        auto word = bucket / SIZE_BIT;
+        auto bits = ~_empty[word] >> (bucket % SIZE_BIT);
+        if (bits != 0)
+            return bucket + CTZ(bits);
+        while ((bits = ~_empty[++word]) == 0) {
+        }
+        return word * SIZE_BIT + CTZ(bits);
+    }
+
+    // Nearest empty bucket from bucket_from on, wrapping around; the load factor keeps one.
+    size_type find_empty_bucket(size_type bucket_from) const {
+        auto word = bucket_from / SIZE_BIT;
+        const auto bits = _empty[word] >> (bucket_from % SIZE_BIT);
+        if (bits != 0)
+            return bucket_from + CTZ(bits);
+        const auto qmask = _mask / SIZE_BIT;
+        for (;;) {
+            word = (word + 1) & qmask;
+            if (_empty[word] != 0)
+                return word * SIZE_BIT + CTZ(_empty[word]);
+        }
+    }
+
+    size_type find_prev_bucket(size_type main_bucket, size_type bucket) const {
+        auto prev_bucket = main_bucket;
+        while (_pairs[prev_bucket].bucket != bucket)
+            prev_bucket = _pairs[prev_bucket].bucket;
+        return prev_bucket;
+    }
+
+    // Take an empty bucket for an entry linked right behind bucket; link gets its next link.
+    size_type link_after(size_type bucket, size_type& link) {
+        const auto new_bucket = find_empty_bucket(bucket);
+        const auto next_bucket = _pairs[bucket].bucket;
+        link = next_bucket == bucket ? new_bucket : next_bucket;
+        _pairs[bucket].bucket = new_bucket;
+        return new_bucket;
+    }
+
+    // Find the bucket for a new entry of key: its main bucket when that is free or held by
+    // a guest from another chain (which moves out), else behind the first entry of key's
+    // run, else at the chain's tail.
+    size_type allocate_bucket(const KeyT& key, size_type main_bucket, size_type& link) {
+        link = main_bucket;
+        if (is_empty(main_bucket))
+            return main_bucket;
+
+        const auto kmain = hash_main(_pairs[main_bucket].first);
+        if (kmain != main_bucket) {
+            const auto prev_bucket = find_prev_bucket(kmain, main_bucket);
+            const auto new_bucket = find_empty_bucket(main_bucket);
+            const auto next_bucket = _pairs[main_bucket].bucket;
+            new (_pairs + new_bucket) PairT(std::move(_pairs[main_bucket]));
+            _pairs[new_bucket].bucket = next_bucket == main_bucket ? new_bucket : next_bucket;
+            set_filled(new_bucket);
+            _pairs[prev_bucket].bucket = new_bucket;
+            _pairs[main_bucket].~PairT();
+            return main_bucket;
+        }
+
+        auto bucket = main_bucket;
+        while (!_eq(key, _pairs[bucket].first)) {
+            const auto next_bucket = _pairs[bucket].bucket;
+            if (next_bucket == bucket)
+                break;
+            bucket = next_bucket;
+        }
+        return link_after(bucket, link);
+    }
+
+    // Unlink and clear the element in bucket, whose key belongs to main_bucket's chain.
+    void erase_bucket(size_type bucket, size_type main_bucket) {
+        const auto next_bucket = _pairs[bucket].bucket;
+        if (bucket != main_bucket) {
+            const auto prev_bucket = find_prev_bucket(main_bucket, bucket);
+            _pairs[prev_bucket].bucket = next_bucket == bucket ? prev_bucket : next_bucket;
+            clear_bucket(bucket);
+        } else if (next_bucket == bucket) {
+            clear_bucket(bucket);
+        } else {
+            _pairs[bucket] = std::move(_pairs[next_bucket]);
+            if (_pairs[bucket].bucket == next_bucket)
+                _pairs[bucket].bucket = bucket;
+            clear_bucket(next_bucket);
+        }
+    }
+
+    size_type find_first(const KeyT& key) const noexcept {
+        if (_num_filled == 0)
+            return INACTIVE;
+        auto bucket = hash_main(key);
+        if (is_empty(bucket))
+            return INACTIVE;
+        while (!_eq(key, _pairs[bucket].first)) {
+            const auto next_bucket = _pairs[bucket].bucket;
+            if (next_bucket == bucket)
+                return INACTIVE;
+            bucket = next_bucket;
+        }
+        return bucket;
+    }
+
+    // {first bucket of key's run, bucket behind the run or INACTIVE}
+    std::pair<size_type, size_type> find_run(const KeyT& key) const noexcept {
+        const auto first = find_first(key);
+        if (first == INACTIVE)
+            return {INACTIVE, INACTIVE};
+        for (auto bucket = first;;) {
+            const auto next_bucket = _pairs[bucket].bucket;
+            if (next_bucket == bucket)
+                return {first, INACTIVE};
+            if (!_eq(key, _pairs[next_bucket].first))
+                return {first, next_bucket};
+            bucket = next_bucket;
+        }
+    }
+
+    PairT* _pairs = nullptr;
+    std::vector<size_t> _empty; // one bit per bucket, set when empty
+    size_type _mask = 0;
+    size_type _num_buckets = 0;
+    size_type _num_filled = 0;
+    float _mlf = DEFAULT_LOAD_FACTOR;
+    HashT _hasher;
+    EqT _eq;
+    PairAlloc _alloc;
+};
+
+} // namespace emhash7
@@ -369,6 +369,16 @@ public:
     constexpr uint64_t max_size() const { return (1ull << (sizeof(_num_buckets) * 8 - 1)); }
     constexpr uint64_t max_bucket_count() const { return max_size(); }
 
+    /// Bytes by role: buckets (links are metadata) and the two tail sentinels as padding.
+    emhash::MemoryUsage memory_usage() const noexcept {
+        emhash::MemoryUsage usage;
+        if (_pairs) {
+            usage.add_slots(_num_buckets, _num_filled, sizeof(PairT), sizeof(value_type));
+            usage.padding += 2 * sizeof(PairT);
+        }
+        return usage;
+    }
+
 #ifndef TEST_TIMER_FEATURE
     int64_t fast_search(int64_t key, size_type buckets) const {
         auto min_key = key + buckets - 1;
@@ -412,6 +412,17 @@ public:
     constexpr uint64_t max_size() const { return (1ull << (sizeof(_total_buckets) * 8 - 1)); }
     constexpr uint64_t max_bucket_count() const { return max_size(); }
 
+    /// Bytes by role: main and collision buckets (links are metadata) and the two tail
+    /// sentinels as padding.
+    emhash::MemoryUsage memory_usage() const noexcept {
+        emhash::MemoryUsage usage;
+        if (_pairs && _total_buckets > 0) {
+            usage.add_slots(_total_buckets, size(), sizeof(PairT), sizeof(value_type));
+            usage.padding += 2 * sizeof(PairT);
+        }
+        return usage;
+    }
+
     // Returns the bucket number where the element with key k is located.
     size_type bucket(const KeyT& key) const { return hash_main_bucket(key); }
 
@@ -501,6 +501,18 @@ public:
     constexpr uint64_t max_size() const { return (1ull << (sizeof(_num_buckets) * 8 - 1)); }
     constexpr uint64_t max_bucket_count() const { return max_size(); }
 
+    /// Bytes by role: buckets (links are metadata), the empty-bucket bitmask, and as padding
+    /// the two tail sentinels, the bitmask tail word and rounding to whole buckets.
+    emhash::MemoryUsage memory_usage() const noexcept {
+        emhash::MemoryUsage usage;
+        if (!_pairs)
+            return usage;
+        usage.add_slots(_num_buckets, _num_filled, sizeof(PairT), sizeof(value_type));
+        usage.metadata += _num_buckets / 8;
+        usage.padding = static_cast<size_t>(alloc_count(_num_buckets)) * sizeof(PairT) - usage.total();
+        return usage;
+    }
+
     size_type bucket_main() const {
         size_type bucket_size = 0;
         for (size_type bucket = 0; bucket < _num_buckets; ++bucket) {
@@ -47,6 +47,10 @@
 #include <iterator>
 #include <algorithm>
 #include <memory>
+#include <exception>
+#include <random>
+#include <thread>
+#include <vector>
 
 #if defined(_M_IX86) || defined(_M_X64) || defined(__i386__) || defined(__x86_64__)
 #include <xmmintrin.h>
@@ -112,6 +116,11 @@ public:
     constexpr static size_type RESERVE_SLOTS = 2;
     // Extra capacity buffer for pairs allocation (prevents frequent realloc on growth)
     constexpr static size_type PAIRS_CAPACITY_BUFFER = 4;
+    // Keys hashed and prefetched ahead of the probes in the set algebra functions
+    constexpr static size_type PROBE_BATCH = 16;
+    // Smallest and preferred bucket range one assign_parallel() worker builds at a time
+    constexpr static size_type PARALLEL_MIN_BUCKETS = 1u << 12;
+    constexpr static size_type PARALLEL_RANGE_BUCKETS = 1u << 16;
 
     struct Index {
         size_type next;
@@ -482,6 +491,18 @@ public:
     constexpr uint64_t max_size() const noexcept { return 1ull << (sizeof(_num_buckets) * 8 - 1); }
     constexpr uint64_t max_bucket_count() const noexcept { return max_size(); }
 
+    /// Bytes by role: the dense value array (unused capacity is slack), the bucket index and
+    /// its EAD tail entries as padding.
+    emhash::MemoryUsage memory_usage() const noexcept {
+        emhash::MemoryUsage usage;
+        usage.add_slots(_pairs ? _pairs_capacity : 0, _num_filled, sizeof(value_type), sizeof(value_type));
+        if (_index) {
+            usage.index += static_cast<size_t>(_num_buckets) * sizeof(Index);
+            usage.padding += EAD * sizeof(Index);
+        }
+        return usage;
+    }
+
 #if EMH_STATIS
     // Returns the bucket number where the element with key k is located.
     size_type bucket(const KeyT& key) const {
@@ -613,6 +634,60 @@ public:
 
     KeyT& index(const uint32_t slot) noexcept { return _pairs[slot]; }
 
+    // ------------------------------------------------------------
+    // Random access: keys are packed in _pairs[0, size()), so the i-th key and a uniform
+    // sample cost O(1). A slot holds its key until an erase moves the last key into a hole,
+    // which makes erase_nth() the O(1) removal step of reservoir style sampling.
+
+    /// The key in dense slot i, 0 <= i < size().
+    const KeyT& nth(size_type i) const noexcept {
+        assert(i < _num_filled);
+        return _pairs[i];
+    }
+
+    /// A uniformly random key; the set must not be empty.
+    template <typename URNG> const KeyT& sample(URNG& rng) const {
+        assert(_num_filled > 0);
+        return _pairs[random_slot(rng, _num_filled)];
+    }
+
+    /// min(k, size()) distinct keys chosen uniformly without replacement, in no particular
+    /// order. Small k uses Floyd's algorithm (k draws); k above size()/8 selects in one pass.
+    template <typename URNG> std::vector<KeyT> sample_k(size_type k, URNG& rng) const {
+        std::vector<KeyT> out;
+        if (k >= _num_filled) {
+            out.assign(_pairs, _pairs + _num_filled);
+            return out;
+        }
+        out.reserve(k);
+        if (k > _num_filled / 8) {
+            // selection sampling: keep slot i with probability needed / remaining
+            for (size_type slot = 0, needed = k; needed > 0; slot++) {
+                if (random_slot(rng, _num_filled - slot) < needed) {
+                    out.push_back(_pairs[slot]);
+                    needed--;
+                }
+            }
+            return out;
+        }
+        HashSet<size_type> chosen(k);
+        for (size_type j = _num_filled - k; j < _num_filled; j++) {
+            const auto t = random_slot(rng, j + 1);
+            const auto slot = chosen.insert(t).second ? t : j;
+            if (slot == j)
+                chosen.insert(j);
+            out.push_back(_pairs[slot]);
+        }
+        return out;
+    }
+
+    /// Erase the key in dense slot i. The last key moves into slot i, so the returned
+    /// iterator points at the next key to visit when walking slots upward.
+    iterator erase_nth(size_type i) {
+        assert(i < _num_filled);
+        return erase(const_iterator(this, i));
+    }
+
     template <typename K = KeyT> bool contains(const K& key) const noexcept {
         return find_filled_slot(key) != _num_filled;
     }
@@ -646,6 +721,71 @@ public:
         }
     }
 
+    // ------------------------------------------------------------
+    // Set algebra: walk the dense key array of the smaller set, hash a batch of keys
+    // and prefetch their main buckets in the larger set before probing them.
+    // `out` must not be *this or rhs; an empty `out` is filled with insert_unique().
+
+    /// Number of keys in both *this and rhs.
+    size_type intersection_size(const HashSet& rhs) const noexcept {
+        const auto& small = _num_filled <= rhs._num_filled ? *this : rhs;
+        const auto& large = &small == this ? rhs : *this;
+        size_type found = 0;
+        small.probe_batch(large, [&found](const KeyT&, uint64_t, bool in_large) { found += in_large; });
+        return found;
+    }
+
+    /// Add the keys in both *this and rhs to out, returns the number of keys added.
+    size_type intersect_into(const HashSet& rhs, HashSet& out) const {
+        assert(&out != this && &out != &rhs);
+        const auto& small = _num_filled <= rhs._num_filled ? *this : rhs;
+        const auto& large = &small == this ? rhs : *this;
+        const auto old_size = out._num_filled;
+        const auto unique = old_size == 0;
+        out.reserve(uint64_t(old_size) + small._num_filled, false);
+        small.probe_batch(large, [&out, unique](const KeyT& key, uint64_t key_hash, bool in_large) {
+            if (in_large)
+                out.add_key(key, key_hash, unique);
+        });
+        return out._num_filled - old_size;
+    }
+
+    /// Add the keys in *this or rhs to out, returns the number of keys added.
+    size_type union_into(const HashSet& rhs, HashSet& out) const {
+        assert(&out != this && &out != &rhs);
+        const auto& small = _num_filled <= rhs._num_filled ? *this : rhs;
+        const auto& large = &small == this ? rhs : *this;
+        const auto old_size = out._num_filled;
+        const auto unique = old_size == 0;
+        if (unique)
+            out = large;
+        else {
+            out.reserve(uint64_t(old_size) + large._num_filled + small._num_filled, false);
+            for (size_type slot = 0; slot < large._num_filled; slot++)
+                out.do_insert(large._pairs[slot]);
+        }
+
+        out.reserve(uint64_t(out._num_filled) + small._num_filled, false);
+        small.probe_batch(large, [&out, unique](const KeyT& key, uint64_t key_hash, bool in_large) {
+            if (!in_large)
+                out.add_key(key, key_hash, unique);
+        });
+        return out._num_filled - old_size;
+    }
+
+    /// Add the keys in *this but not in rhs to out, returns the number of keys added.
+    size_type difference_into(const HashSet& rhs, HashSet& out) const {
+        assert(&out != this && &out != &rhs);
+        const auto old_size = out._num_filled;
+        const auto unique = old_size == 0;
+        out.reserve(uint64_t(old_size) + _num_filled, false);
+        probe_batch(rhs, [&out, unique](const KeyT& key, uint64_t key_hash, bool in_rhs) {
+            if (!in_rhs)
+                out.add_key(key, key_hash, unique);
+        });
+        return out._num_filled - old_size;
+    }
+
     // -----------------------------------------------------
     std::pair<iterator, bool> do_insert(const value_type& value) noexcept {
         const auto key_hash = hash_key(value);
@@ -693,6 +833,148 @@ public:
             do_insert(*first);
     }
 
+    /// Replace the contents with the keys of [first, last) (random access; duplicates are kept
+    /// once) using up to num_threads threads (0: hardware concurrency). The table is reserved
+    /// for the whole range and cut into P ranges of at most PARALLEL_RANGE_BUCKETS buckets, at
+    /// least four per thread. The keys are copied out grouped by range, and each worker builds
+    /// a cache-sized sub-table per range: its index is the final index of that range, so
+    /// stitching only shifts slots and moves keys. Small inputs, one thread,
+    /// EMH_HIGH_LOAD/EMH_PACK_TAIL layouts and a range outgrowing its sub-table fall back to a
+    /// serial insert.
+    template <typename RandomIt> void assign_parallel(RandomIt first, RandomIt last, unsigned num_threads = 0) {
+        const auto num = static_cast<size_t>(last - first);
+        clear();
+        reserve(num, false);
+        if (num_threads == 0)
+            num_threads = std::max(1u, std::thread::hardware_concurrency());
+
+        size_type parts = 1; // at least 4 per thread, and small enough to stay in cache while built
+        while ((parts < 4 * num_threads || _num_buckets / parts > PARALLEL_RANGE_BUCKETS) &&
+               _num_buckets / (parts * 2) >= PARALLEL_MIN_BUCKETS)
+            parts *= 2;
+#if EMH_HIGH_LOAD
+        parts = 1;
+#endif
+        if (num_threads == 1 || parts == 1 || _num_buckets != _mask + 1) {
+            insert(first, last);
+            return;
+        }
+
+        const auto sub_buckets = _num_buckets / parts;
+        int shift = 0;
+        while ((size_type(1) << shift) < sub_buckets)
+            shift++;
+        const auto part_of = [&](size_t i) { return static_cast<size_t>((hash_key(first[i]) & _mask) >> shift); };
+
+        // 1. count keys per (thread, range) over contiguous input chunks
+        const size_t chunk = (num + num_threads - 1) / num_threads;
+        std::vector<size_t> counts(size_t(num_threads) * parts);
+        emhash_detail::run_parallel(num_threads, [&](unsigned t) {
+            auto* count = &counts[size_t(t) * parts];
+            for (size_t i = t * chunk, end = std::min(num, i + chunk); i < end; i++)
+                count[part_of(i)]++;
+        });
+
+        // 2. range major, thread minor offsets keep each range in input order
+        std::vector<size_t> part_begin(parts + 1);
+        size_t sum = 0;
+        for (size_type p = 0; p < parts; p++) {
+            part_begin[p] = sum;
+            for (unsigned t = 0; t < num_threads; t++) {
+                const auto n = counts[size_t(t) * parts + p];
+                counts[size_t(t) * parts + p] = sum;
+                sum += n;
+            }
+        }
+        part_begin[parts] = sum;
+
+        // 3. scatter copies, so that each sub-table reads its input sequentially
+        std::vector<value_type> scattered(num);
+        emhash_detail::run_parallel(num_threads, [&](unsigned t) {
+            auto* pos = &counts[size_t(t) * parts];
+            for (size_t i = t * chunk, end = std::min(num, i + chunk); i < end; i++)
+                scattered[pos[part_of(i)]++] = first[i];
+        });
+
+        // 4. build one sub-table per range
+        std::vector<HashSet> subs(parts);
+        emhash_detail::run_parallel(num_threads, [&](unsigned t) {
+            for (size_type p = t; p < parts; p += num_threads) {
+                HashSet sub(sub_buckets, 0.999f);
+                sub._hasher = _hasher;
+                sub._eq = _eq;
+                for (auto i = part_begin[p]; i < part_begin[p + 1]; i++)
+                    sub.insert(std::move(scattered[i]));
+                subs[p] = std::move(sub);
+            }
+        });
+        std::vector<value_type>().swap(scattered);
+
+        std::vector<size_type> slot_begin(parts + 1);
+        for (size_type p = 0; p < parts; p++) {
+            if (subs[p]._num_buckets != sub_buckets) {
+                insert(first, last); // a range overflowed: skewed hash
+                return;
+            }
+            slot_begin[p + 1] = slot_begin[p] + subs[p]._num_filled;
+        }
+
+        // 5. stitch: sub-table p is the index of buckets [p * sub_buckets, (p + 1) * sub_buckets)
+        emhash_detail::run_parallel(num_threads, [&](unsigned t) {
+            for (size_type p = t; p < parts; p += num_threads) {
+                auto& sub = subs[p];
+                const auto base = p * sub_buckets, offset = slot_begin[p];
+                for (size_type bucket = 0; bucket < sub_buckets; bucket++) {
+                    const auto& index = sub._index[bucket];
+                    if (0 > static_cast<int>(index.next))
+                        _index[base + bucket] = index;
+                    else
+                        _index[base + bucket] = {base + index.next,
+                                                 ((index.slot & sub._mask) + offset) | (index.slot & ~_mask)};
+                }
+                if (is_trivially_copyable()) {
+                    memcpy(reinterpret_cast<char*>(_pairs + offset), reinterpret_cast<char*>(sub._pairs),
+                           sub._num_filled * sizeof(value_type));
+                } else {
+                    for (size_type slot = 0; slot < sub._num_filled; slot++)
+                        new (_pairs + offset + slot) value_type(std::move(sub._pairs[slot]));
+                }
+                HashSet().swap(sub);
+            }
+        });
+        _num_filled = slot_begin[parts];
+        _last = 0;
+        _etail = INACTIVE;
+    }
+
+    /// Insert every key of [first, last) (random access, duplicates allowed) and call
+    /// fn(slot, inserted) for each in order, where slot indexes the dense key array.
+    /// Hashes run PROBE_BATCH keys ahead and their main buckets are prefetched.
+    template <typename RandomIt, typename F> void insert_each(RandomIt first, RandomIt last, F&& fn) {
+        const auto num = static_cast<size_t>(last - first);
+        uint64_t hashes[PROBE_BATCH];
+        for (size_t i = 0; i < num && i < PROBE_BATCH; i++) {
+            hashes[i] = hash_key(first[i]);
+            prefetch_probe(&_index[hashes[i] & _mask]);
+        }
+
+        for (size_t i = 0; i < num; i++) {
+            const auto key_hash = hashes[i % PROBE_BATCH];
+            if (i + PROBE_BATCH < num) {
+                const auto next_hash = hashes[i % PROBE_BATCH] = hash_key(first[i + PROBE_BATCH]);
+                prefetch_probe(&_index[next_hash & _mask]);
+            }
+
+            check_expand_need();
+            const auto bucket = find_or_allocate(first[i], key_hash);
+            const auto bempty = EMH_EMPTY(bucket);
+            if (bempty) {
+                EMH_NEW(first[i], bucket, key_hash);
+            }
+            fn(static_cast<size_type>(_index[bucket].slot & _mask), bempty);
+        }
+    }
+
     /// @brief Insert a key without checking for duplicates.
     /// @param key The key to insert.
     /// @return The bucket index where the element was inserted.
@@ -1085,6 +1367,65 @@ private:
 #endif
     }
 
+    // Like prefetch_heap_block(), but into all cache levels: the line is read a few probes later.
+    static void prefetch_probe(const void* ptr) {
+#if defined(__GNUC__) || defined(__clang__)
+        __builtin_prefetch(ptr, 0, 3);
+#elif _WIN32 && defined(_M_ARM64)
+        __prefetch(ptr);
+#elif _WIN32
+        _mm_prefetch(static_cast<const char*>(ptr), _MM_HINT_T0);
+#else
+        (void)ptr;
+#endif
+    }
+
+    // Uniform slot in [0, n) for sample() and sample_k(); n must not be 0.
+    template <typename URNG> static size_type random_slot(URNG& rng, size_type n) {
+        return std::uniform_int_distribution<size_type>(0, n - 1)(rng);
+    }
+
+    // Call fn(key, key_hash, found) for every key of *this. The main bucket of key i + PROBE_BATCH
+    // and the key slot of key i + PROBE_BATCH / 2 in other are prefetched while key i is probed.
+    template <typename F> void probe_batch(const HashSet& other, F&& fn) const {
+        constexpr size_type half = PROBE_BATCH / 2;
+        uint64_t hashes[PROBE_BATCH];
+        const auto prologue = std::min<size_type>(PROBE_BATCH, _num_filled);
+        for (size_type i = 0; i < prologue; i++) {
+            hashes[i] = other.hash_key(_pairs[i]);
+            prefetch_probe(&other._index[hashes[i] & other._mask]);
+        }
+
+        for (size_type i = 0; i < _num_filled; i++) {
+            if (i + half < _num_filled) {
+                const auto& index = other._index[hashes[(i + half) % PROBE_BATCH] & other._mask];
+                if (static_cast<int>(index.next) >= 0)
+                    prefetch_probe(&other._pairs[index.slot & other._mask]);
+            }
+
+            const auto& key = _pairs[i];
+            const auto key_hash = hashes[i % PROBE_BATCH];
+            if (i + PROBE_BATCH < _num_filled) {
+                auto& next_hash = hashes[i % PROBE_BATCH];
+                next_hash = other.hash_key(_pairs[i + PROBE_BATCH]);
+                prefetch_probe(&other._index[next_hash & other._mask]);
+            }
+            fn(key, key_hash, other.find_filled_slot(key, key_hash) != other._num_filled);
+        }
+    }
+
+    // key_hash comes from the probed set's hasher; only a stateless HashT hashes alike in *this.
+    void add_key(const KeyT& key, uint64_t key_hash, bool unique) {
+        check_expand_need();
+        if (unique) {
+            if constexpr (!std::is_empty<HashT>::value)
+                key_hash = hash_key(key);
+            const auto bucket = find_unique_bucket(key_hash);
+            EMH_NEW(key, bucket, key_hash);
+        } else
+            do_insert(key);
+    }
+
     size_type slot_to_bucket(const size_type slot) const noexcept {
         size_type main_bucket;
         return find_slot_bucket(slot, main_bucket);
@@ -1191,7 +1532,10 @@ private:
 
     // Find the slot with this key, or return bucket size
     template <typename K = KeyT> size_type find_filled_slot(const K& key) const noexcept {
-        const auto key_hash = hash_key(key);
+        return find_filled_slot(key, hash_key(key));
+    }
+
+    template <typename K = KeyT> size_type find_filled_slot(const K& key, uint64_t key_hash) const noexcept {
         const auto bucket = size_type(key_hash & _mask);
         auto next_bucket = _index[bucket].next;
         if (static_cast<int>(next_bucket) < 0)
@@ -0,0 +1,364 @@
+// emhash compact integer set
+// https://github.com/ktprime/emhash
+// SPDX-License-Identifier: MIT
+// Copyright (c) 2019-2026 Huang Yuanbing & bailuzhou AT 163.com
+//
+// A set of uint32_t/uint64_t ids for when emhash2/3/4::HashSet's full key plus 32 bit
+// link per slot is too much memory. Keys pass through an invertible mixer; the top
+// `bits` of the mixed key pick the home bucket and only the remaining low bits (the
+// remainder) are stored, next to a 5 bit probe distance, in a bit-packed slot array:
+//
+//   slot = remainder << 5 | (distance + 1)        (0 = empty slot)
+//
+// Slots are placed with Robin Hood linear probing and erased by backward shift, so
+// every key sits within MAX_PROBE slots of its home bucket and the table stays sorted
+// by home bucket. A key that would land further away goes to a small emhash2::HashSet
+// stash. 1M random uint32_t keys take 2^21 slots of 16 bits, 4 bytes per key against
+// 16 in emhash2::HashSet.
+
+#pragma once
+
+#include "hash_set2.hpp"
+
+#include <cstdint>
+#include <cstring>
+#include <iterator>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace emhash_compact {
+
+template <typename UIntT> class IntSet {
+    static_assert(std::is_same<UIntT, uint32_t>::value || std::is_same<UIntT, uint64_t>::value,
+                  "IntSet stores uint32_t or uint64_t keys");
+
+    static constexpr uint32_t KEY_BITS = sizeof(UIntT) * 8;
+    static constexpr uint32_t DIST_BITS = 5;
+    static constexpr uint32_t MAX_PROBE = (1u << DIST_BITS) - 2; // distance + 1 must fit DIST_BITS
+    static constexpr uint32_t MIN_BITS = DIST_BITS + (KEY_BITS == 64 ? 1 : 0); // slot fits 64 bits
+    static constexpr uint64_t DIST_MASK = (1u << DIST_BITS) - 1;
+
+    using Stash = emhash2::HashSet<UIntT>;
+
+public:
+    using key_type = UIntT;
+    using value_type = UIntT;
+    using size_type = uint64_t;
+
+    /// Forward iterator over the keys (by value): table keys in home bucket order, then the stash.
+    class const_iterator {
+    public:
+        using iterator_category = std::forward_iterator_tag;
+        using difference_type = std::ptrdiff_t;
+        using value_type = UIntT;
+        using pointer = const UIntT*;
+        using reference = UIntT;
+
+        const_iterator() = default;
+        const_iterator(const IntSet* set, size_type slot, typename Stash::const_iterator sit)
+            : _set(set), _slot(slot), _sit(sit) {}
+
+        UIntT operator*() const { return _slot < _set->_num_slots ? _set->key_at(_slot) : *_sit; }
+
+        const_iterator& operator++() {
+            if (_slot < _set->_num_slots)
+                _slot = _set->next_filled(_slot + 1);
+            else
+                ++_sit;
+            return *this;
+        }
+
+        const_iterator operator++(int) {
+            auto old = *this;
+            ++*this;
+            return old;
+        }
+
+        bool operator==(const const_iterator& rhs) const { return _slot == rhs._slot && _sit == rhs._sit; }
+        bool operator!=(const const_iterator& rhs) const { return !(*this == rhs); }
+
+    private:
+        const IntSet* _set = nullptr;
+        size_type _slot = 0;
+        typename Stash::const_iterator _sit;
+    };
+    using iterator = const_iterator;
+
+    explicit IntSet(size_type bucket = 16, float mlf = 0.80f) {
+        max_load_factor(mlf);
+        init(bits_for(bucket));
+    }
+
+    IntSet(std::initializer_list<UIntT> ilist) : IntSet(ilist.size()) {
+        for (auto key : ilist)
+            insert(key);
+    }
+
+    IntSet(const IntSet&) = default;
+    IntSet(IntSet&&) noexcept = default;
+    IntSet& operator=(const IntSet&) = default;
+    IntSet& operator=(IntSet&&) noexcept = default;
+
+    void swap(IntSet& rhs) noexcept {
+        std::swap(_words, rhs._words);
+        _stash.swap(rhs._stash);
+        std::swap(_bits, rhs._bits);
+        std::swap(_slot_bits, rhs._slot_bits);
+        std::swap(_slot_mask, rhs._slot_mask);
+        std::swap(_num_slots, rhs._num_slots);
+        std::swap(_num_filled, rhs._num_filled);
+        std::swap(_mlf, rhs._mlf);
+    }
+
+    // -------------------------------------------------------------
+    const_iterator begin() const { return {this, next_filled(0), _stash.cbegin()}; }
+    const_iterator cbegin() const { return begin(); }
+    const_iterator end() const { return {this, _num_slots, _stash.cend()}; }
+    const_iterator cend() const { return end(); }
+
+    size_type size() const { return _num_filled + _stash.size(); }
+    bool empty() const { return size() == 0; }
+    size_type bucket_count() const { return size_type(1) << _bits; }
+    uint32_t bit_count() const { return _bits; }
+    size_type stash_size() const { return _stash.size(); }
+    uint32_t bits_per_slot() const { return _slot_bits; }
+    float load_factor() const { return static_cast<float>(_num_filled) / static_cast<float>(bucket_count()); }
+    float max_load_factor() const { return _mlf; }
+    void max_load_factor(float mlf) {
+        if (mlf >= 0.25f && mlf <= 0.95f)
+            _mlf = mlf;
+    }
+
+    /// Footprint of the packed slots (remainder bits as entries/slack, probe distance bits
+    /// as metadata, partial and spare words as padding) plus the stash.
+    emhash::MemoryUsage memory_usage() const {
+        auto usage = _stash.memory_usage();
+        const size_t slots = _num_slots, filled = _num_filled, remainder_bits = _slot_bits - DIST_BITS;
+        const size_t entries = filled * remainder_bits / 8, slack = (slots - filled) * remainder_bits / 8;
+        const size_t metadata = slots * DIST_BITS / 8;
+        usage.entries += entries;
+        usage.slack += slack;
+        usage.metadata += metadata;
+        usage.padding += _words.size() * sizeof(uint64_t) - entries - slack - metadata;
+        return usage;
+    }
+
+    /// The invertible key mixer, its top bit_count() bits are the home bucket of key.
+    static UIntT mix(UIntT key) {
+        key ^= key >> (KEY_BITS / 2);
+        key *= GOLDEN;
+        return key ^ (key >> (KEY_BITS / 2));
+    }
+
+    // -------------------------------------------------------------
+    bool contains(UIntT key) const {
+        const auto mixed = mix(key);
+        if (find_slot(home_of(mixed), remainder_of(mixed)) != _num_slots)
+            return true;
+        return !_stash.empty() && _stash.contains(key);
+    }
+
+    size_type count(UIntT key) const { return contains(key) ? 1 : 0; }
+
+    /// Returns true if key was inserted.
+    bool insert(UIntT key) {
+        if (contains(key))
+            return false;
+        insert_unique(key);
+        return true;
+    }
+
+    template <typename Iter> void insert(Iter first, Iter last) {
+        for (; first != last; ++first)
+            insert(*first);
+    }
+
+    /// Same as insert(), but contains(key) MUST be false.
+    void insert_unique(UIntT key) {
+        if (EMH_UNLIKELY(_num_filled + 1 > static_cast<size_type>(_mlf * static_cast<float>(bucket_count()))))
+            rehash(_bits + 1);
+        place(mix(key));
+    }
+
+    size_type erase(UIntT key) {
+        const auto mixed = mix(key);
+        const auto slot = find_slot(home_of(mixed), remainder_of(mixed));
+        if (slot == _num_slots)
+            return _stash.empty() ? 0 : _stash.erase(key);
+
+        // backward shift: pull the following displaced slots one step closer to home
+        auto hole = slot;
+        for (auto next = hole + 1; next < _num_slots; hole = next++) {
+            const auto value = get(next);
+            if ((value & DIST_MASK) <= 1)
+                break;
+            set(hole, value - 1);
+        }
+        set(hole, 0);
+        _num_filled--;
+        return 1;
+    }
+
+    template <typename Pred> size_type erase_if(Pred pred) {
+        std::vector<UIntT> keys;
+        for (auto key : *this)
+            if (pred(key))
+                keys.push_back(key);
+        for (auto key : keys)
+            erase(key);
+        return keys.size();
+    }
+
+    void clear() {
+        std::fill(_words.begin(), _words.end(), 0);
+        _stash.clear();
+        _num_filled = 0;
+    }
+
+    /// Make room for this many keys.
+    bool reserve(size_type num_keys) {
+        const auto bits = bits_for(static_cast<size_type>(static_cast<float>(num_keys) / _mlf) + 1);
+        if (bits <= _bits)
+            return false;
+        rehash(bits);
+        return true;
+    }
+
+    void shrink_to_fit() { rehash(bits_for(static_cast<size_type>(static_cast<float>(size()) / _mlf) + 1)); }
+
+    void rehash(uint32_t bits) {
+        if (bits < MIN_BITS)
+            bits = MIN_BITS;
+        if (bits > KEY_BITS - 1)
+            bits = KEY_BITS - 1;
+
+        IntSet other(0, _mlf);
+        other.init(bits);
+        for (auto key : *this)
+            other.place(mix(key));
+        swap(other);
+    }
+
+private:
+    // Invertible mixer: xorshift(s >= KEY_BITS / 2) is its own inverse and GOLDEN is odd.
+    static constexpr UIntT GOLDEN = static_cast<UIntT>(UINT64_C(0x9E3779B97F4A7C15));
+    static constexpr UIntT inverse(UIntT odd) {
+        UIntT x = odd; // correct to 3 bits, each Newton step doubles them
+        for (int i = 0; i < 5; i++)
+            x *= static_cast<UIntT>(2 - odd * x);
+        return x;
+    }
+    static constexpr UIntT GOLDEN_INV = inverse(GOLDEN);
+    static_assert(static_cast<UIntT>(GOLDEN * GOLDEN_INV) == 1, "GOLDEN_INV");
+
+    static UIntT unmix(UIntT mixed) {
+        mixed ^= mixed >> (KEY_BITS / 2);
+        mixed *= GOLDEN_INV;
+        return mixed ^ (mixed >> (KEY_BITS / 2));
+    }
+
+    static uint32_t bits_for(size_type buckets) {
+        uint32_t bits = MIN_BITS;
+        while (bits < KEY_BITS - 1 && (size_type(1) << bits) < buckets)
+            bits++;
+        return bits;
+    }
+
+    void init(uint32_t bits) {
+        _bits = bits;
+        _slot_bits = KEY_BITS - bits + DIST_BITS;
+        _slot_mask = (uint64_t(1) << _slot_bits) - 1;
+        _num_slots = (size_type(1) << bits) + MAX_PROBE;
+        _words.assign((_num_slots * _slot_bits + 63) / 64 + 1, 0);
+        _stash.clear();
+        _num_filled = 0;
+    }
+
+    inline size_type home_of(UIntT mixed) const { return static_cast<size_type>(mixed >> (KEY_BITS - _bits)); }
+    inline uint64_t remainder_of(UIntT mixed) const {
+        return static_cast<uint64_t>(mixed) & ((uint64_t(1) << (KEY_BITS - _bits)) - 1);
+    }
+
+    // Slots never reach 64 bits (see MIN_BITS); word + 1 always exists thanks to the padding word.
+    inline uint64_t get(size_type slot) const {
+        const auto bit = slot * _slot_bits;
+        const auto word = bit / 64, shift = bit % 64;
+        const auto value = (_words[word] >> shift) | ((_words[word + 1] << 1) << (63 - shift));
+        return value & _slot_mask;
+    }
+
+    inline void set(size_type slot, uint64_t value) {
+        const auto bit = slot * _slot_bits;
+        const auto word = bit / 64, shift = bit % 64;
+        _words[word] = (_words[word] & ~(_slot_mask << shift)) | (value << shift);
+        if (shift + _slot_bits > 64) {
+            const auto high = 64 - shift;
+            _words[word + 1] = (_words[word + 1] & ~(_slot_mask >> high)) | (value >> high);
+        }
+    }
+
+    UIntT key_at(size_type slot) const {
+        const auto value = get(slot);
+        const auto home = slot - ((value & DIST_MASK) - 1);
+        const auto rbits = KEY_BITS - _bits;
+        return unmix(static_cast<UIntT>((static_cast<uint64_t>(home) << rbits) | (value >> DIST_BITS)));
+    }
+
+    size_type next_filled(size_type slot) const {
+        while (slot < _num_slots && get(slot) == 0)
+            slot++;
+        return slot;
+    }
+
+    // Robin Hood lookup: stop at an empty slot or one closer to its home than we are.
+    size_type find_slot(size_type home, uint64_t remainder) const {
+        const auto target = remainder << DIST_BITS;
+        for (uint64_t dist = 0; dist <= MAX_PROBE; dist++) {
+            const auto value = get(home + dist);
+            if (value == (target | (dist + 1)))
+                return home + dist;
+            if ((value & DIST_MASK) <= dist)
+                return _num_slots;
+        }
+        return _num_slots;
+    }
+
+    void place(UIntT mixed) {
+        auto slot = home_of(mixed);
+        auto remainder = remainder_of(mixed);
+        for (uint64_t dist = 0; dist <= MAX_PROBE; dist++, slot++) {
+            const auto value = get(slot);
+            if (value == 0) {
+                set(slot, remainder << DIST_BITS | (dist + 1));
+                _num_filled++;
+                return;
+            }
+
+            // take the slot from a key that is closer to its home, carry that key on
+            const auto vdist = (value & DIST_MASK) - 1;
+            if (vdist < dist) {
+                set(slot, remainder << DIST_BITS | (dist + 1));
+                remainder = value >> DIST_BITS;
+                dist = vdist;
+            }
+        }
+
+        // the carried key is MAX_PROBE + 1 slots from home
+        const auto home = slot - (MAX_PROBE + 1);
+        const auto rbits = KEY_BITS - _bits;
+        _stash.insert(unmix(static_cast<UIntT>((static_cast<uint64_t>(home) << rbits) | remainder)));
+    }
+
+private:
+    std::vector<uint64_t> _words;
+    Stash _stash;
+    uint32_t _bits = 0;
+    uint32_t _slot_bits = 0;
+    uint64_t _slot_mask = 0;
+    size_type _num_slots = 0;
+    size_type _num_filled = 0;
+    float _mlf = 0.80f;
+};
+
+} // namespace emhash_compact
@@ -649,6 +649,22 @@ public:
     [[nodiscard]] constexpr uint64_t max_size() const { return 1ull << (sizeof(_num_buckets) * 8 - 1); }
     [[nodiscard]] constexpr uint64_t max_bucket_count() const { return max_size(); }
 
+    /// Bytes by role: the bucket array (next links are metadata) with its two tail
+    /// sentinels, plus the inline EMH_SMALL_SIZE buffer, padding while unused.
+    [[nodiscard]] emhash::MemoryUsage memory_usage() const noexcept {
+        emhash::MemoryUsage usage;
+        if (_pairs) {
+            usage.add_slots(_num_buckets, _num_filled, sizeof(PairT), sizeof(value_type));
+            usage.padding += 2 * sizeof(PairT);
+        }
+#if EMH_SMALL_SIZE
+        usage.padding += sizeof(_small);
+        if (_pairs == reinterpret_cast<const PairT*>(_small))
+            usage.padding -= (2 + static_cast<size_t>(_num_buckets)) * sizeof(PairT);
+#endif
+        return usage;
+    }
+
 #if EMH_STATIS
     // Returns the bucket number where the element with key k is located.
     size_type bucket_slot(const KeyT& key) const {
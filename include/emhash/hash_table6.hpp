@@ -718,6 +718,19 @@ public:
     [[nodiscard]] constexpr uint64_t max_size() const { return 1ull << (sizeof(_mask) * 8 - 1); }
     [[nodiscard]] constexpr uint64_t max_bucket_count() const { return max_size(); }
 
+    /// Bytes by role: buckets (links are metadata), the empty-bucket bitmask, and as padding
+    /// the bitmask tail, its alignment and the PACK_SIZE sentinel buckets.
+    [[nodiscard]] emhash::MemoryUsage memory_usage() const noexcept {
+        emhash::MemoryUsage usage;
+        if (!_bitmask)
+            return usage;
+        const uint64_t num_buckets = _mask + 1;
+        usage.add_slots(num_buckets, _num_filled, sizeof(PairT), sizeof(value_type));
+        usage.metadata += (num_buckets + 7) / 8;
+        usage.padding = static_cast<size_t>(AllocPairCount(num_buckets)) * sizeof(PairT) - usage.total();
+        return usage;
+    }
+
 #if EMH_STATIS
     // Returns the bucket number where the element with key k is located.
     size_type bucket(const KeyT& key) const {
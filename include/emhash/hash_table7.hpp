@@ -103,6 +103,9 @@ of resizing granularity. Ignoring variance, the expected occurrences of list siz
 #include <iterator>
 #include <algorithm>
 #include <memory>
+#include <exception>
+#include <thread>
+#include <vector>
 
 // wyhash is now provided by config.hpp (emh_wyhash / wyhash alias)
 // No need for external wyhash.h dependency
@@ -301,6 +304,7 @@ class HashMap {
     constexpr static float EMH_DEFAULT_LOAD_FACTOR = 0.80f;
 #endif
     constexpr static float EMH_MIN_LOAD_FACTOR = 0.25f;
+    constexpr static uint32_t PARALLEL_MIN_BUCKETS = 1u << 12;
 
 public:
     using htype = HashMap<KeyT, ValueT, HashT, EqT, AllocT>;
@@ -774,6 +778,18 @@ public:
     [[nodiscard]] constexpr uint64_t max_size() const { return 1ull << (sizeof(_num_buckets) * 8 - 1); }
     [[nodiscard]] constexpr uint64_t max_bucket_count() const { return max_size(); }
 
+    /// Bytes by role: buckets (links are metadata), the empty-bucket bitmask, and as padding
+    /// the bitmask tail, its alignment and the EPACK_SIZE sentinel buckets.
+    [[nodiscard]] emhash::MemoryUsage memory_usage() const noexcept {
+        emhash::MemoryUsage usage;
+        if (!_bitmask)
+            return usage;
+        usage.add_slots(_num_buckets, _num_filled, sizeof(PairT), sizeof(value_type));
+        usage.metadata += (static_cast<size_t>(_num_buckets) + 7) / 8;
+        usage.padding = static_cast<size_t>(alloc_count(_num_buckets)) * sizeof(PairT) - usage.total();
+        return usage;
+    }
+
     [[nodiscard]] size_type bucket_main() const {
         size_type main_size = 0;
         for (size_type bucket = 0; bucket < _num_buckets; ++bucket) {
@@ -1241,6 +1257,78 @@ public:
         return old_size - size();
     }
 
+    // ------------------------------------------------------------
+    // Parallel scans: the bucket array is cut into one contiguous run of at least
+    // PARALLEL_MIN_BUCKETS buckets per thread (num_threads 0: hardware concurrency). The
+    // callbacks run concurrently and must not insert or erase.
+
+    /// Call fn(pair) for every element; fn may modify the values.
+    template <typename F> void parallel_for_each(F&& fn, unsigned num_threads = 0) {
+        parallel_buckets(num_threads, [&](size_type begin, size_type end, unsigned) {
+            for_each_filled(begin, end, [&](size_type bucket) { fn(EMH_PKV(_pairs, bucket)); });
+        });
+    }
+
+    template <typename F> void parallel_for_each(F&& fn, unsigned num_threads = 0) const {
+        parallel_buckets(num_threads, [&](size_type begin, size_type end, unsigned) {
+            for_each_filled(begin, end,
+                            [&](size_type bucket) { fn(static_cast<const value_pair&>(EMH_PKV(_pairs, bucket))); });
+        });
+    }
+
+    /// Fold map(pair) over all elements with reduce, starting from init. Each thread folds
+    /// its run, then the runs are folded into init in bucket order, so reduce must be associative.
+    template <typename T, typename MapF, typename ReduceF>
+    T parallel_reduce(T init, MapF&& map, ReduceF&& reduce, unsigned num_threads = 0) const {
+        std::vector<std::unique_ptr<T>> partial(std::max(1u, num_threads ? num_threads
+                                                                          : std::thread::hardware_concurrency()));
+        parallel_buckets(num_threads, [&](size_type begin, size_type end, unsigned t) {
+            std::unique_ptr<T> acc;
+            for_each_filled(begin, end, [&](size_type bucket) {
+                const auto& pair = static_cast<const value_pair&>(EMH_PKV(_pairs, bucket));
+                if (acc)
+                    *acc = reduce(std::move(*acc), map(pair));
+                else
+                    acc.reset(new T(map(pair)));
+            });
+            partial[t] = std::move(acc);
+        });
+        for (auto& acc : partial)
+            if (acc)
+                init = reduce(std::move(init), std::move(*acc));
+        return init;
+    }
+
+    /// erase_if() in two phases: pred(pair) runs in parallel and only marks buckets in a
+    /// bitmap, then the calling thread erases them in bucket order. When unlinking a main
+    /// bucket pulls its successor in, the successor's mark moves with it.
+    template <typename Pred> size_type parallel_erase_if(Pred&& pred, unsigned num_threads = 0) {
+        const auto old_size = size();
+        std::vector<size_t> marks((_num_buckets + SIZE_BIT - 1) / SIZE_BIT);
+        parallel_buckets(num_threads, [&](size_type begin, size_type end, unsigned) {
+            for_each_filled(begin, end, [&](size_type bucket) {
+                if (pred(static_cast<const value_pair&>(EMH_PKV(_pairs, bucket))))
+                    marks[bucket / SIZE_BIT] |= size_t(1) << (bucket % SIZE_BIT);
+            });
+        });
+
+        for (size_type word = 0; word < marks.size(); word++) {
+            while (marks[word] != 0) {
+                const auto bucket = word * SIZE_BIT + CTZ(marks[word]);
+                const auto cleared = erase_bucket(bucket);
+                clear_bucket(cleared);
+                marks[word] &= marks[word] - 1;
+                auto& cleared_word = marks[cleared / SIZE_BIT];
+                const auto cleared_bit = size_t(1) << (cleared % SIZE_BIT);
+                if (cleared != bucket && (cleared_word & cleared_bit)) {
+                    cleared_word &= ~cleared_bit;
+                    marks[word] |= size_t(1) << (bucket % SIZE_BIT);
+                }
+            }
+        }
+        return old_size - size();
+    }
+
     [[nodiscard]] static constexpr bool need_explicit_dtor() {
         return !(std::is_trivially_destructible<KeyT>::value && std::is_trivially_destructible<ValueT>::value);
     }
@@ -1380,6 +1468,35 @@ public:
     }
 
 private:
+    // Cut [0, bucket_count()) into one run of at least PARALLEL_MIN_BUCKETS buckets per thread,
+    // aligned to bitmask words, and call fn(begin, end, t) for each on its own thread.
+    template <typename F> void parallel_buckets(unsigned num_threads, F&& fn) const {
+        if (num_threads == 0)
+            num_threads = std::max(1u, std::thread::hardware_concurrency());
+        const auto num = _num_filled ? _num_buckets : 0;
+        const auto max_threads = std::max<size_type>(1, num / PARALLEL_MIN_BUCKETS);
+        num_threads = static_cast<unsigned>(std::min<size_type>(num_threads, max_threads));
+        const auto chunk = ((num + num_threads - 1) / num_threads + SIZE_BIT - 1) / SIZE_BIT * SIZE_BIT;
+        emhash_detail::run_parallel(num_threads, [&](unsigned t) {
+            const auto begin = std::min<size_type>(num, t * chunk);
+            fn(begin, std::min<size_type>(num, begin + chunk), t);
+        });
+    }
+
+    // Call fn(bucket) for every filled bucket in [begin, end), a bitmask word at a time as the
+    // iterator does; begin must be a multiple of SIZE_BIT.
+    template <typename F> void for_each_filled(size_type begin, size_type end, F&& fn) const {
+        for (auto from = begin; from < end; from += SIZE_BIT) {
+            size_t bmask;
+            memcpy(&bmask, _bitmask + from / SIZE_BIT * sizeof(size_t), sizeof(bmask));
+            bmask = ~bmask;
+            if (end - from < SIZE_BIT)
+                bmask &= (size_t(1) << (end - from)) - 1;
+            for (; bmask != 0; bmask &= bmask - 1)
+                fn(from + CTZ(bmask));
+        }
+    }
+
     // Can we fit another element?
     inline bool check_expand_need() noexcept { return reserve(_num_filled); }
 
@@ -52,6 +52,9 @@
 #include <iterator>
 #include <algorithm>
 #include <memory>
+#include <exception>
+#include <thread>
+#include <vector>
 
 #if defined(_M_IX86) || defined(_M_X64) || defined(__i386__) || defined(__x86_64__)
 #include <xmmintrin.h>
@@ -138,6 +141,9 @@ public:
     constexpr static size_type RESERVE_SLOTS = 2;
     // Extra capacity buffer for pairs allocation (prevents frequent realloc on growth)
     constexpr static size_type PAIRS_CAPACITY_BUFFER = 4;
+    // Smallest and preferred bucket range one assign_parallel() worker builds at a time
+    constexpr static size_type PARALLEL_MIN_BUCKETS = 1u << 12;
+    constexpr static size_type PARALLEL_RANGE_BUCKETS = 1u << 16;
 
     struct Index {
         size_type next;
@@ -475,6 +481,18 @@ public:
     [[nodiscard]] constexpr uint64_t max_size() const noexcept { return 1ull << (sizeof(_num_buckets) * 8 - 1); }
     [[nodiscard]] constexpr uint64_t max_bucket_count() const noexcept { return max_size(); }
 
+    /// Bytes by role: the dense value array (unused capacity is slack), the bucket index and
+    /// its EAD tail entries as padding.
+    [[nodiscard]] emhash::MemoryUsage memory_usage() const noexcept {
+        emhash::MemoryUsage usage;
+        usage.add_slots(_pairs ? _pairs_capacity : 0, _num_filled, sizeof(value_type), sizeof(value_type));
+        if (_index) {
+            usage.index += static_cast<size_t>(_num_buckets) * sizeof(Index);
+            usage.padding += EAD * sizeof(Index);
+        }
+        return usage;
+    }
+
 #if EMH_STATIS
     // Returns the bucket number where the element with key k is located.
     size_type bucket(const KeyT& key) const {
@@ -663,6 +681,64 @@ public:
         }
     }
 
+    /// merge() for large maps: moves every pair whose key is not in *this out of rhs, and
+    /// leaves the others in rhs. The table is reserved once for both sizes. rhs is walked
+    /// chain by chain in bucket order, so inserts land in roughly ascending buckets. When the
+    /// hasher is stateless, each key's hash is rebuilt from rhs's index instead of rehashing
+    /// the key. rhs is compacted once at the end rather than erased pair by pair.
+    void merge_bulk(HashMap& rhs) {
+        if (this == &rhs || rhs.empty())
+            return;
+        if (empty()) {
+            *this = std::move(rhs);
+            return;
+        }
+
+        reserve(static_cast<uint64_t>(_num_filled) + rhs._num_filled, false);
+
+        // a bucket that some other bucket links to is not the head of its chain
+        std::vector<uint8_t> linked(rhs._num_buckets);
+        for (size_type bucket = 0; bucket < rhs._num_buckets; bucket++) {
+            const auto next_bucket = rhs._index[bucket].next;
+            if (static_cast<int>(next_bucket) >= 0 && next_bucket != bucket)
+                linked[next_bucket] = 1;
+        }
+
+        std::vector<uint8_t> moved(rhs._num_filled);
+        size_type num_moved = 0;
+        for (size_type main_bucket = 0; main_bucket <= rhs._mask; main_bucket++) {
+            if (static_cast<int>(rhs._index[main_bucket].next) < 0 || linked[main_bucket])
+                continue;
+
+            // every key on this chain has main_bucket as its low hash bits
+            for (auto bucket = main_bucket;;) {
+                const auto& idx = rhs._index[bucket];
+                const auto slot = idx.slot & rhs._mask;
+                auto& pair = rhs._pairs[slot];
+                uint64_t key_hash;
+                if constexpr (std::is_empty<HashT>::value)
+                    key_hash = (idx.slot & ~rhs._mask) | main_bucket;
+                else
+                    key_hash = hash_key(pair.first);
+
+                const auto found = find_or_allocate(pair.first, key_hash);
+                if (emh_empty(found)) {
+                    EMH_NEW(std::move(pair.first), std::move(pair.second), found, key_hash);
+                    moved[slot] = 1;
+                    num_moved++;
+                }
+                if (idx.next == bucket)
+                    break;
+                bucket = idx.next;
+            }
+        }
+
+        if (num_moved == rhs._num_filled)
+            rhs.clear();
+        else if (num_moved > 0)
+            rhs.compact_slots(moved);
+    }
+
     /// Returns the matching ValueT or nullptr if k isn't found.
     [[nodiscard]] bool try_get(const KeyT& key, ValueT& val) const noexcept {
         const auto slot = find_filled_slot(key);
@@ -795,6 +871,120 @@ public:
             (void)do_insert(*it);
     }
 
+    /// Replace the contents with the pairs of [first, last) (random access; the first of
+    /// duplicate keys wins, as with insert) using up to num_threads threads (0: hardware
+    /// concurrency). The table is reserved for the whole range and cut into P ranges of at most
+    /// PARALLEL_RANGE_BUCKETS buckets, at least four per thread. The pairs are copied out
+    /// grouped by range, and each worker builds a cache-sized sub-table per range: its index is
+    /// the final index of that range, so stitching only shifts slots and moves pairs. Small
+    /// inputs, one thread, EMH_HIGH_LOAD/EMH_PACK_TAIL layouts and a range outgrowing its sub-
+    /// table fall back to a serial insert.
+    template <typename RandomIt> void assign_parallel(RandomIt first, RandomIt last, unsigned num_threads = 0) {
+        const auto num = static_cast<size_t>(last - first);
+        clear();
+        reserve(num, false);
+        if (num_threads == 0)
+            num_threads = std::max(1u, std::thread::hardware_concurrency());
+
+        size_type parts = 1; // at least 4 per thread, and small enough to stay in cache while built
+        while ((parts < 4 * num_threads || _num_buckets / parts > PARALLEL_RANGE_BUCKETS) &&
+               _num_buckets / (parts * 2) >= PARALLEL_MIN_BUCKETS)
+            parts *= 2;
+#if EMH_HIGH_LOAD
+        parts = 1;
+#endif
+        if (num_threads == 1 || parts == 1 || _num_buckets != _mask + 1) {
+            insert(first, last);
+            return;
+        }
+
+        const auto sub_buckets = _num_buckets / parts;
+        int shift = 0;
+        while ((size_type(1) << shift) < sub_buckets)
+            shift++;
+        const auto part_of = [&](size_t i) { return static_cast<size_t>((hash_key(first[i].first) & _mask) >> shift); };
+
+        // 1. count pairs per (thread, range) over contiguous input chunks
+        const size_t chunk = (num + num_threads - 1) / num_threads;
+        std::vector<size_t> counts(size_t(num_threads) * parts);
+        emhash_detail::run_parallel(num_threads, [&](unsigned t) {
+            auto* count = &counts[size_t(t) * parts];
+            for (size_t i = t * chunk, end = std::min(num, i + chunk); i < end; i++)
+                count[part_of(i)]++;
+        });
+
+        // 2. range major, thread minor offsets keep each range in input order
+        std::vector<size_t> part_begin(parts + 1);
+        size_t sum = 0;
+        for (size_type p = 0; p < parts; p++) {
+            part_begin[p] = sum;
+            for (unsigned t = 0; t < num_threads; t++) {
+                const auto n = counts[size_t(t) * parts + p];
+                counts[size_t(t) * parts + p] = sum;
+                sum += n;
+            }
+        }
+        part_begin[parts] = sum;
+
+        // 3. scatter copies, so that each sub-table reads its input sequentially
+        std::vector<value_type> scattered(num);
+        emhash_detail::run_parallel(num_threads, [&](unsigned t) {
+            auto* pos = &counts[size_t(t) * parts];
+            for (size_t i = t * chunk, end = std::min(num, i + chunk); i < end; i++)
+                scattered[pos[part_of(i)]++] = value_type(first[i].first, first[i].second);
+        });
+
+        // 4. build one sub-table per range
+        std::vector<HashMap> subs(parts);
+        emhash_detail::run_parallel(num_threads, [&](unsigned t) {
+            for (size_type p = t; p < parts; p += num_threads) {
+                HashMap sub(sub_buckets, 0.999f);
+                sub._hasher = _hasher;
+                sub._eq = _eq;
+                for (auto i = part_begin[p]; i < part_begin[p + 1]; i++)
+                    sub.emplace(std::move(scattered[i].first), std::move(scattered[i].second));
+                subs[p] = std::move(sub);
+            }
+        });
+        std::vector<value_type>().swap(scattered);
+
+        std::vector<size_type> slot_begin(parts + 1);
+        for (size_type p = 0; p < parts; p++) {
+            if (subs[p]._num_buckets != sub_buckets) {
+                insert(first, last); // a range overflowed: skewed hash
+                return;
+            }
+            slot_begin[p + 1] = slot_begin[p] + subs[p]._num_filled;
+        }
+
+        // 5. stitch: sub-table p is the index of buckets [p * sub_buckets, (p + 1) * sub_buckets)
+        emhash_detail::run_parallel(num_threads, [&](unsigned t) {
+            for (size_type p = t; p < parts; p += num_threads) {
+                auto& sub = subs[p];
+                const auto base = p * sub_buckets, offset = slot_begin[p];
+                for (size_type bucket = 0; bucket < sub_buckets; bucket++) {
+                    const auto& index = sub._index[bucket];
+                    if (0 > static_cast<int>(index.next))
+                        _index[base + bucket] = index;
+                    else
+                        _index[base + bucket] = {base + index.next,
+                                                 ((index.slot & sub._mask) + offset) | (index.slot & ~_mask)};
+                }
+                if (is_trivially_copyable()) {
+                    memcpy(reinterpret_cast<char*>(_pairs + offset), reinterpret_cast<char*>(sub._pairs),
+                           sub._num_filled * sizeof(value_type));
+                } else {
+                    for (size_type slot = 0; slot < sub._num_filled; slot++)
+                        new (_pairs + offset + slot) value_type(std::move(sub._pairs[slot]));
+                }
+                HashMap().swap(sub);
+            }
+        });
+        _num_filled = slot_begin[parts];
+        _last = 0;
+        _etail = INACTIVE;
+    }
+
     /// @brief Insert a key-value pair without checking for duplicates.
     /// @param key The key to insert.
     /// @param val The value to insert.
@@ -949,6 +1139,73 @@ public:
         return old_size - size();
     }
 
+    // ------------------------------------------------------------
+    // Parallel scans: the dense pair array is cut into one contiguous run of at least
+    // PARALLEL_MIN_BUCKETS pairs per thread (num_threads 0: hardware concurrency). The
+    // callbacks run concurrently and must not insert or erase.
+
+    /// Call fn(pair) for every pair; fn may modify the values.
+    template <typename F> void parallel_for_each(F&& fn, unsigned num_threads = 0) {
+        parallel_slots(num_threads, [&](size_type begin, size_type end, unsigned) {
+            for (auto slot = begin; slot < end; slot++)
+                fn(_pairs[slot]);
+        });
+    }
+
+    template <typename F> void parallel_for_each(F&& fn, unsigned num_threads = 0) const {
+        parallel_slots(num_threads, [&](size_type begin, size_type end, unsigned) {
+            for (auto slot = begin; slot < end; slot++)
+                fn(static_cast<const value_type&>(_pairs[slot]));
+        });
+    }
+
+    /// Fold map(pair) over all pairs with reduce, starting from init. Each thread folds its
+    /// run, then the runs are folded into init in slot order, so reduce must be associative.
+    template <typename T, typename MapF, typename ReduceF>
+    T parallel_reduce(T init, MapF&& map, ReduceF&& reduce, unsigned num_threads = 0) const {
+        std::vector<std::unique_ptr<T>> partial(std::max(1u, num_threads ? num_threads
+                                                                          : std::thread::hardware_concurrency()));
+        parallel_slots(num_threads, [&](size_type begin, size_type end, unsigned t) {
+            if (begin == end)
+                return;
+            T acc = map(static_cast<const value_type&>(_pairs[begin]));
+            for (auto slot = begin + 1; slot < end; slot++)
+                acc = reduce(std::move(acc), map(static_cast<const value_type&>(_pairs[slot])));
+            partial[t].reset(new T(std::move(acc)));
+        });
+        for (auto& acc : partial)
+            if (acc)
+                init = reduce(std::move(init), std::move(*acc));
+        return init;
+    }
+
+    /// erase_if() in two phases: pred(pair) runs in parallel and only marks pairs, then the
+    /// calling thread erases them from the highest slot down, so each last-into-hole move
+    /// takes an unmarked pair. When at least half the pairs go, the survivors are compacted
+    /// in slot order and the index is rebuilt instead.
+    template <typename Pred> size_type parallel_erase_if(Pred&& pred, unsigned num_threads = 0) {
+        const auto old_size = _num_filled;
+        std::vector<uint8_t> marks(old_size);
+        parallel_slots(num_threads, [&](size_type begin, size_type end, unsigned) {
+            for (auto slot = begin; slot < end; slot++)
+                marks[slot] = pred(static_cast<const value_type&>(_pairs[slot])) ? 1 : 0;
+        });
+
+        size_type erased = 0;
+        for (const auto mark : marks)
+            erased += mark;
+        if (erased * 2 < old_size) {
+            for (auto slot = old_size; slot-- > 0;) {
+                if (marks[slot])
+                    erase(const_iterator(this, slot));
+            }
+            return erased;
+        }
+
+        compact_slots(marks);
+        return erased;
+    }
+
     static constexpr bool need_explicit_dtor() {
 #if __cplusplus >= 201402L || _MSC_VER > 1600
         return !(std::is_trivially_destructible<KeyT>::value && std::is_trivially_destructible<ValueT>::value);
@@ -1859,6 +2116,42 @@ public:
 #endif
 
 private:
+    // Drop the pairs whose marks are set by compacting the survivors in slot order, then
+    // rebuild the index in place.
+    void compact_slots(const std::vector<uint8_t>& marks) {
+        const auto old_size = _num_filled;
+        size_type kept = 0;
+        for (size_type slot = 0; slot < old_size; slot++) {
+            if (marks[slot])
+                continue;
+            if (kept != slot)
+                _pairs[kept] = std::move(_pairs[slot]);
+            kept++;
+        }
+        if (need_explicit_dtor()) {
+            for (auto slot = kept; slot < old_size; slot++)
+                _pairs[slot].~value_type();
+        }
+        _num_filled = kept;
+        _etail = INACTIVE;
+        reserve(kept); // rebuild the index in place
+    }
+
+    // Cut [0, size()) into one run of at least PARALLEL_MIN_BUCKETS slots per thread and call
+    // fn(begin, end, t) for each on its own thread.
+    template <typename F> void parallel_slots(unsigned num_threads, F&& fn) const {
+        if (num_threads == 0)
+            num_threads = std::max(1u, std::thread::hardware_concurrency());
+        const auto num = _num_filled;
+        const auto max_threads = std::max<size_type>(1, num / PARALLEL_MIN_BUCKETS);
+        num_threads = static_cast<unsigned>(std::min<size_type>(num_threads, max_threads));
+        const auto chunk = (num + num_threads - 1) / num_threads;
+        emhash_detail::run_parallel(num_threads, [&](unsigned t) {
+            const auto begin = std::min<size_type>(num, t * chunk);
+            fn(begin, std::min<size_type>(num, begin + chunk), t);
+        });
+    }
+
     template <typename K> EMH_INLINE uint64_t hash_key(const K& key) const {
         if constexpr (std::is_integral<K>::value) {
 #if EMH_INT_HASH
@@ -0,0 +1,701 @@
+// emhash LRU cache shared between processes (size-based eviction)
+// https://github.com/ktprime/emhash
+// SPDX-License-Identifier: Unlicense OR MIT-0
+// Copyright (c) 2019-2026 Huang Yuanbing bailuzhou@163.com
+//
+// Same bucket chaining and remove_half() policy as emlru_size::lru_cache, but the
+// table lives in a POSIX shared memory object (shm_open) or any mmap-able fd such
+// as a memfd inherited across fork(). Every process maps the segment at its own
+// address, so buckets link to each other by index, never by pointer.
+//
+// The table is split into shards, each with a process-shared robust mutex and a
+// fixed number of buckets. A shard evicts the entries with orderid <= average once
+// it is full, so the cache never grows past the size it was created with.
+//
+// Requirements: trivially copyable KeyT/ValueT, and an HashT that gives the same
+// value in every process (std::hash of integers is fine, a seeded hash is not).
+
+#pragma once
+
+#if !defined(__unix__) && !defined(__APPLE__)
+#error "emlru_shm needs POSIX shared memory"
+#endif
+
+#ifdef __has_include
+#if __has_include("config.hpp")
+#include "config.hpp"
+#elif __has_include("emhash/config.hpp")
+#include "emhash/config.hpp"
+#endif
+#else
+#include "config.hpp"
+#endif
+
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+#include <thread>
+#include <type_traits>
+#include <utility>
+
+#include <fcntl.h>
+#include <pthread.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#ifdef EMH_KEY
+#undef EMH_KEY
+#undef EMH_VAL
+#undef NEXT_BUCKET
+#undef EMH_PKV
+#undef NEW_KVALUE
+#endif
+
+#define EMH_KEY(p, n) p[n].first
+#define EMH_VAL(p, n) p[n].second
+#define NEXT_BUCKET(p, n) p[n].bucket
+#define EMH_PKV(p, n) p[n]
+
+namespace emlru_shm {
+
+constexpr uint32_t INACTIVE = 0xFFFFFFFF;
+
+/// Counters summed over all shards by lru_cache::stats(); shared by every attached process.
+struct lru_stats {
+    uint64_t hits;
+    uint64_t misses;
+    uint64_t inserts;
+    uint64_t evict_capacity; // removed by remove_half()
+    uint64_t owner_dead;     // shards reset after a process died while changing them
+
+    double hit_ratio() const {
+        const auto lookups = hits + misses;
+        return lookups == 0 ? 0.0 : static_cast<double>(hits) / static_cast<double>(lookups);
+    }
+};
+
+/// First bytes of the segment. Written once by the creating process.
+struct segment_header {
+    char magic[8]; // "EMLRUM1"
+    std::atomic<uint32_t> ready;
+    uint32_t key_size;
+    uint32_t value_size;
+    uint32_t slot_size;
+    uint32_t shards;
+    uint32_t shard_buckets;  // power of two
+    uint32_t shard_capacity; // remove_half() once a shard holds this many entries
+    uint64_t segment_size;
+};
+
+/// Per-shard state, one cache line apart from its neighbours.
+struct alignas(64) shard_header {
+    pthread_mutex_t lock;
+    uint32_t num_filled;
+    uint32_t dirty; // set while the chains are being changed
+    uint32_t next_orderid;
+    uint32_t reserved;
+    uint64_t sum_orderid;
+    lru_stats stats;
+};
+
+template <typename First, typename Second> struct entry {
+    Second second;
+    First first;
+    uint32_t bucket;
+    uint32_t orderid;
+};
+
+/// Fixed size LRU cache in shared memory. The first process creates and sizes the
+/// segment; later ones attach to it and get its geometry regardless of their arguments.
+/// All operations copy keys/values in and out under the shard lock, there are no
+/// iterators or references into the segment.
+template <typename KeyT, typename ValueT, typename HashT = std::hash<KeyT>, typename EqT = std::equal_to<KeyT>>
+class lru_cache {
+    static_assert(std::is_trivially_copyable<KeyT>::value && std::is_trivially_copyable<ValueT>::value,
+                  "emlru_shm::lru_cache needs trivially copyable KeyT and ValueT");
+
+    using PairT = entry<KeyT, ValueT>;
+
+public:
+    using key_type = KeyT;
+    using mapped_type = ValueT;
+    using size_type = size_t;
+
+    /// Create the POSIX shared memory object `name` ("/my_cache") sized for max_entries,
+    /// or attach to it if another process got there first.
+    lru_cache(const char* name, uint32_t max_entries, uint32_t shards = 16) {
+        auto fd = shm_open(name, O_RDWR | O_CREAT | O_EXCL, 0600);
+        const auto creator = fd >= 0;
+        if (!creator && errno == EEXIST)
+            fd = shm_open(name, O_RDWR, 0600);
+        if (fd < 0)
+            throw std::system_error(errno, std::generic_category(), std::string("shm_open ") + name);
+
+        _fd = fd;
+        attach(creator, max_entries, shards);
+    }
+
+    /// Use an already opened fd (e.g. memfd_create() before fork()). An empty file is
+    /// sized and initialized here; the cache takes ownership of fd.
+    lru_cache(int fd, uint32_t max_entries, uint32_t shards = 16) {
+        struct stat st;
+        if (fstat(fd, &st) != 0)
+            throw std::system_error(errno, std::generic_category(), "fstat");
+
+        _fd = fd;
+        attach(st.st_size == 0, max_entries, shards);
+    }
+
+    lru_cache(const lru_cache&) = delete;
+    lru_cache& operator=(const lru_cache&) = delete;
+
+    lru_cache(lru_cache&& rhs) noexcept { swap(rhs); }
+
+    lru_cache& operator=(lru_cache&& rhs) noexcept {
+        swap(rhs);
+        return *this;
+    }
+
+    ~lru_cache() {
+        if (_base)
+            munmap(_base, _size);
+        if (_fd >= 0)
+            close(_fd);
+    }
+
+    void swap(lru_cache& rhs) noexcept {
+        std::swap(_hasher, rhs._hasher);
+        std::swap(_eq, rhs._eq);
+        std::swap(_base, rhs._base);
+        std::swap(_size, rhs._size);
+        std::swap(_fd, rhs._fd);
+        std::swap(_header, rhs._header);
+        std::swap(_shards, rhs._shards);
+        std::swap(_num_shards, rhs._num_shards);
+        std::swap(_num_buckets, rhs._num_buckets);
+        std::swap(_mask, rhs._mask);
+        std::swap(_capacity, rhs._capacity);
+    }
+
+    /// Remove the shared memory object; attached processes keep their mapping.
+    static bool unlink(const char* name) { return shm_unlink(name) == 0; }
+
+    // -------------------------------------------------------------
+    size_type size() const {
+        size_type filled = 0;
+        for (uint32_t i = 0; i < _num_shards; i++)
+            filled += __atomic_load_n(&_shards[i].num_filled, __ATOMIC_RELAXED);
+        return filled;
+    }
+
+    bool empty() const { return size() == 0; }
+    size_type capacity() const { return static_cast<size_type>(_capacity) * _num_shards; }
+    uint32_t shard_count() const { return _num_shards; }
+    uint32_t bucket_count() const { return _num_buckets * _num_shards; }
+
+    lru_stats stats() const {
+        lru_stats total = {};
+        for (uint32_t i = 0; i < _num_shards; i++) {
+            shard_lock guard(this, i);
+            const auto& stats = _shards[i].stats;
+            total.hits += stats.hits;
+            total.misses += stats.misses;
+            total.inserts += stats.inserts;
+            total.evict_capacity += stats.evict_capacity;
+            total.owner_dead += stats.owner_dead;
+        }
+        return total;
+    }
+
+    void reset_stats() {
+        for (uint32_t i = 0; i < _num_shards; i++) {
+            shard_lock guard(this, i);
+            _shards[i].stats = lru_stats();
+        }
+    }
+
+    // -------------------------------------------------------------
+    /// Copy the value out and mark the entry as recently used. Returns false if key isn't found.
+    bool try_get(const KeyT& key, ValueT& val) {
+        const auto hash = hash_key(key);
+        shard_lock guard(this, shard_of(hash));
+        const auto bucket = find_filled_bucket(guard.shard, guard.pairs, key, hash);
+        if (bucket == _num_buckets)
+            return false;
+
+        val = EMH_VAL(guard.pairs, bucket);
+        return true;
+    }
+
+    bool contains(const KeyT& key) {
+        const auto hash = hash_key(key);
+        shard_lock guard(this, shard_of(hash));
+        return find_filled_bucket(guard.shard, guard.pairs, key, hash) != _num_buckets;
+    }
+
+    size_type count(const KeyT& key) { return contains(key) ? 1 : 0; }
+
+    ValueT get_or_return_default(const KeyT& key) {
+        ValueT val = ValueT();
+        try_get(key, val);
+        return val;
+    }
+
+    /// Insert key if it is missing, otherwise only mark it as recently used.
+    /// Returns true if the key was inserted.
+    bool insert(const KeyT& key, const ValueT& value) { return insert_impl(key, value, false); }
+
+    /// Insert key or overwrite its value. Returns true if the key was inserted.
+    bool insert_or_assign(const KeyT& key, const ValueT& value) { return insert_impl(key, value, true); }
+
+    /// Apply fn(ValueT&) to the value of key under the shard lock. Returns false if key isn't found.
+    template <typename F> bool update(const KeyT& key, F&& fn) {
+        const auto hash = hash_key(key);
+        shard_lock guard(this, shard_of(hash));
+        const auto bucket = find_filled_bucket(guard.shard, guard.pairs, key, hash);
+        if (bucket == _num_buckets)
+            return false;
+
+        fn(EMH_VAL(guard.pairs, bucket));
+        return true;
+    }
+
+    size_type erase(const KeyT& key) {
+        const auto hash = hash_key(key);
+        shard_lock guard(this, shard_of(hash));
+        set_dirty(guard.shard, 1);
+        const auto bucket = erase_key(guard.pairs, key, hash_bucket(hash));
+        if (bucket != INACTIVE)
+            clear_bucket(guard.shard, guard.pairs, bucket);
+        set_dirty(guard.shard, 0);
+        return bucket != INACTIVE ? 1 : 0;
+    }
+
+    /// Remove all elements of every shard.
+    void clear() {
+        for (uint32_t i = 0; i < _num_shards; i++) {
+            shard_lock guard(this, i);
+            reset_shard(i);
+        }
+    }
+
+private:
+    using shard_type = shard_header;
+
+    // Locks one shard; a shard left dirty by a dead owner is emptied before use.
+    struct shard_lock {
+        shard_lock(const lru_cache* cache, uint32_t index)
+            : shard(cache->_shards + index), pairs(cache->pairs_of(index)) {
+            auto rc = pthread_mutex_lock(&shard->lock);
+#ifdef __linux__
+            if (EMHASH_UNLIKELY(rc == EOWNERDEAD)) {
+                if (shard->dirty)
+                    const_cast<lru_cache*>(cache)->reset_shard(index);
+                shard->stats.owner_dead++;
+                rc = pthread_mutex_consistent(&shard->lock);
+            }
+#endif
+            if (EMHASH_UNLIKELY(rc != 0))
+                throw std::system_error(rc, std::generic_category(), "pthread_mutex_lock");
+        }
+
+        ~shard_lock() { pthread_mutex_unlock(&shard->lock); }
+
+        shard_type* shard;
+        PairT* pairs;
+    };
+
+    void attach(bool creator, uint32_t max_entries, uint32_t shards) {
+        if (creator) {
+            create(max_entries, shards);
+            return;
+        }
+
+        // wait for the creator to size and initialize the segment
+        struct stat st;
+        for (int retry = 0;; retry++) {
+            if (fstat(_fd, &st) != 0)
+                throw std::system_error(errno, std::generic_category(), "fstat");
+            if (st.st_size >= static_cast<off_t>(sizeof(segment_header)))
+                break;
+            if (retry > 5000)
+                throw std::runtime_error("emlru_shm: segment was never initialized");
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+
+        map(static_cast<uint64_t>(st.st_size));
+        for (int retry = 0; _header->ready.load(std::memory_order_acquire) == 0; retry++) {
+            if (retry > 5000)
+                throw std::runtime_error("emlru_shm: segment was never initialized");
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+
+        if (memcmp(_header->magic, "EMLRUM1", 8) != 0 || _header->key_size != sizeof(KeyT) ||
+            _header->value_size != sizeof(ValueT) || _header->slot_size != sizeof(PairT) ||
+            _header->segment_size != _size)
+            throw std::runtime_error("emlru_shm: segment was created for other key/value types");
+        bind();
+    }
+
+    void create(uint32_t max_entries, uint32_t shards) {
+        if (shards == 0)
+            shards = 1;
+        if (max_entries < shards)
+            max_entries = shards;
+        const auto capacity = (max_entries + shards - 1) / shards;
+        uint32_t num_buckets = 8;
+        while (num_buckets < capacity + capacity / 3)
+            num_buckets *= 2;
+
+        const uint64_t size = sizeof(shard_type) * (1 + static_cast<uint64_t>(shards)) +
+                              static_cast<uint64_t>(shards) * (num_buckets + 2) * sizeof(PairT);
+        if (ftruncate(_fd, static_cast<off_t>(size)) != 0)
+            throw std::system_error(errno, std::generic_category(), "ftruncate");
+
+        map(size);
+        memcpy(_header->magic, "EMLRUM1", 8);
+        _header->key_size = sizeof(KeyT);
+        _header->value_size = sizeof(ValueT);
+        _header->slot_size = sizeof(PairT);
+        _header->shards = shards;
+        _header->shard_buckets = num_buckets;
+        _header->shard_capacity = capacity;
+        _header->segment_size = size;
+        bind();
+
+        pthread_mutexattr_t attr;
+        pthread_mutexattr_init(&attr);
+        pthread_mutexattr_setpshared(&attr, PTHREAD_PROCESS_SHARED);
+#ifdef __linux__
+        pthread_mutexattr_setrobust(&attr, PTHREAD_MUTEX_ROBUST);
+#endif
+        for (uint32_t i = 0; i < shards; i++) {
+            pthread_mutex_init(&_shards[i].lock, &attr);
+            _shards[i].stats = lru_stats();
+            reset_shard(i);
+        }
+        pthread_mutexattr_destroy(&attr);
+        _header->ready.store(1, std::memory_order_release);
+    }
+
+    void map(uint64_t size) {
+        static_assert(sizeof(segment_header) <= sizeof(shard_type), "header must fit the first cache line");
+        auto base = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, _fd, 0);
+        if (base == MAP_FAILED)
+            throw std::system_error(errno, std::generic_category(), "mmap");
+        _base = static_cast<char*>(base);
+        _size = size;
+        _header = reinterpret_cast<segment_header*>(_base);
+    }
+
+    void bind() {
+        _shards = reinterpret_cast<shard_type*>(_base + sizeof(shard_type));
+        _num_shards = _header->shards;
+        _num_buckets = _header->shard_buckets;
+        _mask = _num_buckets - 1;
+        _capacity = _header->shard_capacity;
+    }
+
+    PairT* pairs_of(uint32_t index) const {
+        const auto offset = sizeof(shard_type) * (1 + static_cast<uint64_t>(_num_shards)) +
+                            static_cast<uint64_t>(index) * (_num_buckets + 2) * sizeof(PairT);
+        return reinterpret_cast<PairT*>(_base + offset);
+    }
+
+    // A process killed between the two stores leaves the shard dirty for the next owner.
+    static void set_dirty(shard_type* shard, uint32_t dirty) {
+        std::atomic_signal_fence(std::memory_order_seq_cst);
+        shard->dirty = dirty;
+        std::atomic_signal_fence(std::memory_order_seq_cst);
+    }
+
+    void reset_shard(uint32_t index) {
+        auto& shard = _shards[index];
+        auto pairs = pairs_of(index);
+        memset(reinterpret_cast<char*>(pairs), 0, sizeof(PairT) * (_num_buckets + 2));
+        for (uint32_t bucket = 0; bucket < _num_buckets; bucket++)
+            NEXT_BUCKET(pairs, bucket) = INACTIVE;
+        NEXT_BUCKET(pairs, _num_buckets) = NEXT_BUCKET(pairs, _num_buckets + 1) = 0;
+        shard.num_filled = 0;
+        shard.next_orderid = 0;
+        shard.sum_orderid = 0;
+        shard.dirty = 0;
+    }
+
+    bool insert_impl(const KeyT& key, const ValueT& value, bool assign) {
+        const auto hash = hash_key(key);
+        shard_lock guard(this, shard_of(hash));
+        auto& shard = *guard.shard;
+        auto pairs = guard.pairs;
+        auto bucket = lookup_bucket(guard.shard, pairs, key, hash);
+        if (bucket != _num_buckets) {
+            if (assign)
+                EMH_VAL(pairs, bucket) = value;
+            return false;
+        }
+
+        set_dirty(guard.shard, 1);
+        if (shard.num_filled >= _capacity)
+            remove_half(guard.shard, pairs);
+
+        bucket = find_unique_bucket(guard.shard, pairs, hash_bucket(hash));
+        auto& slot = pairs[bucket];
+        memcpy(reinterpret_cast<char*>(&slot.first), &key, sizeof(KeyT));
+        memcpy(reinterpret_cast<char*>(&slot.second), &value, sizeof(ValueT));
+        slot.orderid = ++shard.next_orderid;
+        shard.sum_orderid += slot.orderid;
+        shard.num_filled++;
+        shard.stats.inserts++;
+        set_dirty(guard.shard, 0);
+        return true;
+    }
+
+    // Evict every entry with orderid <= average, like emlru_size::lru_cache::remove_half().
+    // The survivors are renumbered from 1 so the 32 bit orderid never wraps.
+    void remove_half(shard_type* shard, PairT* pairs) {
+        const auto old_nums = shard->num_filled;
+        const auto medium_id = static_cast<uint32_t>(shard->sum_orderid / shard->num_filled);
+        for (uint32_t src_bucket = 0; src_bucket < _num_buckets; src_bucket++) {
+            if (NEXT_BUCKET(pairs, src_bucket) == INACTIVE || pairs[src_bucket].orderid > medium_id)
+                continue;
+
+            const auto bucket = erase_bucket(pairs, src_bucket);
+            clear_bucket(shard, pairs, bucket);
+            if (bucket != src_bucket)
+                src_bucket--;
+        }
+
+        shard->stats.evict_capacity += old_nums - shard->num_filled;
+        if (shard->next_orderid > (1u << 30)) {
+            for (uint32_t bucket = 0; bucket < _num_buckets; bucket++) {
+                if (NEXT_BUCKET(pairs, bucket) != INACTIVE)
+                    pairs[bucket].orderid -= medium_id;
+            }
+            shard->sum_orderid -= static_cast<uint64_t>(medium_id) * shard->num_filled;
+            shard->next_orderid -= medium_id;
+        }
+    }
+
+    void clear_bucket(shard_type* shard, PairT* pairs, uint32_t bucket) {
+        shard->sum_orderid -= pairs[bucket].orderid;
+        NEXT_BUCKET(pairs, bucket) = INACTIVE;
+        pairs[bucket].orderid = 0;
+        shard->num_filled--;
+    }
+
+    uint32_t find_filled_bucket(shard_type* shard, PairT* pairs, const KeyT& key, uint64_t hash) {
+        const auto bucket = lookup_bucket(shard, pairs, key, hash);
+        if (bucket != _num_buckets)
+            shard->stats.hits++;
+        else
+            shard->stats.misses++;
+        return bucket;
+    }
+
+    uint32_t lookup_bucket(shard_type* shard, PairT* pairs, const KeyT& key, uint64_t hash) {
+        auto next_bucket = hash_bucket(hash);
+        if (NEXT_BUCKET(pairs, next_bucket) == INACTIVE)
+            return _num_buckets;
+
+        while (true) {
+            if (_eq(key, EMH_KEY(pairs, next_bucket))) {
+                auto& orderid = pairs[next_bucket].orderid;
+                shard->sum_orderid += ++shard->next_orderid - orderid;
+                orderid = shard->next_orderid;
+                return next_bucket;
+            }
+
+            const auto nbucket = NEXT_BUCKET(pairs, next_bucket);
+            if (nbucket == next_bucket)
+                return _num_buckets;
+            next_bucket = nbucket;
+        }
+    }
+
+    uint32_t erase_key(PairT* pairs, const KeyT& key, uint32_t bucket) {
+        auto next_bucket = NEXT_BUCKET(pairs, bucket);
+        if (next_bucket == INACTIVE)
+            return INACTIVE;
+
+        const auto eqkey = _eq(key, EMH_KEY(pairs, bucket));
+        if (next_bucket == bucket) {
+            return eqkey ? bucket : INACTIVE;
+        } else if (eqkey) {
+            const auto nbucket = NEXT_BUCKET(pairs, next_bucket);
+            const auto orderid = pairs[bucket].orderid;
+            EMH_PKV(pairs, bucket) = EMH_PKV(pairs, next_bucket);
+            pairs[next_bucket].orderid = orderid;
+            NEXT_BUCKET(pairs, bucket) = (nbucket == next_bucket) ? bucket : nbucket;
+            return next_bucket;
+        }
+
+        auto prev_bucket = bucket;
+        while (true) {
+            const auto nbucket = NEXT_BUCKET(pairs, next_bucket);
+            if (_eq(key, EMH_KEY(pairs, next_bucket))) {
+                NEXT_BUCKET(pairs, prev_bucket) = (nbucket == next_bucket) ? prev_bucket : nbucket;
+                return next_bucket;
+            }
+
+            if (nbucket == next_bucket)
+                break;
+            prev_bucket = next_bucket;
+            next_bucket = nbucket;
+        }
+
+        return INACTIVE;
+    }
+
+    uint32_t erase_bucket(PairT* pairs, const uint32_t bucket) {
+        const auto next_bucket = NEXT_BUCKET(pairs, bucket);
+        const auto main_bucket = hash_bucket(hash_key(EMH_KEY(pairs, bucket)));
+        if (bucket == main_bucket) {
+            if (bucket == next_bucket)
+                return bucket;
+
+            const auto nbucket = NEXT_BUCKET(pairs, next_bucket);
+            const auto orderid = pairs[bucket].orderid;
+            EMH_PKV(pairs, bucket) = EMH_PKV(pairs, next_bucket);
+            pairs[next_bucket].orderid = orderid;
+            NEXT_BUCKET(pairs, bucket) = (nbucket == next_bucket) ? bucket : nbucket;
+            return next_bucket;
+        }
+
+        const auto prev_bucket = find_prev_bucket(pairs, main_bucket, bucket);
+        NEXT_BUCKET(pairs, prev_bucket) = (bucket == next_bucket) ? prev_bucket : next_bucket;
+        return bucket;
+    }
+
+    // main --> prev --> bucket --> next --> new
+    uint32_t kickout_bucket(shard_type* shard, PairT* pairs, const uint32_t main_bucket, const uint32_t bucket) {
+        const auto next_bucket = NEXT_BUCKET(pairs, bucket);
+        const auto new_bucket = find_empty_bucket(pairs, next_bucket);
+        const auto prev_bucket = find_prev_bucket(pairs, main_bucket, bucket);
+        NEXT_BUCKET(pairs, prev_bucket) = new_bucket;
+        EMH_PKV(pairs, new_bucket) = EMH_PKV(pairs, bucket);
+        if (next_bucket == bucket)
+            NEXT_BUCKET(pairs, new_bucket) = new_bucket;
+
+        // the moved entry keeps its orderid, clear_bucket() would drop it from the sum
+        shard->num_filled++;
+        shard->sum_orderid += pairs[bucket].orderid;
+        clear_bucket(shard, pairs, bucket);
+        return bucket;
+    }
+
+    // key is not in this shard. Find a place to put it.
+    uint32_t find_empty_bucket(PairT* pairs, const uint32_t bucket_from) {
+        auto bucket = bucket_from + 1;
+        if (NEXT_BUCKET(pairs, bucket) == INACTIVE || NEXT_BUCKET(pairs, ++bucket) == INACTIVE)
+            return bucket;
+
+        // fibonacci probing: 1, 2, 3, 5, 8, 13, 21 ...
+        for (uint32_t last = 1, slot = 4;; slot += ++last) {
+            auto bucket1 = (bucket_from + slot) & _mask;
+            if (NEXT_BUCKET(pairs, bucket1) == INACTIVE || NEXT_BUCKET(pairs, ++bucket1) == INACTIVE)
+                return bucket1;
+
+            if (last > 4) {
+                auto& next = NEXT_BUCKET(pairs, _num_buckets);
+                next &= _mask;
+
+                if (INACTIVE == NEXT_BUCKET(pairs, next++) || INACTIVE == NEXT_BUCKET(pairs, next++))
+                    return next - 1;
+
+                auto medium = (_num_buckets / 2 + next) & _mask;
+                if (INACTIVE == NEXT_BUCKET(pairs, medium) || INACTIVE == NEXT_BUCKET(pairs, ++medium))
+                    return medium;
+            }
+        }
+    }
+
+    uint32_t find_last_bucket(PairT* pairs, uint32_t main_bucket) const {
+        auto next_bucket = NEXT_BUCKET(pairs, main_bucket);
+        if (next_bucket == main_bucket)
+            return main_bucket;
+
+        while (true) {
+            const auto nbucket = NEXT_BUCKET(pairs, next_bucket);
+            if (nbucket == next_bucket)
+                return next_bucket;
+            next_bucket = nbucket;
+        }
+    }
+
+    uint32_t find_prev_bucket(PairT* pairs, uint32_t main_bucket, const uint32_t bucket) const {
+        auto next_bucket = NEXT_BUCKET(pairs, main_bucket);
+        if (next_bucket == bucket)
+            return main_bucket;
+
+        while (true) {
+            const auto nbucket = NEXT_BUCKET(pairs, next_bucket);
+            if (nbucket == bucket)
+                return next_bucket;
+            next_bucket = nbucket;
+        }
+    }
+
+    uint32_t find_unique_bucket(shard_type* shard, PairT* pairs, const uint32_t bucket) {
+        auto next_bucket = NEXT_BUCKET(pairs, bucket);
+        if (next_bucket == INACTIVE) {
+            NEXT_BUCKET(pairs, bucket) = bucket;
+            return bucket;
+        }
+
+        // check current bucket_key is in main bucket or not
+        const auto main_bucket = hash_bucket(hash_key(EMH_KEY(pairs, bucket)));
+        if (main_bucket != bucket) {
+            kickout_bucket(shard, pairs, main_bucket, bucket);
+            NEXT_BUCKET(pairs, bucket) = bucket;
+            return bucket;
+        } else if (next_bucket != bucket)
+            next_bucket = find_last_bucket(pairs, next_bucket);
+
+        // find a new empty and link it to tail
+        const auto new_bucket = NEXT_BUCKET(pairs, next_bucket) = find_empty_bucket(pairs, next_bucket);
+        NEXT_BUCKET(pairs, new_bucket) = new_bucket;
+        return new_bucket;
+    }
+
+    static constexpr uint64_t KC = UINT64_C(11400714819323198485);
+    static inline uint64_t hash64(uint64_t key) {
+#if __SIZEOF_INT128__
+        __uint128_t r = key;
+        r *= KC;
+        return static_cast<uint64_t>(r >> 64) + static_cast<uint64_t>(r);
+#else
+        uint64_t r = key * UINT64_C(0xca4bcaa75ec3f625);
+        return (r >> 32) + r;
+#endif
+    }
+
+    // low bits pick the bucket, high bits the shard
+    inline uint64_t hash_key(const KeyT& key) const { return hash64(static_cast<uint64_t>(_hasher(key))); }
+    inline uint32_t hash_bucket(uint64_t hash) const { return static_cast<uint32_t>(hash) & _mask; }
+    inline uint32_t shard_of(uint64_t hash) const {
+        return static_cast<uint32_t>(((hash >> 32) * _num_shards) >> 32);
+    }
+
+private:
+    HashT _hasher;
+    EqT _eq;
+    char* _base = nullptr;
+    uint64_t _size = 0;
+    int _fd = -1;
+
+    segment_header* _header = nullptr;
+    shard_type* _shards = nullptr;
+    uint32_t _num_shards = 0;
+    uint32_t _num_buckets = 0;
+    uint32_t _mask = 0;
+    uint32_t _capacity = 0;
+};
+
+} // namespace emlru_shm
@@ -28,8 +28,11 @@
 #include "config.hpp"
 #endif
 
+#include "lru_stats.hpp"
+
 #include <cstring>
 #include <cstdlib>
+#include <cstdio>
 #include <type_traits>
 #include <cassert>
 #include <utility>
@@ -39,6 +42,7 @@
 #include <ctime>
 #include <chrono>
 #include <algorithm>
+#include <vector>
 
 // wyhash is now provided by config.hpp (emh_wyhash / wyhash alias)
 
@@ -57,13 +61,38 @@
 #define NEW_KVALUE(key, value, bucket)                                                                                 \
     new (_pairs + bucket) PairT(key, value, bucket);                                                                   \
     _num_filled++;                                                                                                     \
-    update_sum_orderid(_pairs[bucket].orderid)
+    update_sum_orderid(_pairs[bucket].orderid);                                                                        \
+    set_weight(bucket);                                                                                                \
+    EMH_LRU_COUNT(inserts, 1)
 
 namespace emlru_size {
 
 constexpr uint32_t INACTIVE = 0xFFFFFFFF;
 
-template <typename First, typename Second> struct entry {
+/// Counter snapshot returned by lru_cache::stats(), see lru_stats.hpp.
+using lru_stats = emlru::lru_stats;
+
+/// Default weigher: every entry weighs nothing, capacity is bounded by max_bucket only.
+struct no_weigher {};
+
+/// Per-entry weight slot, empty (and optimized away) unless the cache has a weigher.
+template <bool Weighted> struct entry_weight {
+    uint32_t weight;
+};
+
+template <> struct entry_weight<false> {};
+
+/// File header written by lru_cache::snapshot(). Records follow as raw KeyT, ValueT, uint32_t orderid.
+struct snapshot_header {
+    char magic[8];        // "EMLRUS1"
+    uint32_t key_size;    // sizeof(KeyT)
+    uint32_t value_size;  // sizeof(ValueT)
+    uint32_t record_size; // key_size + value_size + 4
+    uint32_t count;       // number of records
+    uint64_t max_orderid; // newest orderid, restore() rebases the others against it
+};
+
+template <typename First, typename Second, bool Weighted = false> struct entry : entry_weight<Weighted> {
     inline static uint32_t next_orderid() {
 #if EMHASH_SET_TIME
         return EMHASH_SET_TIME;
@@ -103,17 +132,19 @@ template <typename First, typename Second> struct entry {
         orderid = next_orderid();
     }
 
-    entry(const entry& pairT) : second(pairT.second), first(pairT.first) {
+    entry(const entry& pairT) : entry_weight<Weighted>(pairT), second(pairT.second), first(pairT.first) {
         bucket = pairT.bucket;
         orderid = pairT.orderid;
     }
 
-    entry(entry&& pairT) : second(std::move(pairT.second)), first(std::move(pairT.first)) {
+    entry(entry&& pairT)
+        : entry_weight<Weighted>(pairT), second(std::move(pairT.second)), first(std::move(pairT.first)) {
         bucket = pairT.bucket;
         orderid = pairT.orderid;
     }
 
     entry& operator=(entry&& pairT) {
+        entry_weight<Weighted>::operator=(pairT);
         second = std::move(pairT.second);
         first = std::move(pairT.first);
         bucket = pairT.bucket;
@@ -122,6 +153,7 @@ template <typename First, typename Second> struct entry {
     }
 
     entry& operator=(const entry& o) {
+        entry_weight<Weighted>::operator=(o);
         second = o.second;
         first = o.first;
         bucket = o.bucket;
@@ -129,7 +161,8 @@ template <typename First, typename Second> struct entry {
         return *this;
     }
 
-    void swap(entry<First, Second>& o) {
+    void swap(entry& o) {
+        std::swap(static_cast<entry_weight<Weighted>&>(*this), static_cast<entry_weight<Weighted>&>(o));
         std::swap(second, o.second);
         std::swap(first, o.first);
         std::swap(orderid, o.orderid);
@@ -142,12 +175,20 @@ template <typename First, typename Second> struct entry {
 }; // __attribute__ ((packed));
 
 /// A cache-friendly hash table with open addressing, linear/qua probing and power-of-two capacity
-template <typename KeyT, typename ValueT, typename HashT = std::hash<KeyT>, typename EqT = std::equal_to<KeyT>>
+///
+/// With a WeighT functor `uint32_t operator()(const KeyT&, const ValueT&)` the cache also
+/// keeps the sum of all entry weights (e.g. bytes) under max_weight, evicting the entries
+/// with the lowest orderid first. The weight is cached in each entry, so values changed in
+/// place through operator[]/try_get must be re-weighed with reweigh(key).
+template <typename KeyT, typename ValueT, typename HashT = std::hash<KeyT>, typename EqT = std::equal_to<KeyT>,
+          typename WeighT = no_weigher>
 class lru_cache {
 private:
-    using htype = lru_cache<KeyT, ValueT, HashT, EqT>;
-    using PairT = entry<KeyT, ValueT>;
-    using value_pair = entry<KeyT, ValueT>;
+    static constexpr bool weighted = !std::is_same<WeighT, no_weigher>::value;
+
+    using htype = lru_cache<KeyT, ValueT, HashT, EqT, WeighT>;
+    using PairT = entry<KeyT, ValueT, weighted>;
+    using value_pair = PairT;
 
 public:
     using key_type = KeyT;
@@ -254,6 +295,9 @@ public:
         _pairs = nullptr;
         _num_filled = 0;
         _max_buckets = max_bucket;
+        _total_weight = 0;
+        _max_weight = ~static_cast<uint64_t>(0);
+        reset_stats();
         max_load_factor(0.85f);
     }
 
@@ -262,6 +306,15 @@ public:
         reserve(bucket);
     }
 
+    /// Weight-bounded cache: evicts once the total weight would exceed max_weight.
+    lru_cache(uint32_t bucket, uint32_t max_bucket, uint64_t max_weight, const WeighT& weigher = WeighT())
+        : _weigher(weigher) {
+        static_assert(weighted, "max_weight needs a WeighT functor");
+        init(max_bucket);
+        _max_weight = max_weight;
+        reserve(bucket);
+    }
+
     lru_cache(const lru_cache& other) {
         _pairs = static_cast<PairT*>(malloc((2 + other._num_buckets) * sizeof(PairT)));
         clone(other);
@@ -321,10 +374,16 @@ public:
         _mlf = other._mlf;
         _max_buckets = other._max_buckets;
         _sum_orderid = other._sum_orderid;
+        _weigher = other._weigher;
+        _total_weight = other._total_weight;
+        _max_weight = other._max_weight;
+#if EMHASH_LRU_STATS
+        _stats = other._stats;
+#endif
         auto opairs = other._pairs;
 
         if (std::is_trivially_copyable<KeyT>::value && std::is_trivially_copyable<ValueT>::value) {
-            memcpy(_pairs, opairs, (_num_buckets + 2) * sizeof(PairT));
+            memcpy(reinterpret_cast<char*>(_pairs), opairs, (_num_buckets + 2) * sizeof(PairT));
         } else {
             for (uint32_t bucket = 0; bucket < _num_buckets; bucket++) {
                 auto next_bucket = NEXT_BUCKET(_pairs, bucket) = NEXT_BUCKET(opairs, bucket);
@@ -345,6 +404,12 @@ public:
         std::swap(_mlf, other._mlf);
         std::swap(_max_buckets, other._max_buckets);
         std::swap(_sum_orderid, other._sum_orderid);
+        std::swap(_weigher, other._weigher);
+        std::swap(_total_weight, other._total_weight);
+        std::swap(_max_weight, other._max_weight);
+#if EMHASH_LRU_STATS
+        std::swap(_stats, other._stats);
+#endif
     }
 
     // -------------------------------------------------------------
@@ -401,6 +466,44 @@ public:
 
     constexpr size_type max_bucket_count() const { return (1 << 30); }
 
+    /// Bytes by role: entries (bucket links, order ids, weights are metadata) and the two tail
+    /// sentinels as padding.
+    emhash::MemoryUsage memory_usage() const noexcept {
+        emhash::MemoryUsage usage;
+        if (_pairs) {
+            usage.add_slots(_num_buckets, _num_filled, sizeof(PairT), sizeof(value_type));
+            usage.padding += 2 * sizeof(PairT);
+        }
+        return usage;
+    }
+
+    /// Snapshot of the hit/miss/insert/eviction counters (compiled in with EMHASH_LRU_STATS).
+    lru_stats stats() const {
+#if EMHASH_LRU_STATS
+        return _stats;
+#else
+        return lru_stats();
+#endif
+    }
+
+    void reset_stats() {
+#if EMHASH_LRU_STATS
+        _stats = lru_stats();
+#endif
+    }
+
+    /// Sum of the cached weights of all entries (always 0 without a weigher).
+    uint64_t total_weight() const { return _total_weight; }
+
+    uint64_t max_weight() const { return _max_weight; }
+
+    /// Change the weight budget, evicting immediately if it is already exceeded.
+    void max_weight(uint64_t value) {
+        _max_weight = value;
+        if (_total_weight > _max_weight)
+            remove_weight(0);
+    }
+
 #ifdef EMHASH_STATIS
     // Returns the bucket number where the element with key k is located.
     size_type bucket(const KeyT& key) const {
@@ -535,7 +638,9 @@ public:
         return {this, const_cast<lru_cache&>(*this).find_filled_bucket(key)};
     }
 
-    bool contains(const KeyT& key) const noexcept { return find_filled_bucket(key) != _num_buckets; }
+    bool contains(const KeyT& key) const noexcept {
+        return const_cast<lru_cache&>(*this).find_filled_bucket(key) != _num_buckets;
+    }
 
     size_type count(const KeyT& key) const noexcept {
         return const_cast<lru_cache&>(*this).find_filled_bucket(key) == _num_buckets ? 0 : 1;
@@ -551,7 +656,7 @@ public:
 
     /// Returns false if key isn't found.
     bool try_get(const KeyT& key, ValueT& val) const noexcept {
-        const auto bucket = find_filled_bucket(key);
+        const auto bucket = const_cast<lru_cache&>(*this).find_filled_bucket(key);
         const auto found = bucket != _num_buckets;
         if (found) {
             val = EMH_VAL(_pairs, bucket);
@@ -567,13 +672,13 @@ public:
 
     /// Const version of the above
     const ValueT* try_get(const KeyT& key) const noexcept {
-        const auto bucket = find_filled_bucket(key);
+        const auto bucket = const_cast<lru_cache&>(*this).find_filled_bucket(key);
         return bucket == _num_buckets ? nullptr : &EMH_VAL(_pairs, bucket);
     }
 
     /// Convenience function.
     ValueT get_or_return_default(const KeyT& key) const noexcept {
-        const auto bucket = find_filled_bucket(key);
+        const auto bucket = const_cast<lru_cache&>(*this).find_filled_bucket(key);
         return bucket == _num_buckets ? ValueT() : EMH_VAL(_pairs, bucket);
     }
 
@@ -584,6 +689,8 @@ public:
     /// and a bool denoting whether the insertion took place.
     std::pair<iterator, bool> insert(const KeyT& key, const ValueT& value) {
         check_expand_need();
+        if (const auto old = find_or_make_room(key, value); old != _num_buckets)
+            return {{this, old}, false};
         const auto bucket = find_or_allocate(key);
         const auto found = NEXT_BUCKET(_pairs, bucket) == INACTIVE;
         if (found) {
@@ -596,6 +703,8 @@ public:
 
     std::pair<iterator, bool> insert(KeyT&& key, ValueT&& value) {
         check_expand_need();
+        if (const auto old = find_or_make_room(key, value); old != _num_buckets)
+            return {{this, old}, false};
         const auto bucket = find_or_allocate(key);
         const auto found = NEXT_BUCKET(_pairs, bucket) == INACTIVE;
         if (found) {
@@ -622,6 +731,7 @@ public:
     /// Same as above, but contains(key) MUST be false
     uint32_t insert_unique(const KeyT& key, const ValueT& value) {
         check_expand_need();
+        check_weight_need(key, value);
         auto bucket = find_unique_bucket(key);
         NEW_KVALUE(key, value, bucket);
         return bucket;
@@ -629,12 +739,15 @@ public:
 
     uint32_t insert_unique(KeyT&& key, ValueT&& value) {
         check_expand_need();
+        check_weight_need(key, value);
         auto bucket = find_unique_bucket(key);
         NEW_KVALUE(std::move(key), std::move(value), bucket);
         return bucket;
     }
 
-    uint32_t insert_unique(entry<KeyT, ValueT>&& pair) {
+    uint32_t insert_unique(PairT&& pair) {
+        check_expand_need();
+        check_weight_need(pair.first, pair.second);
         auto bucket = find_unique_bucket(pair.first);
         NEW_KVALUE(std::move(pair.first), std::move(pair.second), bucket);
         return bucket;
@@ -674,6 +787,8 @@ public:
     /// Like std::map<KeyT,ValueT>::operator[].
     ValueT& operator[](const KeyT& key) {
         check_expand_need();
+        if (const auto old = find_or_make_room(key); old != _num_buckets)
+            return EMH_VAL(_pairs, old);
         auto bucket = find_or_allocate(key);
         /* Check if inserting a new value rather than overwriting an old entry */
         if (NEXT_BUCKET(_pairs, bucket) == INACTIVE) {
@@ -686,6 +801,8 @@ public:
 
     ValueT& operator[](KeyT&& key) {
         check_expand_need();
+        if (const auto old = find_or_make_room(key); old != _num_buckets)
+            return EMH_VAL(_pairs, old);
         auto bucket = find_or_allocate(key);
         /* Check if inserting a new value rather than overwriting an old entry */
         if (NEXT_BUCKET(_pairs, bucket) == INACTIVE) {
@@ -743,10 +860,28 @@ public:
         if (is_notrivially())
             clearkv();
         else
-            memset(_pairs, INACTIVE, sizeof(_pairs[0]) * _num_buckets);
+            memset(reinterpret_cast<char*>(_pairs), INACTIVE, sizeof(_pairs[0]) * _num_buckets);
 
         _num_filled = 0;
         _sum_orderid = 0;
+        _total_weight = 0;
+    }
+
+    /// Recompute the cached weight of key after its value was modified in place.
+    /// Returns false if key isn't found.
+    bool reweigh(const KeyT& key) {
+        const auto bucket = find_filled_bucket(key);
+        if (bucket == _num_buckets)
+            return false;
+
+        if constexpr (weighted) {
+            const auto weight = weigh(EMH_KEY(_pairs, bucket), EMH_VAL(_pairs, bucket));
+            _total_weight = _total_weight - _pairs[bucket].weight + weight;
+            _pairs[bucket].weight = weight;
+            if (EMHASH_UNLIKELY(_total_weight > _max_weight))
+                remove_weight(0);
+        }
+        return true;
     }
 
     inline void update_sum_orderid(int32_t incr) { _sum_orderid += incr; }
@@ -789,13 +924,16 @@ public:
 
     bool remove_half() {
         const auto old_nums = _num_filled;
+#if EMHASH_LRU_STATS
+        const auto pause_start = std::chrono::steady_clock::now();
+#endif
 #if EMHASH_REHASH_LOG || EMHASH_USE_LOG
         const auto ts = clock();
 #endif
         const auto medium_id = static_cast<uint32_t>(_sum_orderid / _num_filled);
 
 #if EMHASH_TIME_DELAY
-        const auto tnows = entry<KeyT, ValueT>::next_orderid();
+        const auto tnows = PairT::next_orderid();
 #endif
 
         // Iterate from bucket 0 to prune expired entries. A random start
@@ -843,9 +981,161 @@ public:
             sumid += _pairs[src_bucket].orderid;
         assert(_sum_orderid == sumid);
 
+        EMH_LRU_COUNT(evict_capacity, old_nums - _num_filled);
+#if EMHASH_LRU_STATS
+        record_pause(pause_start);
+#endif
+
+        return old_nums > _num_filled;
+    }
+
+    /// Evict the entries with the lowest orderid until `incoming` more weight fits
+    /// in the budget. Evicts down to 7/8 of max_weight so that a full cache does
+    /// not rescan itself on every insert.
+    bool remove_weight(uint64_t incoming) {
+        const auto low_mark = _max_weight - _max_weight / 8;
+        const auto target = low_mark > incoming ? low_mark - incoming : 0;
+        if (_num_filled == 0 || _total_weight <= target)
+            return false;
+
+        const auto old_nums = _num_filled;
+#if EMHASH_LRU_STATS
+        const auto pause_start = std::chrono::steady_clock::now();
+#endif
+        const auto need = _total_weight - target;
+        std::vector<std::pair<uint32_t, uint32_t>> orders;
+        orders.reserve(_num_filled);
+        for (uint32_t bucket = 0; bucket < _num_buckets; bucket++) {
+            if (NEXT_BUCKET(_pairs, bucket) != INACTIVE)
+                orders.emplace_back(_pairs[bucket].orderid, weight_of(bucket));
+        }
+
+        // only the oldest prefix holding about `need` weight has to be ordered
+        const auto ratio = static_cast<double>(need) / static_cast<double>(_total_weight);
+        const auto sorted = std::min(orders.size(), static_cast<size_t>(ratio * orders.size()) + 1);
+        std::nth_element(orders.begin(), orders.begin() + (sorted - 1), orders.end());
+        std::sort(orders.begin(), orders.begin() + sorted);
+
+        uint64_t freed = 0;
+        uint32_t max_orderid = 0;
+        for (size_t i = 0; i < orders.size() && freed < need; i++) {
+            if (i == sorted)
+                std::sort(orders.begin() + sorted, orders.end());
+            max_orderid = orders[i].first;
+            freed += orders[i].second;
+        }
+
+        for (uint32_t src_bucket = 0; src_bucket < _num_buckets; src_bucket++) {
+            if (NEXT_BUCKET(_pairs, src_bucket) == INACTIVE || _pairs[src_bucket].orderid > max_orderid)
+                continue;
+
+            const auto bucket = erase_bucket(src_bucket);
+            clear_bucket(bucket);
+            if (bucket != src_bucket)
+                src_bucket--;
+        }
+
+        EMH_LRU_COUNT(evict_capacity, old_nums - _num_filled);
+#if EMHASH_LRU_STATS
+        record_pause(pause_start);
+#endif
         return old_nums > _num_filled;
     }
 
+    /// Write all entries and their orderid to path for a warm restart. Needs trivially
+    /// copyable KeyT/ValueT; the format is native-endian and tied to sizeof(KeyT/ValueT).
+    bool snapshot(const char* path) const {
+        static_assert(std::is_trivially_copyable<KeyT>::value && std::is_trivially_copyable<ValueT>::value,
+                      "snapshot() needs trivially copyable KeyT and ValueT");
+        constexpr uint32_t record_size = sizeof(KeyT) + sizeof(ValueT) + sizeof(uint32_t);
+        snapshot_header header = {{'E', 'M', 'L', 'R', 'U', 'S', '1', 0}, sizeof(KeyT), sizeof(ValueT), record_size,
+                                  _num_filled, 0};
+        for (uint32_t bucket = 0; bucket < _num_buckets; bucket++) {
+            if (NEXT_BUCKET(_pairs, bucket) != INACTIVE && _pairs[bucket].orderid > header.max_orderid)
+                header.max_orderid = _pairs[bucket].orderid;
+        }
+
+        FILE* fp = fopen(path, "wb");
+        if (!fp)
+            return false;
+
+        auto ok = fwrite(&header, sizeof(header), 1, fp) == 1;
+        std::vector<char> buff(record_size * 4096);
+        size_t used = 0;
+        for (uint32_t bucket = 0; ok && bucket < _num_buckets; bucket++) {
+            if (NEXT_BUCKET(_pairs, bucket) == INACTIVE)
+                continue;
+
+            auto record = buff.data() + used;
+            memcpy(record, &EMH_KEY(_pairs, bucket), sizeof(KeyT));
+            memcpy(record + sizeof(KeyT), &EMH_VAL(_pairs, bucket), sizeof(ValueT));
+            memcpy(record + sizeof(KeyT) + sizeof(ValueT), &_pairs[bucket].orderid, sizeof(uint32_t));
+            used += record_size;
+            if (used == buff.size()) {
+                ok = fwrite(buff.data(), used, 1, fp) == 1;
+                used = 0;
+            }
+        }
+        if (ok && used > 0)
+            ok = fwrite(buff.data(), used, 1, fp) == 1;
+
+        return fclose(fp) == 0 && ok;
+    }
+
+    /// Replace the contents with a snapshot() file, keeping the relative order of the saved
+    /// orderids so the hottest entries survive the next eviction. Returns false if the file
+    /// can't be opened, doesn't match KeyT/ValueT or is truncated (records read so far are kept).
+    bool restore(const char* path) {
+        static_assert(std::is_trivially_copyable<KeyT>::value && std::is_trivially_copyable<ValueT>::value,
+                      "restore() needs trivially copyable KeyT and ValueT");
+        constexpr uint32_t record_size = sizeof(KeyT) + sizeof(ValueT) + sizeof(uint32_t);
+        FILE* fp = fopen(path, "rb");
+        if (!fp)
+            return false;
+
+        snapshot_header header;
+        if (fread(&header, sizeof(header), 1, fp) != 1 || memcmp(header.magic, "EMLRUS1", 8) != 0 ||
+            header.key_size != sizeof(KeyT) || header.value_size != sizeof(ValueT) ||
+            header.record_size != record_size) {
+            fclose(fp);
+            return false;
+        }
+
+        clear();
+        reserve(std::min<uint64_t>(header.count, 2ull * _max_buckets - 1));
+
+        // saved orderids are shifted so the newest one maps to the current orderid
+        const auto anchor = PairT::next_orderid();
+        const auto max_orderid = static_cast<uint32_t>(header.max_orderid);
+        std::vector<char> buff(record_size * 4096);
+        KeyT key;
+        ValueT value;
+        uint32_t orderid;
+        auto ok = true;
+        for (uint32_t left = header.count; ok && left > 0;) {
+            const auto records = std::min<uint32_t>(left, 4096);
+            const auto reads = static_cast<uint32_t>(fread(buff.data(), record_size, records, fp));
+            ok = reads == records;
+            left -= reads;
+
+            for (uint32_t i = 0; i < reads; i++) {
+                const auto record = buff.data() + i * record_size;
+                memcpy(&key, record, sizeof(KeyT));
+                memcpy(&value, record + sizeof(KeyT), sizeof(ValueT));
+                memcpy(&orderid, record + sizeof(KeyT) + sizeof(ValueT), sizeof(uint32_t));
+
+                const auto bucket = insert_unique(key, value);
+                const auto age = max_orderid - orderid;
+                _sum_orderid -= _pairs[bucket].orderid;
+                _pairs[bucket].orderid = age < anchor ? anchor - age : 1;
+                _sum_orderid += _pairs[bucket].orderid;
+            }
+        }
+
+        fclose(fp);
+        return ok;
+    }
+
     void rehash(uint32_t required_buckets) {
         if (required_buckets < _num_filled)
             return;
@@ -895,7 +1185,7 @@ public:
             char buff[255] = {0};
             snprintf(buff, sizeof(buff), "    _num_filled/load_factor/K.V/pack/next_orderid = %u/%.3f/%s.%s/%zd|%u",
                      _num_filled, load_factor(), typeid(KeyT).name(), typeid(ValueT).name(), sizeof(_pairs[0]),
-                     entry<KeyT, ValueT>::next_orderid());
+                     PairT::next_orderid());
 #if EMHASH_USE_LOG
             static uint32_t ihashs = 0;
             FDLOG() << "hash_nums = " << ihashs++ << "|" << __FUNCTION__ << "|" << buff << std::endl;
@@ -913,8 +1203,65 @@ private:
     // Can we fit another element?
     inline bool check_expand_need() { return reserve(_num_filled); }
 
+#if EMHASH_LRU_STATS
+    void record_pause(std::chrono::steady_clock::time_point start) {
+        const auto elapsed = std::chrono::steady_clock::now() - start;
+        _stats.add_pause(std::chrono::duration_cast<std::chrono::microseconds>(elapsed).count());
+    }
+#endif
+
+    // Make room in the weight budget for a new key/value before it is placed.
+    template <typename K, typename V> inline void check_weight_need(const K& key, const V& value) {
+        if constexpr (weighted) {
+            const uint64_t weight = weigh(key, value);
+            if (EMHASH_UNLIKELY(_total_weight + weight > _max_weight))
+                remove_weight(weight);
+        }
+    }
+
+    // Bucket of a key that is already cached (its order refreshed), or _num_buckets after
+    // making room for a new entry. A present key keeps its value, so nothing is evicted for it.
+    template <typename K, typename V> inline uint32_t find_or_make_room(const K& key, const V& value) {
+        if constexpr (weighted) {
+            const auto bucket = lookup_bucket(key);
+            if (bucket == _num_buckets)
+                check_weight_need(key, value);
+            return bucket;
+        } else {
+            (void)key, (void)value;
+            return _num_buckets;
+        }
+    }
+
+    inline uint32_t find_or_make_room(const KeyT& key) {
+        if constexpr (weighted)
+            return find_or_make_room(key, ValueT());
+        else
+            return _num_buckets;
+    }
+
+    inline uint32_t weigh(const KeyT& key, const ValueT& value) const {
+        const uint64_t weight = _weigher(key, value);
+        return weight > UINT32_MAX ? UINT32_MAX : static_cast<uint32_t>(weight);
+    }
+
+    inline uint32_t weight_of(uint32_t bucket) const {
+        if constexpr (weighted)
+            return _pairs[bucket].weight;
+        else
+            return 0;
+    }
+
+    inline void set_weight(uint32_t bucket) {
+        if constexpr (weighted) {
+            _pairs[bucket].weight = weigh(EMH_KEY(_pairs, bucket), EMH_VAL(_pairs, bucket));
+            _total_weight += _pairs[bucket].weight;
+        }
+    }
+
     void clear_bucket(uint32_t bucket) {
         update_sum_orderid(0 - static_cast<int>(_pairs[bucket].orderid));
+        _total_weight -= weight_of(bucket);
         if (is_notrivially())
             _pairs[bucket].~PairT();
 
@@ -938,8 +1285,11 @@ private:
                 EMH_PKV(_pairs, bucket).swap(EMH_PKV(_pairs, next_bucket));
             else {
                 const auto orderid = _pairs[bucket].orderid;
+                const auto weight = weight_of(bucket);
                 EMH_PKV(_pairs, bucket) = EMH_PKV(_pairs, next_bucket);
                 _pairs[next_bucket].orderid = orderid;
+                if constexpr (weighted)
+                    _pairs[next_bucket].weight = weight;
                 //                EMH_PKV(_pairs, bucket) = EMH_PKV(_pairs, next_bucket);
             }
 
@@ -978,8 +1328,11 @@ private:
                 EMH_PKV(_pairs, bucket).swap(EMH_PKV(_pairs, next_bucket));
             else {
                 const auto orderid = _pairs[bucket].orderid;
+                const auto weight = weight_of(bucket);
                 EMH_PKV(_pairs, bucket) = EMH_PKV(_pairs, next_bucket);
                 _pairs[next_bucket].orderid = orderid;
+                if constexpr (weighted)
+                    _pairs[next_bucket].weight = weight;
             }
             NEXT_BUCKET(_pairs, bucket) = (nbucket == next_bucket) ? bucket : nbucket;
             return next_bucket;
@@ -992,6 +1345,17 @@ private:
 
     // Find the bucket with this key, or return bucket size
     uint32_t find_filled_bucket(const KeyT& key) {
+        const auto bucket = lookup_bucket(key);
+#if EMHASH_LRU_STATS
+        if (bucket != _num_buckets)
+            _stats.hits++;
+        else
+            _stats.misses++;
+#endif
+        return bucket;
+    }
+
+    uint32_t lookup_bucket(const KeyT& key) {
         const auto bucket = hash_bucket(key);
         auto next_bucket = NEXT_BUCKET(_pairs, bucket);
 
@@ -1037,6 +1401,7 @@ private:
         const auto prev_bucket = find_prev_bucket(main_bucket, bucket);
         NEXT_BUCKET(_pairs, prev_bucket) = new_bucket;
         update_sum_orderid(_pairs[bucket].orderid); // erase will clear orderid
+        _total_weight += weight_of(bucket);         // and weight
         new (_pairs + new_bucket) PairT(std::move(_pairs[bucket]));
         _num_filled++;
         if (next_bucket == bucket)
@@ -1236,6 +1601,13 @@ private:
 
     uint32_t _num_filled;
     uint64_t _sum_orderid;
+
+    WeighT _weigher;
+    uint64_t _total_weight;
+    uint64_t _max_weight;
+#if EMHASH_LRU_STATS
+    lru_stats _stats;
+#endif
 };
 } // namespace emlru_size
 #if __cplusplus > 199711
@@ -0,0 +1,48 @@
+// emhash LRU cache counters
+// https://github.com/ktprime/emhash
+// SPDX-License-Identifier: Unlicense OR MIT-0
+// Copyright (c) 2019-2026 Huang Yuanbing bailuzhou@163.com
+//
+// Counters shared by emlru_size::lru_cache and emlru_time::lru_cache, compiled in with
+// EMHASH_LRU_STATS. Both caches alias emlru::lru_stats into their own namespace.
+
+#pragma once
+
+#include <cstdint>
+
+// Optional hit/miss/insert/eviction counters, see lru_cache::stats()
+#ifndef EMH_LRU_COUNT
+#if EMHASH_LRU_STATS
+#define EMH_LRU_COUNT(field, n) _stats.field += n
+#else
+#define EMH_LRU_COUNT(field, n) (void)0
+#endif
+#endif
+
+namespace emlru {
+
+/// Counter snapshot returned by lru_cache::stats(). All zero unless EMHASH_LRU_STATS is defined.
+struct lru_stats {
+    uint64_t hits;
+    uint64_t misses;         // emlru_time: includes lookups of expired entries
+    uint64_t inserts;
+    uint64_t evict_capacity; // emlru_size: remove_half() or the weight budget; emlru_time: rehash() at max_bucket
+    uint64_t evict_timeout;  // emlru_time: expired entries dropped or overwritten; always 0 in emlru_size
+    uint64_t pauses;         // eviction passes (remove_half(), remove_weight(), rehash(), clear_timeout())
+    uint64_t pause_us[24];   // pause_us[i]: passes that took [2^i, 2^(i+1)) us, pause_us[0] includes < 1us
+
+    double hit_ratio() const {
+        const auto lookups = hits + misses;
+        return lookups == 0 ? 0.0 : static_cast<double>(hits) / static_cast<double>(lookups);
+    }
+
+    void add_pause(uint64_t us) {
+        uint32_t slot = 0;
+        for (; us > 1 && slot + 1 < sizeof(pause_us) / sizeof(pause_us[0]); slot++)
+            us >>= 1;
+        pause_us[slot]++;
+        pauses++;
+    }
+};
+
+} // namespace emlru
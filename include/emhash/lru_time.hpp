@@ -28,8 +28,11 @@
 #include "config.hpp"
 #endif
 
+#include "lru_stats.hpp"
+
 #include <cstring>
 #include <cstdlib>
+#include <cstdio>
 #include <type_traits>
 #include <cassert>
 #include <utility>
@@ -38,9 +41,11 @@
 #include <iterator>
 #include <ctime>
 #include <chrono>
+#include <algorithm>
+#include <vector>
 
 #define IS_TIMEOUT(p, b) (p[b].timeout < nowts())
-#define SET_TIMEOUT(b, t) _pairs[b].timeout = nowts() + t
+#define SET_TIMEOUT(b, t) set_timeout(b, t, t)
 
 #undef NEW_KVALUE
 
@@ -54,6 +59,9 @@ namespace emlru_time {
 
 constexpr uint32_t INACTIVE = 0xFFFFFFFF;
 
+/// Counter snapshot returned by lru_cache::stats(), see lru_stats.hpp.
+using lru_stats = emlru::lru_stats;
+
 inline static uint32_t nowts() {
 #if EMHASH_LRU_TIME > 0
     return EMHASH_LRU_TIME;
@@ -64,40 +72,84 @@ inline static uint32_t nowts() {
 #endif
 }
 
-template <typename First, typename Second> struct entry {
+/// File header written by lru_cache::snapshot(). Records follow as raw KeyT, ValueT,
+/// int32_t remaining hard TTL and, with SoftTTL, int32_t remaining soft TTL (ms).
+struct snapshot_header {
+    char magic[8];        // "EMLRUT1"
+    uint32_t key_size;    // sizeof(KeyT)
+    uint32_t value_size;  // sizeof(ValueT)
+    uint32_t record_size; // key_size + value_size + 4 (+ 4 with SoftTTL)
+    uint32_t count;       // number of records
+    uint64_t saved_at;    // system_clock ms, restore() subtracts the downtime from every TTL
+};
+
+inline uint64_t wall_ms() {
+    return static_cast<uint64_t>(
+        std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::system_clock::now().time_since_epoch())
+            .count());
+}
+
+/// Freshness of an entry returned by lru_cache::find_or_stale().
+enum class freshness : uint8_t {
+    missing, // key not in the cache
+    fresh,   // before its soft deadline
+    refresh, // first lookup past the soft deadline: the caller should reload the value
+    stale,   // past the soft deadline while a refresh is in flight
+    expired, // past the hard deadline but not reclaimed yet
+};
+
+/// Soft deadline slot, empty (and optimized away) unless the cache keeps soft/hard TTL pairs.
+template <bool Soft> struct entry_soft {
+    uint32_t soft_timeout;
+};
+
+template <> struct entry_soft<false> {};
+
+template <typename First, typename Second, bool Soft = false> struct entry : entry_soft<Soft> {
     entry(const First& key, const Second& value, uint32_t ibucket, uint32_t itimeout = 5) : second(value), first(key) {
         bucket = ibucket;
         timeout = nowts() + itimeout;
+        init_soft();
     }
 
     entry(First&& key, Second&& value, uint32_t ibucket, uint32_t itimeout = 5)
         : second(std::move(value)), first(std::move(key)) {
         bucket = ibucket;
         timeout = nowts() + itimeout;
+        init_soft();
     }
 
     entry(const std::pair<First, Second>& pair, uint32_t itimeout = 5) : second(pair.second), first(pair.first) {
         bucket = INACTIVE;
         timeout = nowts() + itimeout;
+        init_soft();
     }
 
     entry(std::pair<First, Second>&& pair, uint32_t itimeout = 5)
         : second(std::move(pair.second)), first(std::move(pair.first)) {
         bucket = INACTIVE;
         timeout = nowts() + itimeout;
+        init_soft();
     }
 
-    entry(const entry& pairT) : second(pairT.second), first(pairT.first) {
+    entry(const entry& pairT) : entry_soft<Soft>(pairT), second(pairT.second), first(pairT.first) {
         bucket = pairT.bucket;
         timeout = pairT.timeout;
     }
 
-    entry(entry&& pairT) : second(std::move(pairT.second)), first(std::move(pairT.first)) {
+    entry(entry&& pairT) : entry_soft<Soft>(pairT), second(std::move(pairT.second)), first(std::move(pairT.first)) {
         bucket = pairT.bucket;
         timeout = pairT.timeout;
     }
 
+    // a new entry is fresh until its hard deadline
+    void init_soft() {
+        if constexpr (Soft)
+            this->soft_timeout = timeout;
+    }
+
     entry& operator=(entry&& pairT) {
+        entry_soft<Soft>::operator=(pairT);
         second = std::move(pairT.second);
         first = std::move(pairT.first);
         bucket = pairT.bucket;
@@ -107,6 +159,7 @@ template <typename First, typename Second> struct entry {
     }
 
     entry& operator=(const entry& o) {
+        entry_soft<Soft>::operator=(o);
         second = o.second;
         first = o.first;
         bucket = o.bucket;
@@ -114,7 +167,8 @@ template <typename First, typename Second> struct entry {
         return *this;
     }
 
-    void swap(entry<First, Second>& o) {
+    void swap(entry& o) {
+        std::swap(static_cast<entry_soft<Soft>&>(*this), static_cast<entry_soft<Soft>&>(o));
         std::swap(second, o.second);
         std::swap(first, o.first);
         std::swap(timeout, o.timeout);
@@ -127,12 +181,17 @@ template <typename First, typename Second> struct entry {
 }; // __attribute__ ((packed));
 
 /// A cache-friendly hash table with open addressing, linear/qua probing and power-of-two capacity
-template <typename KeyT, typename ValueT, typename HashT = std::hash<KeyT>, typename EqT = std::equal_to<KeyT>>
+///
+/// Every entry has a hard deadline (`timeout`) after which lookups miss and its slot may be
+/// reused. With SoftTTL each entry also keeps a soft deadline; between the two the value is
+/// still served but find_or_stale() reports it as due for refresh (stale-while-revalidate).
+template <typename KeyT, typename ValueT, typename HashT = std::hash<KeyT>, typename EqT = std::equal_to<KeyT>,
+          bool SoftTTL = false>
 class lru_cache {
 private:
-    using htype = lru_cache<KeyT, ValueT, HashT, EqT>;
-    using PairT = entry<KeyT, ValueT>;
-    using value_pair = entry<KeyT, ValueT>;
+    using htype = lru_cache<KeyT, ValueT, HashT, EqT, SoftTTL>;
+    using PairT = entry<KeyT, ValueT, SoftTTL>;
+    using value_pair = PairT;
 
 public:
     using key_type = KeyT;
@@ -239,6 +298,7 @@ public:
         _pairs = nullptr;
         _num_filled = 0;
         _max_buckets = max_bucket;
+        reset_stats();
         max_load_factor(0.8f);
     }
 
@@ -312,10 +372,13 @@ public:
         _mlf = other._mlf;
         _max_buckets = other._max_buckets;
         _time_out = other._time_out;
+#if EMHASH_LRU_STATS
+        _stats = other._stats;
+#endif
         auto opairs = other._pairs;
 
         if (std::is_trivially_copyable<KeyT>::value && std::is_trivially_copyable<ValueT>::value) {
-            memcpy(_pairs, opairs, (_num_buckets + 2) * sizeof(PairT));
+            memcpy(reinterpret_cast<char*>(_pairs), opairs, (_num_buckets + 2) * sizeof(PairT));
         } else {
             for (uint32_t bucket = 0; bucket < _num_buckets; bucket++) {
                 auto next_bucket = NEXT_BUCKET(_pairs, bucket) = NEXT_BUCKET(opairs, bucket);
@@ -337,6 +400,9 @@ public:
         std::swap(_mlf, other._mlf);
         std::swap(_time_out, other._time_out);
         std::swap(_max_buckets, other._max_buckets);
+#if EMHASH_LRU_STATS
+        std::swap(_stats, other._stats);
+#endif
     }
 
     bool check_timeout(uint32_t bucket) {
@@ -404,6 +470,32 @@ public:
 
     constexpr size_type max_bucket_count() const { return (1 << 30); }
 
+    /// Bytes by role: entries (bucket links, order ids, soft deadlines are metadata) and the two tail
+    /// sentinels as padding.
+    emhash::MemoryUsage memory_usage() const noexcept {
+        emhash::MemoryUsage usage;
+        if (_pairs) {
+            usage.add_slots(_num_buckets, _num_filled, sizeof(PairT), sizeof(value_type));
+            usage.padding += 2 * sizeof(PairT);
+        }
+        return usage;
+    }
+
+    /// Snapshot of the hit/miss/insert/eviction counters (compiled in with EMHASH_LRU_STATS).
+    lru_stats stats() const {
+#if EMHASH_LRU_STATS
+        return _stats;
+#else
+        return lru_stats();
+#endif
+    }
+
+    void reset_stats() {
+#if EMHASH_LRU_STATS
+        _stats = lru_stats();
+#endif
+    }
+
 #ifdef EMHASH_STATIS
     // Returns the bucket number where the element with key k is located.
     size_type bucket(const KeyT& key) const {
@@ -576,6 +668,52 @@ public:
         return bucket == _num_buckets ? ValueT() : EMH_VAL(_pairs, bucket);
     }
 
+    /// Like try_get(), but also returns values past their deadlines together with their freshness.
+    /// Only the first lookup past the soft deadline gets freshness::refresh, later ones get
+    /// freshness::stale until the entry is touch()ed or its hard deadline passes.
+    std::pair<ValueT*, freshness> find_or_stale(const KeyT& key) noexcept {
+        const auto bucket = find_key_bucket(key);
+        if (bucket == _num_buckets) {
+            EMH_LRU_COUNT(misses, 1);
+            return {nullptr, freshness::missing};
+        }
+
+        const auto now_ts = nowts();
+        auto state = freshness::fresh;
+        if (_pairs[bucket].timeout < now_ts) {
+            state = freshness::expired;
+        } else if constexpr (SoftTTL) {
+            // soft_timeout past the hard deadline marks a refresh in flight
+            auto& soft_timeout = _pairs[bucket].soft_timeout;
+            if (soft_timeout > _pairs[bucket].timeout) {
+                state = freshness::stale;
+            } else if (soft_timeout < now_ts) {
+                state = freshness::refresh;
+                soft_timeout = _pairs[bucket].timeout + 1;
+            }
+        }
+
+        if (state == freshness::expired)
+            EMH_LRU_COUNT(misses, 1);
+        else
+            EMH_LRU_COUNT(hits, 1);
+        return {&EMH_VAL(_pairs, bucket), state};
+    }
+
+    /// Restart the TTL of a live key in place, without moving it. Returns false if key
+    /// is missing or already expired.
+    bool touch(const KeyT& key, int ttl) { return touch(key, ttl, ttl); }
+
+    /// Same as above with separate soft and hard TTLs (soft is clamped to hard).
+    bool touch(const KeyT& key, int soft_ttl, int hard_ttl) {
+        const auto bucket = lookup_bucket(key);
+        if (bucket == _num_buckets)
+            return false;
+
+        set_timeout(bucket, soft_ttl, hard_ttl);
+        return true;
+    }
+
     // -----------------------------------------------------
 
     /// Returns a pair consisting of an iterator to the inserted element
@@ -592,9 +730,11 @@ public:
                 EMH_KEY(_pairs, bucket) = key;
                 EMH_VAL(_pairs, bucket) = value;
                 found = true;
+                EMH_LRU_COUNT(evict_timeout, 1);
             }
             SET_TIMEOUT(bucket, _time_out);
         }
+        EMH_LRU_COUNT(inserts, found);
         return {{this, bucket}, found};
     }
 
@@ -604,17 +744,27 @@ public:
         auto found = NEXT_BUCKET(_pairs, bucket) == INACTIVE;
         if (found) {
             NEW_KVALUE(key, value, bucket);
+            SET_TIMEOUT(bucket, timeout);
         } else {
             if (IS_TIMEOUT(_pairs, bucket)) {
                 EMH_KEY(_pairs, bucket) = key;
                 EMH_VAL(_pairs, bucket) = value;
                 found = true;
+                EMH_LRU_COUNT(evict_timeout, 1);
             }
             SET_TIMEOUT(bucket, timeout);
         }
+        EMH_LRU_COUNT(inserts, found);
         return {{this, bucket}, found};
     }
 
+    /// Insert with a soft/hard TTL pair, see find_or_stale().
+    std::pair<iterator, bool> insert(const KeyT& key, const ValueT& value, int soft_ttl, int hard_ttl) {
+        const auto ret = insert(key, value, hard_ttl);
+        set_timeout(ret.first._bucket, soft_ttl, hard_ttl);
+        return ret;
+    }
+
     //    std::pair<iterator, bool> insert(const value_pair& value) { return insert(value.first, value.second); }
     std::pair<iterator, bool> insert(KeyT&& key, ValueT&& value) {
         check_expand_need();
@@ -627,9 +777,11 @@ public:
                 EMH_KEY(_pairs, bucket) = std::move(key);
                 EMH_VAL(_pairs, bucket) = std::move(value);
                 found = true;
+                EMH_LRU_COUNT(evict_timeout, 1);
             }
             SET_TIMEOUT(bucket, _time_out);
         }
+        EMH_LRU_COUNT(inserts, found);
         return {{this, bucket}, found};
     }
 
@@ -651,6 +803,7 @@ public:
         check_expand_need();
         auto bucket = find_unique_bucket(key);
         NEW_KVALUE(key, value, bucket);
+        EMH_LRU_COUNT(inserts, 1);
         return bucket;
     }
 
@@ -658,12 +811,14 @@ public:
         check_expand_need();
         auto bucket = find_unique_bucket(key);
         NEW_KVALUE(std::move(key), std::move(value), bucket);
+        EMH_LRU_COUNT(inserts, 1);
         return bucket;
     }
 
-    uint32_t insert_unique(entry<KeyT, ValueT>&& pair) {
+    uint32_t insert_unique(PairT&& pair) {
         auto bucket = find_unique_bucket(pair.first);
         NEW_KVALUE(std::move(pair.first), std::move(pair.second), bucket);
+        EMH_LRU_COUNT(inserts, 1);
         return bucket;
     }
 
@@ -705,11 +860,14 @@ public:
         /* Check if inserting a new value rather than overwriting an old entry */
         if (NEXT_BUCKET(_pairs, bucket) == INACTIVE) {
             NEW_KVALUE(key, std::move(ValueT()), bucket);
+            EMH_LRU_COUNT(inserts, 1);
         } else {
             // Bucket holds a timed-out entry: replace its key and reset value.
             if (IS_TIMEOUT(_pairs, bucket)) {
                 EMH_KEY(_pairs, bucket) = key;
                 EMH_VAL(_pairs, bucket) = ValueT();
+                EMH_LRU_COUNT(inserts, 1);
+                EMH_LRU_COUNT(evict_timeout, 1);
             }
 
             SET_TIMEOUT(bucket, _time_out);
@@ -723,10 +881,13 @@ public:
         /* Check if inserting a new value rather than overwriting an old entry */
         if (NEXT_BUCKET(_pairs, bucket) == INACTIVE) {
             NEW_KVALUE(std::move(key), std::move(ValueT()), bucket);
+            EMH_LRU_COUNT(inserts, 1);
         } else {
             if (IS_TIMEOUT(_pairs, bucket)) {
                 EMH_KEY(_pairs, bucket) = std::move(key);
                 EMH_VAL(_pairs, bucket) = std::move(ValueT());
+                EMH_LRU_COUNT(inserts, 1);
+                EMH_LRU_COUNT(evict_timeout, 1);
             }
 
             SET_TIMEOUT(bucket, _time_out);
@@ -777,13 +938,23 @@ public:
     }
 
     void clear_timeout() {
+#if EMHASH_LRU_STATS
+        const auto pause_start = std::chrono::steady_clock::now();
+#endif
         auto now_ts = nowts();
         for (uint32_t bucket = 0; bucket < _num_buckets; ++bucket) {
             if (NEXT_BUCKET(_pairs, bucket) != INACTIVE && _pairs[bucket].timeout < now_ts) {
-                erase_bucket(bucket);
-                clear_bucket(bucket);
+                const auto erased = erase_bucket(bucket);
+                clear_bucket(erased);
+                EMH_LRU_COUNT(evict_timeout, 1);
+                // the next chain entry was moved into bucket, check it again
+                if (erased != bucket)
+                    bucket--;
             }
         }
+#if EMHASH_LRU_STATS
+        record_pause(pause_start);
+#endif
     }
 
     /// Remove all elements, keeping full capacity.
@@ -791,7 +962,7 @@ public:
         if (is_notrivially() || sizeof(PairT) > EMHASH_CACHE_LINE_SIZE || _num_filled < _num_buckets / 4)
             clearkv();
         else
-            memset(_pairs, INACTIVE, sizeof(_pairs[0]) * _num_buckets);
+            memset(reinterpret_cast<char*>(_pairs), INACTIVE, sizeof(_pairs[0]) * _num_buckets);
 
         _num_filled = 0;
     }
@@ -808,6 +979,113 @@ public:
         return true;
     }
 
+    /// Write all live entries and their remaining TTLs to path for a warm restart. Needs
+    /// trivially copyable KeyT/ValueT; the format is native-endian and tied to sizeof(KeyT/ValueT).
+    bool snapshot(const char* path) const {
+        static_assert(std::is_trivially_copyable<KeyT>::value && std::is_trivially_copyable<ValueT>::value,
+                      "snapshot() needs trivially copyable KeyT and ValueT");
+        constexpr uint32_t record_size = sizeof(KeyT) + sizeof(ValueT) + sizeof(int32_t) * (SoftTTL ? 2 : 1);
+        const auto now_ts = nowts();
+        snapshot_header header = {{'E', 'M', 'L', 'R', 'U', 'T', '1', 0}, sizeof(KeyT), sizeof(ValueT), record_size, 0,
+                                  wall_ms()};
+        for (uint32_t bucket = 0; bucket < _num_buckets; bucket++) {
+            if (NEXT_BUCKET(_pairs, bucket) != INACTIVE && _pairs[bucket].timeout >= now_ts)
+                header.count++;
+        }
+
+        FILE* fp = fopen(path, "wb");
+        if (!fp)
+            return false;
+
+        auto ok = fwrite(&header, sizeof(header), 1, fp) == 1;
+        std::vector<char> buff(record_size * 4096);
+        size_t used = 0;
+        for (uint32_t bucket = 0, left = header.count; ok && left > 0 && bucket < _num_buckets; bucket++) {
+            if (NEXT_BUCKET(_pairs, bucket) == INACTIVE || _pairs[bucket].timeout < now_ts)
+                continue;
+
+            left--;
+            auto record = buff.data() + used;
+            const auto hard_left = static_cast<int32_t>(_pairs[bucket].timeout - now_ts);
+            memcpy(record, &EMH_KEY(_pairs, bucket), sizeof(KeyT));
+            memcpy(record + sizeof(KeyT), &EMH_VAL(_pairs, bucket), sizeof(ValueT));
+            memcpy(record + sizeof(KeyT) + sizeof(ValueT), &hard_left, sizeof(int32_t));
+            if constexpr (SoftTTL) {
+                // a refresh in flight is not saved, the entry is due again after restore
+                const auto soft_timeout = std::min(_pairs[bucket].soft_timeout, _pairs[bucket].timeout);
+                const auto soft_left = static_cast<int32_t>(soft_timeout - now_ts);
+                memcpy(record + sizeof(KeyT) + sizeof(ValueT) + sizeof(int32_t), &soft_left, sizeof(int32_t));
+            }
+            used += record_size;
+            if (used == buff.size()) {
+                ok = fwrite(buff.data(), used, 1, fp) == 1;
+                used = 0;
+            }
+        }
+        if (ok && used > 0)
+            ok = fwrite(buff.data(), used, 1, fp) == 1;
+
+        return fclose(fp) == 0 && ok;
+    }
+
+    /// Replace the contents with a snapshot() file. The time elapsed since the snapshot is
+    /// taken off every TTL and entries that expired in between are dropped. Returns false if
+    /// the file can't be opened, doesn't match KeyT/ValueT or is truncated (records read so
+    /// far are kept).
+    bool restore(const char* path) {
+        static_assert(std::is_trivially_copyable<KeyT>::value && std::is_trivially_copyable<ValueT>::value,
+                      "restore() needs trivially copyable KeyT and ValueT");
+        constexpr uint32_t record_size = sizeof(KeyT) + sizeof(ValueT) + sizeof(int32_t) * (SoftTTL ? 2 : 1);
+        FILE* fp = fopen(path, "rb");
+        if (!fp)
+            return false;
+
+        snapshot_header header;
+        if (fread(&header, sizeof(header), 1, fp) != 1 || memcmp(header.magic, "EMLRUT1", 8) != 0 ||
+            header.key_size != sizeof(KeyT) || header.value_size != sizeof(ValueT) ||
+            header.record_size != record_size) {
+            fclose(fp);
+            return false;
+        }
+
+        clear();
+        reserve(std::min(header.count, _max_buckets));
+
+        const auto now_wall = wall_ms();
+        const auto elapsed = static_cast<int64_t>(now_wall > header.saved_at ? now_wall - header.saved_at : 0);
+        std::vector<char> buff(record_size * 4096);
+        KeyT key;
+        ValueT value;
+        int32_t hard_left, soft_left = 0;
+        auto ok = true;
+        for (uint32_t left = header.count; ok && left > 0 && _num_filled < _max_buckets;) {
+            const auto records = std::min<uint32_t>(left, 4096);
+            const auto reads = static_cast<uint32_t>(fread(buff.data(), record_size, records, fp));
+            ok = reads == records;
+            left -= reads;
+
+            for (uint32_t i = 0; i < reads && _num_filled < _max_buckets; i++) {
+                const auto record = buff.data() + i * record_size;
+                memcpy(&hard_left, record + sizeof(KeyT) + sizeof(ValueT), sizeof(int32_t));
+                if (hard_left - elapsed < 0) {
+                    EMH_LRU_COUNT(evict_timeout, 1);
+                    continue;
+                }
+
+                memcpy(&key, record, sizeof(KeyT));
+                memcpy(&value, record + sizeof(KeyT), sizeof(ValueT));
+                if constexpr (SoftTTL)
+                    memcpy(&soft_left, record + sizeof(KeyT) + sizeof(ValueT) + sizeof(int32_t), sizeof(int32_t));
+                const auto bucket = insert_unique(key, value);
+                set_timeout(bucket, static_cast<int>(std::max<int64_t>(soft_left - elapsed, -1)),
+                            static_cast<int>(hard_left - elapsed));
+            }
+        }
+
+        fclose(fp);
+        return ok;
+    }
+
     void rehash(uint32_t required_buckets) {
         if (required_buckets > 2 * _max_buckets)
             required_buckets = 2 * _max_buckets;
@@ -820,6 +1098,9 @@ public:
         auto new_pairs = static_cast<PairT*>(malloc((2 + num_buckets) * sizeof(PairT)));
         if (!new_pairs)
             throw std::bad_alloc();
+#if EMHASH_LRU_STATS
+        const auto pause_start = std::chrono::steady_clock::now();
+#endif
         auto old_num_filled = _num_filled;
         const auto old_num_buckets = _num_buckets;
         auto old_pairs = _pairs;
@@ -847,6 +1128,12 @@ public:
                 const auto bucket = find_unique_bucket(key);
                 NEW_KVALUE(std::move(key), std::move(EMH_VAL(old_pairs, src_bucket)), bucket);
                 _pairs[bucket].timeout = old_pairs[src_bucket].timeout;
+                if constexpr (SoftTTL)
+                    _pairs[bucket].soft_timeout = old_pairs[src_bucket].soft_timeout;
+            } else if (old_pairs[src_bucket].timeout > now_ts) {
+                EMH_LRU_COUNT(evict_capacity, 1);
+            } else {
+                EMH_LRU_COUNT(evict_timeout, 1);
             }
             old_pairs[src_bucket].~PairT();
         }
@@ -869,12 +1156,29 @@ public:
 
         free(old_pairs);
         assert(old_num_filled == 0);
+#if EMHASH_LRU_STATS
+        record_pause(pause_start);
+#endif
     }
 
 private:
     // Can we fit another element?
     inline bool check_expand_need() { return reserve(_num_filled); }
 
+    void set_timeout(uint32_t bucket, int soft_ttl, int hard_ttl) {
+        const auto now_ts = nowts();
+        _pairs[bucket].timeout = now_ts + hard_ttl;
+        if constexpr (SoftTTL)
+            _pairs[bucket].soft_timeout = now_ts + (soft_ttl < hard_ttl ? soft_ttl : hard_ttl);
+    }
+
+#if EMHASH_LRU_STATS
+    void record_pause(std::chrono::steady_clock::time_point start) {
+        const auto elapsed = std::chrono::steady_clock::now() - start;
+        _stats.add_pause(std::chrono::duration_cast<std::chrono::microseconds>(elapsed).count());
+    }
+#endif
+
     void clear_bucket(uint32_t bucket) {
         if (is_notrivially())
             _pairs[bucket].~PairT();
@@ -951,19 +1255,36 @@ private:
 
     // Find the bucket with this key, or return bucket size
     uint32_t find_filled_bucket(const KeyT& key) const {
+        const auto bucket = lookup_bucket(key);
+#if EMHASH_LRU_STATS
+        if (bucket != _num_buckets)
+            _stats.hits++;
+        else
+            _stats.misses++;
+#endif
+        return bucket;
+    }
+
+    uint32_t lookup_bucket(const KeyT& key) const {
+        const auto bucket = find_key_bucket(key);
+        return (bucket == _num_buckets || IS_TIMEOUT(_pairs, bucket)) ? _num_buckets : bucket;
+    }
+
+    // Same as above but also returns entries past their deadline
+    uint32_t find_key_bucket(const KeyT& key) const {
         const auto bucket = hash_bucket(key);
         auto next_bucket = NEXT_BUCKET(_pairs, bucket);
 
         if (next_bucket == INACTIVE)
             return _num_buckets;
         else if (_eq(key, EMH_KEY(_pairs, bucket)))
-            return IS_TIMEOUT(_pairs, bucket) ? _num_buckets : bucket;
+            return bucket;
         else if (next_bucket == bucket)
             return _num_buckets;
 
         while (true) {
             if (_eq(key, EMH_KEY(_pairs, next_bucket)))
-                return (IS_TIMEOUT(_pairs, next_bucket)) ? _num_buckets : next_bucket;
+                return next_bucket;
 
             const auto nbucket = NEXT_BUCKET(_pairs, next_bucket);
             if (nbucket == next_bucket)
@@ -1174,6 +1495,9 @@ private:
 
     uint32_t _num_filled;
     uint32_t _time_out;
+#if EMHASH_LRU_STATS
+    mutable lru_stats _stats;
+#endif
 };
 } // namespace emlru_time
 #if __cplusplus > 199711
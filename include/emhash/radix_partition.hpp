@@ -0,0 +1,49 @@
+// emhash radix partitioning helpers
+// https://github.com/ktprime/emhash
+// SPDX-License-Identifier: MIT
+// Copyright (c) 2019-2026 Huang Yuanbing & bailuzhou AT 163.com
+//
+// Shared by emhash_join::RadixJoin and emhash_agg::GroupBy: which of 2^bits partitions a
+// key belongs to, and a work-stealing loop over the partitions.
+
+#pragma once
+
+#include "config.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+namespace emhash_detail {
+
+// The partition hash only picks the partition; each partition's table hashes its keys
+// with its own hasher. That hash need not spread its bits (std::hash is the identity for
+// integers), so it goes through the murmur3 finalizer and the top bits pick the partition,
+// which splits dense or strided ids evenly.
+inline uint64_t radix_mix(uint64_t h) noexcept {
+    h ^= h >> 33;
+    h *= UINT64_C(0xff51afd7ed558ccd);
+    h ^= h >> 33;
+    h *= UINT64_C(0xc4ceb9fe1a85ec53);
+    return h ^ (h >> 33);
+}
+
+/// Partition in [0, 2^bits) of a key whose partition hash is `key_hash`; bits <= 63.
+inline size_t radix_partition(uint64_t key_hash, unsigned bits) noexcept {
+    return bits ? static_cast<size_t>(radix_mix(key_hash) >> (64 - bits)) : 0;
+}
+
+// fn(p, thread) for every p in [0, parts) on up to num_threads threads. Partitions are
+// handed out one at a time, so a large or skewed partition does not hold up the others.
+template <typename F> void for_each_partition(size_t parts, unsigned num_threads, F&& fn) {
+    num_threads = static_cast<unsigned>(std::max<size_t>(1, std::min<size_t>(num_threads, parts)));
+    std::atomic<size_t> next{0};
+    run_parallel(num_threads, [&](unsigned t) {
+        for (auto p = next.fetch_add(1, std::memory_order_relaxed); p < parts;
+             p = next.fetch_add(1, std::memory_order_relaxed))
+            fn(p, t);
+    });
+}
+
+} // namespace emhash_detail
@@ -419,6 +419,18 @@ public:
     constexpr uint64_t max_size() const { return 1ull << (sizeof(_num_buckets) * 8 - 1); }
     constexpr uint64_t max_bucket_count() const { return max_size(); }
 
+    /// Bytes by role: slots, one state byte per bucket, and as padding the trailing simd
+    /// group of states and the sentinel slot.
+    emhash::MemoryUsage memory_usage() const noexcept {
+        emhash::MemoryUsage usage;
+        if (!_pairs)
+            return usage;
+        usage.add_slots(bucket_to_slot(_num_buckets), _num_filled, sizeof(PairT), sizeof(PairT));
+        usage.metadata += _num_buckets * sizeof(State);
+        usage.padding += sizeof(PairT) + simd_bytes * sizeof(State);
+        return usage;
+    }
+
     // ------------------------------------------------------------
 
     template <typename K = KeyT> iterator find(const K& key) noexcept { return {this, find_filled_bucket(key)}; }
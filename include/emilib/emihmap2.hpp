@@ -456,6 +456,20 @@ public:
     constexpr uint64_t max_size() const { return 1ull << (sizeof(_num_buckets) * 8 - 1); }
     constexpr uint64_t max_bucket_count() const { return max_size(); }
 
+    /// Bytes by role: slots, one state byte per bucket plus the probe offset bytes, and as
+    /// padding the sentinel slot, trailing simd group of states and the spare offsets.
+    emhash::MemoryUsage memory_usage() const noexcept {
+        emhash::MemoryUsage usage;
+        if (!_pairs)
+            return usage;
+        const auto state_size = _num_buckets + simd_bytes;
+        usage.add_slots(_num_buckets, _num_filled, sizeof(PairT), sizeof(PairT));
+        usage.metadata += _num_buckets * sizeof(_states[0]) + _num_buckets / OFFSET_STEP * sizeof(_offset[0]);
+        usage.padding = (_num_buckets + 1) * sizeof(PairT) + state_size * sizeof(_states[0]) +
+                        state_size / OFFSET_STEP * sizeof(_offset[0]) - usage.total();
+        return usage;
+    }
+
     // ------------------------------------------------------------
 
     template <typename K = KeyT> EMH_INLINE iterator find(const K& key) noexcept {
@@ -476,6 +476,19 @@ public:
     constexpr uint64_t max_size() const { return 1ull << (sizeof(_num_buckets) * 8 - 1); }
     constexpr uint64_t max_bucket_count() const { return max_size(); }
 
+    /// Bytes by role: slots, one state byte per bucket, and as padding the sentinel slot and
+    /// the trailing simd group of states rounded up to a cache line.
+    emhash::MemoryUsage memory_usage() const noexcept {
+        emhash::MemoryUsage usage;
+        if (!_buffer)
+            return usage;
+        const auto states_alloc = ((_num_buckets + simd_bytes + 63) / 64) * 64;
+        usage.add_slots(_num_buckets, _num_filled, sizeof(PairT), sizeof(PairT));
+        usage.metadata += _num_buckets;
+        usage.padding = states_alloc + (_num_buckets + 1) * sizeof(PairT) - usage.total();
+        return usage;
+    }
+
     // ------------------------------------------------------------
 
     template <typename K = KeyT> EMH_INLINE iterator find(const K& key) noexcept {
@@ -656,6 +656,18 @@ public:
     constexpr float max_load_factor() const { return mlf; }
     void max_load_factor(float) {} // swiss table has fixed load factor; no-op for API compatibility
 
+    /// Bytes by role: element slots, the 16-byte control group per N slots, and as padding
+    /// the group alignment gap and rounding to alignof(PairT).
+    emhash::MemoryUsage memory_usage() const noexcept {
+        emhash::MemoryUsage usage;
+        if (!_pairs)
+            return usage;
+        usage.add_slots(_capacity(), _num_filled, sizeof(PairT), sizeof(PairT));
+        usage.metadata += _num_groups() * sizeof(group15);
+        usage.padding = buffer_size(_num_groups()) - usage.total();
+        return usage;
+    }
+
     // ─── iterators ────────────────────────────────────────────────────
 
     EMH_INLINE iterator begin() noexcept {
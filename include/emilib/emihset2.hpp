@@ -33,6 +33,10 @@
 #include <utility>
 #include <cassert>
 #include <stdexcept>
+#include <algorithm>
+#include <exception>
+#include <thread>
+#include <vector>
 
 #ifdef _MSC_VER
 #include <intrin.h>
@@ -136,6 +140,14 @@ public:
 #endif
 #pragma GCC diagnostic pop
 
+    /// Keys hashed together by insert_batch/contains_batch, and how far ahead of the
+    /// probe their buckets are prefetched.
+    constexpr static size_t BATCH = 64;
+    constexpr static size_t PREFETCH_AHEAD = 8;
+    /// Smallest and preferred bucket range one assign_parallel() worker fills at a time.
+    constexpr static size_t PARALLEL_MIN_BUCKETS = 1u << 12;
+    constexpr static size_t PARALLEL_RANGE_BUCKETS = 1u << 16;
+
     using value_type = KeyT;
     using reference = KeyT&;
     using const_reference = const KeyT&;
@@ -342,6 +354,20 @@ public:
     constexpr uint64_t max_size() const { return 1ull << (sizeof(_num_buckets) * 8 - 1); }
     constexpr uint64_t max_bucket_count() const { return max_size(); }
 
+    /// Bytes by role: key slots, one state byte per bucket, and as padding the trailing simd
+    /// group of states, its rounding to 8 bytes and the sentinel slot.
+    emhash::MemoryUsage memory_usage() const noexcept {
+        emhash::MemoryUsage usage;
+        if (!_states)
+            return usage;
+        auto status_size = set_simd_bytes + _num_buckets;
+        status_size += (8 - status_size % 8) % 8;
+        usage.add_slots(_num_buckets, _num_filled, sizeof(KeyT), sizeof(KeyT));
+        usage.metadata += _num_buckets;
+        usage.padding = status_size + (_num_buckets + 1) * sizeof(KeyT) - usage.total();
+        return usage;
+    }
+
     // ------------------------------------------------------------
 
     template <typename KeyLike> iterator find(const KeyLike& key) { return iterator(this, find_filled_bucket(key)); }
@@ -402,6 +428,58 @@ public:
         }
     }
 
+    /// Insert keys[0, n); inserted[i] (if not null) is 1 when keys[i] was new, 0 when it was
+    /// already present or repeated earlier in the batch. Returns the number of new keys.
+    /// Keys are hashed BATCH at a time; the state group and key slot of key i + PREFETCH_AHEAD
+    /// are prefetched while key i is probed.
+    size_t insert_batch(const KeyT* keys, size_t n, uint8_t* inserted = nullptr) {
+        uint64_t hashes[BATCH];
+        size_t added = 0;
+        for (size_t base = 0; base < n; base += BATCH) {
+            const size_t len = n - base < BATCH ? n - base : BATCH;
+            reserve(uint64_t(_num_filled) + len); // no rehash inside the chunk
+            hash_batch(keys + base, len, hashes);
+            for (size_t i = 0; i < len; i++) {
+                if (i + PREFETCH_AHEAD < len)
+                    prefetch_bucket(hashes[i + PREFETCH_AHEAD]);
+                const auto& key = keys[base + i];
+                const auto bucket = find_or_allocate(key, hashes[i]);
+                const bool bnew = _states[bucket] % 2 != State::EFILLED;
+                if (bnew) {
+                    _states[bucket] = KEYHASH_MASK(hashes[i]);
+                    new (_keys + bucket) KeyT(key);
+                    _num_filled++;
+                }
+                added += bnew;
+                if (inserted)
+                    inserted[base + i] = bnew;
+            }
+        }
+        return added;
+    }
+
+    /// found[i] = contains(keys[i]) for keys[0, n), hashed and prefetched like insert_batch.
+    /// Returns the number of keys found.
+    size_t contains_batch(const KeyT* keys, size_t n, uint8_t* found) const {
+        uint64_t hashes[BATCH];
+        size_t hits = 0;
+        if (_num_filled == 0) {
+            memset(found, 0, n);
+            return 0;
+        }
+        for (size_t base = 0; base < n; base += BATCH) {
+            const size_t len = n - base < BATCH ? n - base : BATCH;
+            hash_batch(keys + base, len, hashes);
+            for (size_t i = 0; i < len; i++) {
+                if (i + PREFETCH_AHEAD < len)
+                    prefetch_bucket(hashes[i + PREFETCH_AHEAD]);
+                found[base + i] = find_filled_bucket(keys[base + i], hashes[i]) != _num_buckets;
+                hits += found[base + i];
+            }
+        }
+        return hits;
+    }
+
     std::pair<iterator, bool> emplace(const KeyT& key) { return insert(key); }
 
     std::pair<iterator, bool> emplace(KeyT&& key) { return insert(std::move(key)); }
@@ -420,6 +498,109 @@ public:
         }
     }
 
+    /// Replace the contents with the keys of [first, last) (random access; duplicates are kept
+    /// once) using up to num_threads threads (0: hardware concurrency). The table is reserved
+    /// for the whole range and cut into P ranges of at most PARALLEL_RANGE_BUCKETS buckets, at
+    /// least four per thread. The keys are copied out grouped by the range of their main
+    /// bucket, and each worker probes and fills only its own ranges; a key whose probe would
+    /// read past its range is deferred to a serial insert at the end. Small inputs and one
+    /// thread insert serially.
+    template <typename RandomIt> void assign_parallel(RandomIt first, RandomIt last, unsigned num_threads = 0) {
+        using std_size = std::size_t;
+        const auto num = static_cast<std_size>(last - first);
+        clear();
+        reserve(num);
+        if (num_threads == 0)
+            num_threads = std::max(1u, std::thread::hardware_concurrency());
+
+        size_t parts = 1; // at least 4 per thread, and small enough to stay in cache while built
+        while ((parts < 4 * num_threads || _num_buckets / parts > PARALLEL_RANGE_BUCKETS) &&
+               _num_buckets / (parts * 2) >= PARALLEL_MIN_BUCKETS)
+            parts *= 2;
+        if (num_threads == 1 || parts == 1) {
+            insert(first, last);
+            return;
+        }
+
+        const auto sub_buckets = _num_buckets / parts;
+        int shift = 0;
+        while ((size_t(1) << shift) < sub_buckets)
+            shift++;
+        const auto part_of = [&](std_size i) {
+            return static_cast<std_size>((compute_hash(first[i]) & _mask) >> shift);
+        };
+
+        // count keys per (thread, range), then copy them out grouped by range
+        const std_size chunk = (num + num_threads - 1) / num_threads;
+        std::vector<std_size> counts(std_size(num_threads) * parts);
+        emhash_detail::run_parallel(num_threads, [&](unsigned t) {
+            auto* count = &counts[std_size(t) * parts];
+            for (std_size i = t * chunk, end = std::min(num, i + chunk); i < end; i++)
+                count[part_of(i)]++;
+        });
+        std::vector<std_size> part_begin(parts + 1);
+        std_size sum = 0;
+        for (size_t p = 0; p < parts; p++) {
+            part_begin[p] = sum;
+            for (unsigned t = 0; t < num_threads; t++) {
+                const auto n = counts[std_size(t) * parts + p];
+                counts[std_size(t) * parts + p] = sum;
+                sum += n;
+            }
+        }
+        part_begin[parts] = sum;
+        std::vector<KeyT> scattered(num);
+        emhash_detail::run_parallel(num_threads, [&](unsigned t) {
+            auto* pos = &counts[std_size(t) * parts];
+            for (std_size i = t * chunk, end = std::min(num, i + chunk); i < end; i++)
+                scattered[pos[part_of(i)]++] = first[i];
+        });
+
+        // fill buckets [p * sub_buckets, (p + 1) * sub_buckets); deferred keys are compacted
+        // to the front of their range in scattered[]
+        std::vector<std_size> num_deferred(parts), num_added(parts);
+        std::vector<int> max_probe(parts, -1);
+        const auto fill_ranges = [&](unsigned t) {
+            for (size_t p = t; p < parts; p += num_threads) {
+                const auto end_bucket = (p + 1) * sub_buckets;
+                auto deferred = part_begin[p];
+                for (auto i = part_begin[p]; i < part_begin[p + 1]; i++) {
+                    auto& key = scattered[i];
+                    const auto key_hash = static_cast<uint64_t>(compute_hash(key));
+                    const auto bucket = fill_in_range(key, key_hash, end_bucket, max_probe[p]);
+                    if (bucket == static_cast<size_t>(-1)) {
+                        if (deferred != i)
+                            scattered[deferred] = std::move(key);
+                        deferred++;
+                    } else if (bucket != end_bucket) {
+                        new (_keys + bucket) KeyT(std::move(key));
+                        _states[bucket] = KEYHASH_MASK(key_hash);
+                        num_added[p]++;
+                    }
+                }
+                num_deferred[p] = deferred - part_begin[p];
+            }
+        };
+        const auto count_filled = [&] {
+            for (size_t p = 0; p < parts; p++) {
+                _num_filled += static_cast<size_t>(num_added[p]);
+                _max_probe_length = std::max(_max_probe_length, max_probe[p]);
+            }
+        };
+        try {
+            emhash_detail::run_parallel(num_threads, fill_ranges);
+        } catch (...) {
+            count_filled();
+            clear();
+            throw;
+        }
+        count_filled();
+        for (size_t p = 0; p < parts; p++) {
+            for (auto i = part_begin[p]; i < part_begin[p] + num_deferred[p]; i++)
+                insert(std::move(scattered[i]));
+        }
+    }
+
     template <typename T> void insert_unique(T beginc, T endc) {
         reserve(endc - beginc + _num_filled);
         for (; beginc != endc; ++beginc) {
@@ -676,9 +857,64 @@ private:
         return _hasher(key);
     }
 
+    // Hash keys[0, n) into hashes and prefetch the buckets of the first PREFETCH_AHEAD keys.
+    void hash_batch(const KeyT* keys, size_t n, uint64_t* hashes) const {
+        for (size_t i = 0; i < n; i++)
+            hashes[i] = static_cast<uint64_t>(compute_hash(keys[i]));
+        for (size_t i = 0; i < n && i < PREFETCH_AHEAD; i++)
+            prefetch_bucket(hashes[i]);
+    }
+
+    // Probe for key from its main bucket without reading past end_bucket, for a table being
+    // filled by assign_parallel(): returns an empty bucket to fill, end_bucket if the key is
+    // present, or (size_t)-1 when the probe would leave the range.
+    template <typename KeyLike>
+    size_t fill_in_range(const KeyLike& key, uint64_t key_hash, size_t end_bucket, int& max_probe) const {
+        const auto bucket = static_cast<size_t>(key_hash & _mask);
+        const char keymask = static_cast<char>(KEYHASH_MASK(key_hash));
+        const auto filled = SET1_EPI8(keymask);
+        for (auto next_bucket = bucket; next_bucket + set_simd_bytes <= end_bucket; next_bucket += set_simd_bytes) {
+            const auto vec =
+                LOADU_EPI8(reinterpret_cast<decltype(&set_simd_empty)>(reinterpret_cast<char*>(_states) + next_bucket));
+            auto maskf = MOVEMASK_EPI8(CMPEQ_EPI8(vec, filled));
+            while (maskf != 0) {
+                if (_eq(_keys[next_bucket + set_CTZ(maskf)], key))
+                    return end_bucket;
+                maskf &= maskf - 1;
+            }
+
+            const auto maske = MOVEMASK_EPI8(CMPEQ_EPI8(vec, set_simd_empty));
+            if (maske != 0) {
+                const auto ebucket = next_bucket + set_CTZ(maske);
+                max_probe = std::max(max_probe, static_cast<int>(ebucket - bucket));
+                return ebucket;
+            }
+        }
+        return static_cast<size_t>(-1);
+    }
+
+    void prefetch_bucket(uint64_t key_hash) const {
+        const auto bucket = static_cast<size_t>(key_hash & _mask);
+        prefetch_batch(_states + bucket);
+        prefetch_batch(_keys + bucket);
+    }
+
+    static void prefetch_batch(const void* ptr) {
+#if defined(__GNUC__) || defined(__clang__)
+        __builtin_prefetch(ptr, 0, 3);
+#elif defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+        _mm_prefetch(static_cast<const char*>(ptr), _MM_HINT_T0);
+#else
+        (void)ptr;
+#endif
+    }
+
     // Find the bucket with this key, or return (size_t)-1
     template <typename KeyLike> size_t find_filled_bucket(const KeyLike& key) const {
-        const auto key_hash = compute_hash(key);
+        return find_filled_bucket(key, compute_hash(key));
+    }
+
+    template <typename KeyLike> size_t find_filled_bucket(const KeyLike& key, uint64_t key_hash) const {
         auto next_bucket = static_cast<size_t>(key_hash & _mask);
         const char keymask = KEYHASH_MASK(key_hash);
         const auto filled = SET1_EPI8(keymask);
@@ -157,6 +157,11 @@ public:
     using hasher = HashT;
     using key_equal = EqT;
 
+    /// Keys hashed together by insert_batch/contains_batch, and how far ahead of the
+    /// probe their first group is prefetched.
+    constexpr static size_t BATCH = 64;
+    constexpr static size_t PREFETCH_AHEAD = 8;
+
     template <typename UType, typename std::enable_if<!std::is_integral<UType>::value, int8_t>::type = 0>
     inline int8_t hash_key2(size_t& main_bucket, const UType& key) const {
         EMH_MSAN_UNPOISON(&key, sizeof(key));
@@ -444,6 +449,18 @@ public:
     constexpr uint64_t max_size() const { return 1ull << (sizeof(_num_buckets) * 8 - 1); }
     constexpr uint64_t max_bucket_count() const { return max_size(); }
 
+    /// Bytes by role: key slots, one state byte per bucket, and as padding the trailing simd
+    /// group of states and the sentinel slot.
+    emhash::MemoryUsage memory_usage() const noexcept {
+        emhash::MemoryUsage usage;
+        if (!_pairs)
+            return usage;
+        usage.add_slots(_num_buckets, _num_filled, sizeof(KeyT), sizeof(KeyT));
+        usage.metadata += _num_buckets * sizeof(State);
+        usage.padding += sizeof(KeyT) + simd_bytes * sizeof(State);
+        return usage;
+    }
+
     // ------------------------------------------------------------
 
     template <typename K = KeyT> iterator find(const K& key) noexcept { return {this, find_filled_bucket(key)}; }
@@ -529,6 +546,54 @@ public:
         return {{this, bucket}, bempty};
     }
 
+    /// Insert keys[0, n); inserted[i] (if not null) is 1 when keys[i] was new, 0 when it was
+    /// already present or repeated earlier in the batch. Returns the number of new keys.
+    /// Keys are hashed BATCH at a time; the first state group and key slots of key
+    /// i + PREFETCH_AHEAD are prefetched while key i is probed.
+    size_t insert_batch(const KeyT* keys, size_t n, uint8_t* inserted = nullptr) noexcept {
+        size_t buckets[BATCH];
+        int8_t tags[BATCH];
+        size_t added = 0;
+        for (size_t base = 0; base < n; base += BATCH) {
+            const size_t len = n - base < BATCH ? n - base : BATCH;
+            reserve(_num_filled + len); // no rehash inside the chunk
+            hash_batch(keys + base, len, buckets, tags);
+            for (size_t i = 0; i < len; i++) {
+                if (i + PREFETCH_AHEAD < len)
+                    prefetch_group(buckets[i + PREFETCH_AHEAD]);
+                bool bempty = true;
+                const auto bucket = find_or_allocate(keys[base + i], bempty, buckets[i], tags[i]);
+                if (bempty) {
+                    new (_pairs + bucket) PairT(keys[base + i]);
+                    _num_filled++;
+                }
+                added += bempty;
+                if (inserted)
+                    inserted[base + i] = bempty;
+            }
+        }
+        return added;
+    }
+
+    /// found[i] = contains(keys[i]) for keys[0, n), hashed and prefetched like insert_batch.
+    /// Returns the number of keys found.
+    size_t contains_batch(const KeyT* keys, size_t n, uint8_t* found) const noexcept {
+        size_t buckets[BATCH];
+        int8_t tags[BATCH];
+        size_t hits = 0;
+        for (size_t base = 0; base < n; base += BATCH) {
+            const size_t len = n - base < BATCH ? n - base : BATCH;
+            hash_batch(keys + base, len, buckets, tags);
+            for (size_t i = 0; i < len; i++) {
+                if (i + PREFETCH_AHEAD < len)
+                    prefetch_group(buckets[i + PREFETCH_AHEAD]);
+                found[base + i] = find_filled_bucket(keys[base + i], buckets[i], tags[i]) != _num_buckets;
+                hits += found[base + i];
+            }
+        }
+        return hits;
+    }
+
     template <class... Args> inline std::pair<iterator, bool> emplace(Args&&... args) noexcept {
         return do_insert(std::forward<Args>(args)...);
     }
@@ -829,11 +894,30 @@ private:
         return next_bucket & _mask;
     }
 
+    // Compute the main bucket and state tag of keys[0, n) and prefetch the first group of
+    // the first PREFETCH_AHEAD keys.
+    void hash_batch(const KeyT* keys, size_t n, size_t* buckets, int8_t* tags) const noexcept {
+        for (size_t i = 0; i < n; i++)
+            tags[i] = hash_key2(buckets[i], keys[i]);
+        for (size_t i = 0; i < n && i < PREFETCH_AHEAD; i++)
+            prefetch_group(buckets[i]);
+    }
+
+    void prefetch_group(size_t main_bucket) const noexcept {
+        prefetch_read(reinterpret_cast<char*>(&_states[main_bucket]));
+        prefetch_read(reinterpret_cast<char*>(const_cast<KeyT*>(&_pairs[main_bucket])));
+    }
+
     // Find the bucket with this key, or return (size_t)-1
     template <typename K> size_t find_filled_bucket(const K& key) const noexcept {
         size_t main_bucket;
+        const auto key_h2 = hash_key2(main_bucket, key);
+        return find_filled_bucket(key, main_bucket, key_h2);
+    }
+
+    template <typename K> size_t find_filled_bucket(const K& key, size_t main_bucket, int8_t key_h2) const noexcept {
         size_t offset = 0;
-        const auto filled = SET1_EPI8(hash_key2(main_bucket, key));
+        const auto filled = SET1_EPI8(key_h2);
         auto next_bucket = main_bucket;
 
         do {
@@ -868,6 +952,12 @@ private:
         size_t main_bucket;
         const auto key_h2 = hash_key2(main_bucket, key);
         prefetch_write((char*)&_pairs[main_bucket]);
+        return find_or_allocate(key, bnew, main_bucket, key_h2);
+    }
+
+    // find_or_allocate() with the hash already split; the caller made room for one more key.
+    template <typename K>
+    size_t find_or_allocate(const K& key, bool& bnew, size_t main_bucket, int8_t key_h2) noexcept {
         const auto filled = SET1_EPI8(key_h2);
         auto next_bucket = main_bucket;
         size_t offset = 0u;
@@ -0,0 +1,128 @@
+// unit/test_bloom_filter.cpp
+// Split block Bloom filter (emfilter::block_bloom) and the filtered<> map/set front.
+// Covers: no false negatives, measured vs. estimated false positive rate, batched
+//         may_contain, filtered<> insert/erase/rebuild against the bare table.
+#define DOCTEST_CONFIG_IMPLEMENT_WITH_MAIN
+#include "doctest.h"
+#include "emhash/bloom_filter.hpp"
+#include "emhash/hash_set8.hpp"
+#include "emhash/hash_table7.hpp"
+
+#include <cstdint>
+#include <random>
+#include <string>
+#include <vector>
+
+using emfilter::block_bloom;
+
+TEST_CASE("block_bloom has no false negatives") {
+    block_bloom filter(100000);
+    std::mt19937_64 rng(3);
+    std::vector<uint64_t> hashes(100000);
+    for (auto& h : hashes) {
+        h = block_bloom::mix(rng());
+        filter.insert_hash(h);
+    }
+    for (auto h : hashes)
+        REQUIRE(filter.may_contain_hash(h));
+
+    std::vector<uint8_t> out(hashes.size());
+    CHECK(filter.may_contain(hashes.data(), hashes.size(), out.data()) == hashes.size());
+    for (auto bit : out)
+        REQUIRE(bit == 1);
+
+    filter.clear();
+    CHECK(!filter.may_contain_hash(hashes[0]));
+}
+
+TEST_CASE("block_bloom false positive rate follows bits per key") {
+    for (double bits : {6.0, 10.0, 16.0}) {
+        block_bloom filter(200000, bits);
+        CHECK(filter.bit_count() >= static_cast<size_t>(200000 * bits));
+        for (uint64_t i = 0; i < 200000; i++)
+            filter.insert_hash(block_bloom::mix(i));
+
+        size_t positives = 0;
+        const size_t probes = 1000000;
+        for (uint64_t i = 0; i < probes; i++)
+            positives += filter.may_contain_hash(block_bloom::mix(i + (1ull << 40)));
+        const double measured = positives * 1.0 / probes;
+        const double expected = block_bloom::estimated_fpr(bits);
+        MESSAGE(bits, " bits/key: measured ", measured, " estimated ", expected);
+        CHECK(measured < expected * 1.3 + 1e-4);
+        CHECK(measured > expected * 0.7);
+    }
+
+    CHECK(block_bloom::estimated_fpr(10) < 0.015);
+    CHECK(block_bloom::estimated_fpr(20) < block_bloom::estimated_fpr(10));
+    const auto bits = block_bloom::bits_for_fpr(0.001);
+    CHECK(block_bloom::estimated_fpr(bits) <= 0.001);
+    CHECK(block_bloom::estimated_fpr(bits - 0.5) > 0.001);
+}
+
+TEST_CASE("filtered map matches the bare table") {
+    emfilter::filtered<emhash7::HashMap<uint64_t, uint64_t>> map(16);
+    emhash7::HashMap<uint64_t, uint64_t> ref;
+    std::mt19937_64 rng(5);
+
+    for (int i = 0; i < 300000; i++) {
+        const auto key = rng() % 50000;
+        const auto op = rng() % 4;
+        if (op == 0)
+            REQUIRE(map.erase(key) == ref.erase(key));
+        else if (op == 1)
+            REQUIRE(map.insert({key, key + 1}).second == ref.insert({key, key + 1}).second);
+        else if (op == 2)
+            map[key] = ref[key] = key * 3;
+        else
+            REQUIRE(map.contains(key) == (ref.find(key) != ref.end()));
+        REQUIRE(map.stale_count() <= map.size() / 4 + 64);
+    }
+    CHECK(map.size() == ref.size());
+    CHECK(map.filter().capacity() >= map.size());
+
+    std::vector<uint64_t> keys(60000);
+    for (uint64_t k = 0; k < keys.size(); k++)
+        keys[k] = k;
+    std::vector<uint8_t> out(keys.size());
+    CHECK(map.contains_batch(keys.data(), keys.size(), out.data()) == ref.size());
+    for (auto key : keys) {
+        const auto it = ref.find(key);
+        REQUIRE(out[key] == (it != ref.end()));
+        REQUIRE(map.count(key) == ref.count(key));
+        if (it != ref.end())
+            REQUIRE(map.find(key)->second == it->second);
+        else
+            REQUIRE(map.find(key) == map.end());
+    }
+}
+
+TEST_CASE("filtered set rebuilds after erases") {
+    emfilter::filtered<emhash8::HashSet<std::string>> set(1000);
+    for (int i = 0; i < 1000; i++)
+        CHECK(set.emplace(std::to_string(i)).second);
+    CHECK(set.filter().capacity() == 1000);
+    for (int i = 0; i < 1000; i++)
+        REQUIRE(set.may_contain(std::to_string(i)));
+
+    for (int i = 0; i < 900; i++)
+        REQUIRE(set.erase(std::to_string(i)) == 1);
+    CHECK(set.size() == 100);
+    CHECK(set.stale_count() <= set.size() / 4 + 64);
+
+    set.rebuild_filter();
+    CHECK(set.stale_count() == 0);
+    size_t maybe = 0;
+    for (int i = 0; i < 900; i++)
+        maybe += set.may_contain(std::to_string(i));
+    CHECK(maybe < 50);
+    for (int i = 900; i < 1000; i++)
+        REQUIRE(set.contains(std::to_string(i)));
+
+    set.reserve(100000);
+    CHECK(set.filter().capacity() >= 100000);
+    CHECK(set.contains("950"));
+    set.clear();
+    CHECK(set.empty());
+    CHECK(!set.contains("950"));
+}
@@ -0,0 +1,139 @@
+// unit/test_compact_set.cpp
+// emhash_compact::IntSet (bit-packed uint32_t/uint64_t id set).
+// Covers: insert/contains/erase against std::unordered_set, growth and the overflow
+//         stash, iteration order and copies, erase_if, memory per key.
+#define DOCTEST_CONFIG_IMPLEMENT_WITH_MAIN
+#include "doctest.h"
+#include "emhash/hash_set_compact.hpp"
+
+#include <cstdint>
+#include <random>
+#include <unordered_set>
+#include <vector>
+
+using emhash_compact::IntSet;
+
+TEST_CASE_TEMPLATE("compact set matches std::unordered_set", Key, uint32_t, uint64_t) {
+    IntSet<Key> set;
+    std::unordered_set<Key> ref;
+    std::mt19937_64 rng(7);
+
+    for (int i = 0; i < 200000; i++) {
+        const auto key = static_cast<Key>(rng() % 100000);
+        if (rng() % 3 == 0)
+            REQUIRE(set.erase(key) == ref.erase(key));
+        else
+            REQUIRE(set.insert(key) == ref.insert(key).second);
+    }
+    CHECK(set.size() == ref.size());
+    for (Key key = 0; key < 100000; key++)
+        REQUIRE(set.contains(key) == (ref.count(key) == 1));
+
+    size_t visited = 0;
+    for (auto key : set) {
+        CHECK(ref.count(key) == 1);
+        visited++;
+    }
+    CHECK(visited == ref.size());
+}
+
+TEST_CASE_TEMPLATE("compact set keeps extreme keys", Key, uint32_t, uint64_t) {
+    IntSet<Key> set{0, 1, static_cast<Key>(-1), static_cast<Key>(-2), static_cast<Key>(1) << (sizeof(Key) * 8 - 1)};
+    CHECK(set.size() == 5);
+    CHECK(set.contains(0));
+    CHECK(set.contains(static_cast<Key>(-1)));
+    CHECK(!set.insert(static_cast<Key>(-2)));
+    CHECK(set.erase(0) == 1);
+    CHECK(!set.contains(0));
+    CHECK(set.contains(1));
+}
+
+TEST_CASE("compact set survives clustered keys through the stash") {
+    // a high load factor and sequential ids push some keys past MAX_PROBE
+    IntSet<uint32_t> set(64, 0.95f);
+    for (uint32_t i = 0; i < 500000; i++)
+        REQUIRE(set.insert(i * 64));
+    CHECK(set.size() == 500000);
+    for (uint32_t i = 0; i < 500000; i++)
+        REQUIRE(set.contains(i * 64));
+    CHECK(!set.contains(1));
+
+    for (uint32_t i = 0; i < 500000; i += 2)
+        REQUIRE(set.erase(i * 64) == 1);
+    CHECK(set.size() == 250000);
+    for (uint32_t i = 0; i < 500000; i++)
+        REQUIRE(set.contains(i * 64) == (i % 2 == 1));
+
+    set.shrink_to_fit();
+    CHECK(set.size() == 250000);
+    CHECK(set.contains(64));
+    CHECK(set.erase_if([](uint32_t key) { return key % 256 == 64; }) == 125000);
+    CHECK(set.size() == 125000);
+}
+
+TEST_CASE("compact set moves keys sharing a home bucket to the stash") {
+    IntSet<uint32_t> set(1024);
+    REQUIRE(set.bit_count() == 10);
+    std::vector<uint32_t> keys;
+    for (uint32_t key = 0; keys.size() < 200; key++)
+        if (IntSet<uint32_t>::mix(key) >> 22 == 0)
+            keys.push_back(key);
+
+    for (auto key : keys)
+        REQUIRE(set.insert(key));
+    CHECK(set.bit_count() == 10);
+    CHECK(set.stash_size() == 200 - 31);
+    for (auto key : keys)
+        REQUIRE(set.contains(key));
+
+    // a key freed from the window must not be inserted twice
+    for (size_t i = 0; i < 100; i++)
+        REQUIRE(set.erase(keys[i]) == 1);
+    for (auto key : keys)
+        CHECK(set.insert(key) == (key <= keys[99]));
+    CHECK(set.size() == 200);
+
+    set.rehash(24); // the shared top 10 bits now spread over 2^14 homes
+    CHECK(set.stash_size() == 0);
+    for (auto key : keys)
+        REQUIRE(set.contains(key));
+}
+
+TEST_CASE("compact set reserve, copy and clear") {
+    IntSet<uint64_t> set;
+    set.reserve(100000);
+    const auto buckets = set.bucket_count();
+    for (uint64_t i = 0; i < 100000; i++)
+        set.insert(i * 0x9E3779B97F4A7C15ull);
+    CHECK(set.bucket_count() == buckets);
+
+    auto copy = set;
+    CHECK(copy.size() == set.size());
+    for (uint64_t i = 0; i < 100000; i++)
+        REQUIRE(copy.contains(i * 0x9E3779B97F4A7C15ull));
+
+    set.clear();
+    CHECK(set.empty());
+    CHECK(set.begin() == set.end());
+    CHECK(copy.size() == 100000);
+}
+
+TEST_CASE("compact set uses a fraction of emhash2::HashSet memory") {
+    IntSet<uint32_t> set;
+    emhash2::HashSet<uint32_t> full;
+    std::mt19937 rng(11);
+    while (set.size() < (1u << 20)) {
+        const auto key = static_cast<uint32_t>(rng());
+        set.insert(key);
+        full.insert(key);
+    }
+    CHECK(set.size() == full.size());
+    CHECK(set.bits_per_slot() <= 18);
+    CHECK(set.stash_size() * 1000 < set.size());
+
+    const auto bytes = set.memory_usage().total(), full_bytes = full.memory_usage().total();
+    MESSAGE("compact ", bytes * 1.0 / set.size(), " B/key, emhash2 ", full_bytes * 1.0 / full.size(), " B/key");
+    CHECK(bytes * 2 < full_bytes);
+    CHECK(bytes >= set.size() * set.bits_per_slot() / 8);
+    CHECK(set.memory_usage().entries >= set.size() * (set.bits_per_slot() - 5) / 8);
+}
@@ -0,0 +1,151 @@
+// unit/test_counter_map.cpp
+// emhash_counter::CountMap (byte counters that widen into a side table).
+// Covers: increment/decrement/erase against std::unordered_map, widening past 255 and
+//         back, saturation, slot moves on erase, top_k against a full sort
+//         and with k past the size, an empty map.
+#define DOCTEST_CONFIG_IMPLEMENT_WITH_MAIN
+#include "doctest.h"
+#include "emhash/counter_map.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <random>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+using emhash_counter::CountMap;
+
+TEST_CASE("count map matches std::unordered_map") {
+    CountMap<uint64_t> counts;
+    std::unordered_map<uint64_t, uint64_t> ref;
+    std::mt19937_64 rng(9);
+
+    for (int i = 0; i < 400000; i++) {
+        // a few hot keys that widen, many cold ones that stay in a byte
+        const auto key = rng() % 8 == 0 ? rng() % 16 : rng() % 20000;
+        const auto op = rng() % 10;
+        if (op == 0) {
+            REQUIRE(counts.erase(key) == ref.erase(key));
+        } else if (op == 1) {
+            const auto delta = rng() % 300;
+            auto it = ref.find(key);
+            uint64_t expect = 0;
+            if (it != ref.end()) {
+                if (it->second <= delta)
+                    ref.erase(it);
+                else
+                    expect = it->second -= delta;
+            }
+            REQUIRE(counts.decrement(key, delta) == expect);
+        } else {
+            const auto delta = op == 2 ? rng() % 1000 + 1 : 1;
+            REQUIRE(counts.increment(key, delta) == (ref[key] += delta));
+        }
+    }
+
+    CHECK(counts.size() == ref.size());
+    CHECK(counts.wide_count() > 0);
+    uint64_t total = 0;
+    for (const auto& kv : ref) {
+        REQUIRE(counts.get(kv.first) == kv.second);
+        total += kv.second;
+    }
+    CHECK(counts.total() == total);
+    CHECK(counts.get(1u << 30) == 0);
+    CHECK(!counts.contains(1u << 30));
+
+    size_t visited = 0;
+    counts.for_each([&](uint64_t key, uint64_t count) {
+        CHECK(ref.at(key) == count);
+        visited++;
+    });
+    CHECK(visited == ref.size());
+}
+
+TEST_CASE("count map widens and narrows a counter") {
+    CountMap<std::string> counts;
+    for (int i = 0; i < 254; i++)
+        counts.increment("a");
+    CHECK(counts.get("a") == 254);
+    CHECK(counts.wide_count() == 0);
+    CHECK(counts.increment("a") == 255);
+    CHECK(counts.wide_count() == 1);
+    CHECK(counts.increment("a", 1000) == 1255);
+
+    CHECK(counts.decrement("a", 1100) == 155);
+    CHECK(counts.wide_count() == 0);
+    CHECK(counts.get("a") == 155);
+
+    const auto max = std::numeric_limits<uint64_t>::max();
+    counts.increment("b", max - 1);
+    CHECK(counts.increment("b", 5) == max);
+    CHECK(counts.total() == max);
+    CHECK(counts.decrement("b", max) == 0);
+    CHECK(!counts.contains("b"));
+    CHECK(counts.wide_count() == 0);
+}
+
+TEST_CASE("count map keeps wide counters when erase moves the last slot") {
+    CountMap<uint32_t> counts;
+    for (uint32_t key = 0; key < 100; key++)
+        counts.increment(key, key < 50 ? key : 1000 + key);
+    CHECK(counts.wide_count() == 50);
+
+    for (uint32_t key = 0; key < 100; key += 3)
+        CHECK(counts.erase(key) == 1);
+    for (uint32_t key = 0; key < 100; key++)
+        REQUIRE(counts.get(key) == (key % 3 == 0 ? 0 : key < 50 ? key : 1000 + key));
+    CHECK(counts.wide_count() == 33);
+
+    counts.clear();
+    CHECK(counts.empty());
+    CHECK(counts.wide_count() == 0);
+    CHECK(counts.total() == 0);
+}
+
+TEST_CASE("count map top_k matches a full sort") {
+    CountMap<std::string> counts;
+    std::mt19937 rng(13);
+    std::vector<std::string> tokens;
+    for (int i = 0; i < 200000; i++) {
+        // roughly Zipf: small ids are far more frequent
+        const auto id = static_cast<uint32_t>(std::pow(rng() % 100000 + 1, 2.0) / 1e5);
+        tokens.push_back("w" + std::to_string(id));
+    }
+    counts.increment_batch(tokens.begin(), tokens.end());
+
+    std::unordered_map<std::string, uint64_t> ref;
+    for (const auto& token : tokens)
+        ref[token]++;
+    CHECK(counts.size() == ref.size());
+    CHECK(counts.total() == tokens.size());
+
+    std::vector<uint64_t> sorted;
+    for (const auto& kv : ref)
+        sorted.push_back(kv.second);
+    std::sort(sorted.rbegin(), sorted.rend());
+
+    for (size_t k : {size_t(0), size_t(1), size_t(10), size_t(500), ref.size() + 10, SIZE_MAX / 2}) {
+        const auto top = counts.top_k(k);
+        REQUIRE(top.size() == std::min(k, ref.size()));
+        for (size_t i = 0; i < top.size(); i++) {
+            REQUIRE(top[i].second == sorted[i]);
+            REQUIRE(ref.at(top[i].first) == top[i].second);
+        }
+    }
+}
+
+TEST_CASE("count map top_k and for_each on an empty map") {
+    CountMap<uint64_t> counts;
+    CHECK(counts.top_k(SIZE_MAX / 2).empty());
+    size_t calls = 0;
+    counts.for_each([&](uint64_t, uint64_t) { calls++; });
+    CHECK(calls == 0);
+
+    counts.increment(7);
+    counts.erase(7);
+    CHECK(counts.top_k(10).empty());
+}
@@ -1,6 +1,6 @@
 // unit/test_full_api.cpp
 // Extended API: at, try_emplace, insert_or_assign, insert_unique (emhash only),
-// merge, erase_if, shrink_to_fit. Consolidates test_hashmap_full_api.cpp.
+// merge, merge_bulk (emhash8), erase_if, shrink_to_fit. Consolidates test_hashmap_full_api.cpp.
 #define DOCTEST_CONFIG_IMPLEMENT_WITH_MAIN
 #include "doctest.h"
 #include "common/maps.hpp"
@@ -148,6 +148,57 @@ TEST_CASE_TEMPLATE("merge large scale no overlap", Map, AllIntMaps) {
         CHECK(a.contains(i));
 }
 
+namespace {
+// Not empty, so merge_bulk rehashes each key instead of reading rhs's index.
+struct SeededHash {
+    uint64_t seed = 0x9E3779B97F4A7C15ull;
+    size_t operator()(uint64_t key) const { return static_cast<size_t>((key ^ seed) * 0xff51afd7ed558ccdull); }
+};
+} // namespace
+
+TEST_CASE_TEMPLATE("merge_bulk matches merge emhash8", Map, map8<uint64_t, std::string>,
+                   emhash8::HashMap<uint64_t, std::string, SeededHash>) {
+    // (size of a, size of b, first key of b): b smaller, larger, fully overlapping, disjoint
+    const uint64_t shapes[][3] = {{50000, 3000, 40000}, {2000, 80000, 1000}, {5000, 5000, 0}, {100, 100, 1000}};
+    for (const auto& shape : shapes) {
+        Map a, b, ref_a, ref_b;
+        for (uint64_t i = 0; i < shape[0]; ++i) {
+            a.emplace(i * 7, "a" + std::to_string(i));
+            ref_a.emplace(i * 7, "a" + std::to_string(i));
+        }
+        for (uint64_t i = shape[2]; i < shape[2] + shape[1]; ++i) {
+            b.emplace(i * 7, "b" + std::to_string(i));
+            ref_b.emplace(i * 7, "b" + std::to_string(i));
+        }
+
+        a.merge_bulk(b);
+        ref_a.merge(ref_b);
+        REQUIRE(a.size() == ref_a.size());
+        REQUIRE(b.size() == ref_b.size());
+        for (const auto& kv : ref_a)
+            REQUIRE(a.at(kv.first) == kv.second);
+        for (const auto& kv : ref_b)
+            REQUIRE(b.at(kv.first) == kv.second);
+
+        // both stay ordinary tables
+        a.emplace(1, "x");
+        b.emplace(1, "y");
+        CHECK(a.at(1) == "x");
+        CHECK(b.erase(1) == 1);
+        for (const auto& kv : ref_b)
+            CHECK(b.erase(kv.first) == 1);
+        CHECK(b.empty());
+    }
+
+    Map a, empty;
+    a.emplace(1, "1");
+    empty.merge_bulk(a);
+    CHECK(empty.size() == 1);
+    CHECK(a.empty());
+    empty.merge_bulk(empty);
+    CHECK(empty.size() == 1);
+}
+
 TEST_CASE_TEMPLATE("merge large scale 50% overlap", Map, AllIntMaps) {
     Map a;
     Map b;
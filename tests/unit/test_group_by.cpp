@@ -0,0 +1,202 @@
+// unit/test_group_by.cpp
+// emhash_agg::GroupBy against a serial std::unordered_map aggregation.
+// Covers: Sum/Count/Min/Max, a custom aggregate, 1 and 4 threads, spill thresholds from
+//         1 group to never, radix_bits 0 / auto / explicit, emhash8 tables, string keys,
+//         batched add() calls, find/for_each/partition, clear, the pre-aggregation bypass.
+#define DOCTEST_CONFIG_IMPLEMENT_WITH_MAIN
+#include "doctest.h"
+#include "common/maps.hpp"
+
+#include "emhash/group_by.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <random>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace {
+
+struct Rows {
+    std::vector<uint64_t> keys;
+    std::vector<int64_t> values;
+};
+
+Rows random_rows(size_t n, uint64_t groups, uint64_t seed) {
+    std::mt19937_64 rng(seed);
+    Rows rows;
+    for (size_t i = 0; i < n; i++) {
+        rows.keys.push_back(rng() % groups);
+        rows.values.push_back(static_cast<int64_t>(rng() % 2001) - 1000);
+    }
+    return rows;
+}
+
+// Serial reference with the same aggregate.
+template <typename Agg> std::unordered_map<uint64_t, typename Agg::state_type> reference(const Rows& rows) {
+    const Agg agg;
+    std::unordered_map<uint64_t, typename Agg::state_type> ref;
+    for (size_t i = 0; i < rows.keys.size(); i++)
+        agg.update(ref.emplace(rows.keys[i], agg.init()).first->second, rows.values[i]);
+    return ref;
+}
+
+template <typename G, typename Ref> void check_groups(const G& g, const Ref& ref) {
+    CHECK(g.size() == ref.size());
+    size_t missing = 0, wrong = 0;
+    for (const auto& kv : ref) {
+        const auto* state = g.find(kv.first);
+        missing += state == nullptr;
+        wrong += state && !(*state == kv.second);
+    }
+    CHECK(missing == 0);
+    CHECK(wrong == 0);
+
+    size_t visited = 0, extra = 0;
+    g.for_each([&](uint64_t key, const typename G::state_type&) {
+        visited++;
+        extra += ref.count(key) == 0;
+    });
+    CHECK(visited == ref.size());
+    CHECK(extra == 0);
+}
+
+emhash_agg::GroupByOptions options(unsigned threads, size_t spill, unsigned radix_bits = ~0u) {
+    emhash_agg::GroupByOptions o;
+    o.threads = threads;
+    o.spill_groups = spill;
+    o.radix_bits = radix_bits;
+    return o;
+}
+
+// Mean as a custom aggregate: (sum, count) states.
+struct SumCount {
+    using state_type = std::pair<int64_t, uint64_t>;
+    state_type init() const { return {0, 0}; }
+    void update(state_type& s, int64_t v) const {
+        s.first += v;
+        s.second++;
+    }
+    void merge(state_type& s, const state_type& o) const {
+        s.first += o.first;
+        s.second += o.second;
+    }
+};
+
+} // namespace
+
+TEST_CASE_TEMPLATE("group by matches a serial aggregation", Agg, emhash_agg::Sum<int64_t>,
+                   emhash_agg::Count<int64_t>, emhash_agg::Min<int64_t>, emhash_agg::Max<int64_t>, SumCount) {
+    for (const uint64_t groups : {10ull, 5000ull, 1ull << 40}) {
+        const auto rows = random_rows(60000, groups, groups);
+        const auto ref = reference<Agg>(rows);
+        for (const unsigned threads : {1u, 4u}) {
+            for (const size_t spill : {size_t(1), size_t(100), size_t(1) << 30}) {
+                CAPTURE(groups);
+                CAPTURE(threads);
+                CAPTURE(spill);
+                emhash_agg::GroupBy<uint64_t, int64_t, Agg> g(options(threads, spill));
+                g.add(rows.keys, rows.values);
+                check_groups(g, ref);
+                CHECK(g.spilled() >= g.size());
+                CHECK(g.spilled() <= rows.keys.size());
+            }
+        }
+    }
+}
+
+TEST_CASE("group by partitions") {
+    const auto rows = random_rows(50000, 3000, 1);
+    const auto ref = reference<emhash_agg::Sum<int64_t>>(rows);
+
+    for (const unsigned bits : {0u, 1u, 6u}) {
+        emhash_agg::GroupBy<uint64_t, int64_t> g(options(4, 256, bits));
+        CHECK(g.radix_bits() == bits);
+        CHECK(g.partitions() == (size_t(1) << bits));
+        g.add(rows.keys, rows.values);
+        check_groups(g, ref);
+
+        // every key sits in exactly one partition
+        size_t total = 0, duplicated = 0;
+        for (size_t p = 0; p < g.partitions(); p++) {
+            total += g.partition(p).size();
+            for (size_t q = p + 1; q < g.partitions(); q++)
+                for (const auto& kv : g.partition(p))
+                    duplicated += g.partition(q).count(kv.first);
+        }
+        CHECK(total == ref.size());
+        CHECK(duplicated == 0);
+    }
+
+    emhash_agg::GroupBy<uint64_t, int64_t> one(options(1, 256));
+    CHECK(one.partitions() == 1);
+    emhash_agg::GroupBy<uint64_t, int64_t> four(options(4, 256));
+    CHECK(four.partitions() >= 16);
+}
+
+TEST_CASE("group by low cardinality pre-aggregates") {
+    const auto rows = random_rows(100000, 8, 2);
+    emhash_agg::GroupBy<uint64_t, int64_t> g(options(4, 1 << 14));
+    g.add(rows.keys, rows.values);
+    CHECK(g.size() == 8);
+    CHECK(g.spilled() <= 8 * 4); // one partial state per group and worker
+}
+
+TEST_CASE("group by stops pre-aggregating distinct keys") {
+    Rows rows;
+    for (uint64_t i = 0; i < 50000; i++) {
+        rows.keys.push_back(i * 7919);
+        rows.values.push_back(1);
+    }
+    emhash_agg::GroupBy<uint64_t, int64_t> g(options(4, 100));
+    g.add(rows.keys, rows.values);
+    CHECK(g.size() == rows.keys.size());
+    // each worker spills its first 100 groups from the local table, then the rest row by row
+    CHECK(g.spilled() == rows.keys.size());
+    const auto* state = g.find(7919 * 1234);
+    REQUIRE(state != nullptr);
+    CHECK(*state == 1);
+}
+
+TEST_CASE("group by batches, emhash8 tables and clear") {
+    using Map8 = emhash8::HashMap<uint64_t, int64_t>;
+    const auto rows = random_rows(40000, 7000, 3);
+    const auto ref = reference<emhash_agg::Sum<int64_t>>(rows);
+
+    emhash_agg::GroupBy<uint64_t, int64_t, emhash_agg::Sum<int64_t>, Map8> g(options(4, 500));
+    for (size_t first = 0; first < rows.keys.size(); first += 9999) {
+        const auto n = std::min<size_t>(9999, rows.keys.size() - first);
+        g.add(rows.keys.data() + first, rows.values.data() + first, n);
+    }
+    check_groups(g, ref);
+    CHECK(g.memory_usage().entries >= g.size() * sizeof(std::pair<uint64_t, int64_t>));
+
+    g.clear();
+    CHECK(g.empty());
+    CHECK(g.spilled() == 0);
+    CHECK(g.find(rows.keys[0]) == nullptr);
+    g.add(rows.keys, rows.values);
+    check_groups(g, ref);
+
+    g.add(nullptr, nullptr, 0);
+    check_groups(g, ref);
+}
+
+TEST_CASE("group by on string keys") {
+    std::vector<std::string> keys;
+    std::vector<int> values;
+    for (int i = 0; i < 20000; i++) {
+        keys.push_back("group" + std::to_string(i % 777));
+        values.push_back(i);
+    }
+    emhash_agg::GroupBy<std::string, int, emhash_agg::Max<int>> g(options(4, 64));
+    g.add(keys, values);
+    CHECK(g.size() == 777);
+    for (int k = 0; k < 777; k++) {
+        const auto* max = g.find("group" + std::to_string(k));
+        REQUIRE(max != nullptr);
+        CHECK(*max == k + 777 * ((20000 - 1 - k) / 777));
+    }
+}
@@ -0,0 +1,213 @@
+// unit/test_hash_join.cpp
+// emhash_join::RadixJoin inner/semi/anti joins against a naive std::unordered_multimap join.
+// Covers: duplicate build keys, 1 and 4 threads, radix_bits 0 / auto / explicit,
+//         emhash8 and emilib2 tables, string keys, empty inputs, rebuilds, worker indices.
+#define DOCTEST_CONFIG_IMPLEMENT_WITH_MAIN
+#include "doctest.h"
+#include "common/maps.hpp"
+
+#include "emhash/hash_join.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <random>
+#include <string>
+#include <tuple>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace {
+
+using Join8 = emhash_join::RadixJoin<uint64_t, uint32_t, uint32_t>;
+using Join2 = emhash_join::RadixJoin<uint64_t, uint32_t, uint32_t, emilib2::HashMap<uint64_t, uint32_t>>;
+using Row = std::pair<uint64_t, uint32_t>;
+using Pair = std::tuple<uint64_t, uint32_t, uint32_t>; // key, build payload, probe payload
+
+std::vector<Row> random_rows(size_t n, uint64_t range, uint64_t seed) {
+    std::mt19937_64 rng(seed);
+    std::vector<Row> rows(n);
+    for (size_t i = 0; i < n; i++)
+        rows[i] = {rng() % range, static_cast<uint32_t>(i)};
+    return rows;
+}
+
+struct Expected {
+    std::vector<Pair> inner;
+    std::vector<uint32_t> semi, anti;
+};
+
+Expected naive_join(const std::vector<Row>& build, const std::vector<Row>& probe) {
+    std::unordered_multimap<uint64_t, uint32_t> table(build.begin(), build.end());
+    Expected e;
+    for (const auto& row : probe) {
+        const auto range = table.equal_range(row.first);
+        (range.first == range.second ? e.anti : e.semi).push_back(row.second);
+        for (auto it = range.first; it != range.second; ++it)
+            e.inner.emplace_back(row.first, it->second, row.second);
+    }
+    std::sort(e.inner.begin(), e.inner.end());
+    std::sort(e.semi.begin(), e.semi.end());
+    std::sort(e.anti.begin(), e.anti.end());
+    return e;
+}
+
+// Runs all three joins collecting per-thread outputs, and checks them against the reference.
+template <typename Join> void check_join(const Join& join, const std::vector<Row>& probe, const Expected& e) {
+    const auto threads = join.threads();
+    std::vector<std::vector<Pair>> inner(threads);
+    std::vector<std::vector<uint32_t>> semi(threads), anti(threads);
+
+    // emit runs on the workers: collect into the worker's own vector, assert afterwards
+    const auto pairs = join.inner(probe, [&](const Row& b, const Row& p, unsigned t) {
+        inner[t].emplace_back(p.first, b.second, p.second);
+    });
+    const auto semis = join.semi(probe, [&](const Row& p, unsigned t) { semi[t].push_back(p.second); });
+    const auto antis = join.anti(probe, [&](const Row& p, unsigned t) { anti[t].push_back(p.second); });
+
+    std::vector<Pair> all_inner;
+    std::vector<uint32_t> all_semi, all_anti;
+    for (unsigned t = 0; t < threads; t++) {
+        all_inner.insert(all_inner.end(), inner[t].begin(), inner[t].end());
+        all_semi.insert(all_semi.end(), semi[t].begin(), semi[t].end());
+        all_anti.insert(all_anti.end(), anti[t].begin(), anti[t].end());
+    }
+    std::sort(all_inner.begin(), all_inner.end());
+    std::sort(all_semi.begin(), all_semi.end());
+    std::sort(all_anti.begin(), all_anti.end());
+
+    CHECK(pairs == e.inner.size());
+    CHECK(semis == e.semi.size());
+    CHECK(antis == e.anti.size());
+    CHECK(all_inner == e.inner);
+    CHECK(all_semi == e.semi);
+    CHECK(all_anti == e.anti);
+}
+
+emhash_join::JoinOptions options(unsigned threads, unsigned radix_bits) {
+    emhash_join::JoinOptions o;
+    o.threads = threads;
+    o.radix_bits = radix_bits;
+    return o;
+}
+
+} // namespace
+
+TEST_CASE_TEMPLATE("radix join matches a naive join", Join, Join8, Join2) {
+    // ~3 build rows per key, about half the probe keys miss
+    const auto build = random_rows(60000, 20000, 1);
+    const auto probe = random_rows(50000, 40000, 2);
+    const auto expected = naive_join(build, probe);
+
+    for (const unsigned threads : {1u, 4u}) {
+        for (const unsigned bits : {0u, ~0u, 3u, 9u}) {
+            CAPTURE(threads);
+            CAPTURE(bits);
+            Join join(options(threads, bits));
+            join.build(build);
+            CHECK(join.build_size() == build.size());
+            CHECK(join.partitions() == (size_t(1) << join.radix_bits()));
+            if (bits != ~0u)
+                CHECK(join.radix_bits() == bits);
+            check_join(join, probe, expected);
+        }
+    }
+}
+
+TEST_CASE("radix join sizes partitions from partition_bytes") {
+    const auto build = random_rows(200000, 1u << 30, 3);
+    emhash_join::JoinOptions o = options(1, ~0u);
+    o.partition_bytes = 64 << 10;
+    Join8 join(o);
+    join.build(build);
+    // 200000 rows of ~44 bytes each need at least 128 partitions of 64 KiB
+    CHECK(join.radix_bits() >= 7);
+    CHECK(join.memory_usage().entries >= build.size() * sizeof(Row));
+    CHECK(join.memory_usage().metadata >= build.size() * sizeof(uint32_t));
+
+    o.threads = 4;
+    o.partition_bytes = size_t(1) << 40;
+    Join8 wide(o);
+    wide.build(build);
+    CHECK(wide.partitions() >= 16); // at least 4 partitions per thread
+}
+
+TEST_CASE("radix join with heavy duplicates and a skewed key") {
+    std::vector<Row> build = random_rows(5000, 100, 4);
+    for (uint32_t i = 0; i < 20000; i++)
+        build.emplace_back(7, 100000 + i); // one key owns most of the build side
+    const auto probe = random_rows(3000, 200, 5);
+    const auto expected = naive_join(build, probe);
+
+    for (const unsigned threads : {1u, 4u}) {
+        Join8 join(options(threads, 4));
+        join.build(build);
+        check_join(join, probe, expected);
+    }
+}
+
+TEST_CASE("radix join edge cases") {
+    const auto rows = random_rows(1000, 500, 6);
+    const std::vector<Row> none;
+
+    SUBCASE("never built") {
+        Join8 join(options(2, ~0u));
+        CHECK(join.partitions() == 0);
+        check_join(join, rows, naive_join(none, rows));
+    }
+    SUBCASE("empty build side") {
+        Join8 join(options(2, ~0u));
+        join.build(none);
+        check_join(join, rows, naive_join(none, rows));
+    }
+    SUBCASE("empty probe side") {
+        Join8 join(options(2, 5));
+        join.build(rows);
+        check_join(join, none, naive_join(rows, none));
+    }
+    SUBCASE("rebuild replaces the build side") {
+        Join8 join(options(4, ~0u));
+        join.build(rows);
+        const auto other = random_rows(800, 500, 7);
+        join.build(other);
+        CHECK(join.build_size() == other.size());
+        check_join(join, rows, naive_join(other, rows));
+    }
+    SUBCASE("batch sizes") {
+        for (const unsigned batch : {0u, 1u, 7u, 1000u}) {
+            auto o = options(1, 2);
+            o.batch = batch;
+            Join8 join(o);
+            join.build(rows);
+            check_join(join, rows, naive_join(rows, rows));
+        }
+    }
+}
+
+TEST_CASE("radix join on string keys") {
+    using StrJoin = emhash_join::RadixJoin<std::string, uint32_t, uint32_t>;
+    std::vector<StrJoin::build_row> build;
+    std::vector<StrJoin::probe_row> probe;
+    for (uint32_t i = 0; i < 3000; i++)
+        build.emplace_back("key" + std::to_string(i % 1000), i);
+    for (uint32_t i = 0; i < 2000; i++)
+        probe.emplace_back("key" + std::to_string(i), i);
+
+    StrJoin join(options(4, 3));
+    join.build(build);
+    std::vector<size_t> per_thread(join.threads(), 0), mismatched(join.threads(), 0);
+    const auto pairs = join.inner(probe, [&](const StrJoin::build_row& b, const StrJoin::probe_row& p, unsigned t) {
+        mismatched[t] += b.first != p.first;
+        per_thread[t]++;
+    });
+    CHECK(pairs == 3000);
+    size_t sum = 0, bad = 0;
+    for (unsigned t = 0; t < join.threads(); t++) {
+        sum += per_thread[t];
+        bad += mismatched[t];
+    }
+    CHECK(sum == 3000);
+    CHECK(bad == 0);
+    CHECK(join.semi(probe, [](const StrJoin::probe_row&, unsigned) {}) == 1000);
+    CHECK(join.anti(probe, [](const StrJoin::probe_row&, unsigned) {}) == 1000);
+}
@@ -1,7 +1,10 @@
 // unit/test_hashset.cpp
 // HashSet API coverage for all 5 set implementations (emhash2/4/8 + emihset2/3).
 // Covers: insert/find/erase/contains/count, iteration, copy/move, reserve/clear,
-//         insert_unique, merge, erase_if, shrink_to_fit.
+//         insert_unique, merge, erase_if, shrink_to_fit,
+//         emhash8 set algebra (intersect/union/difference, seeded hashers), emhash8 insert_each,
+//         emhash8 nth/sample/sample_k/erase_nth,
+//         emihset2/3 insert_batch/contains_batch.
 #define DOCTEST_CONFIG_IMPLEMENT_WITH_MAIN
 #include "doctest.h"
 #include "common/maps.hpp"
@@ -9,6 +12,11 @@
 
 #include <vector>
 #include <algorithm>
+#include <cmath>
+#include <iterator>
+#include <random>
+#include <set>
+#include <string>
 
 // ============================================================================
 // Universal API: insert / find / erase / contains / count (all 5 sets)
@@ -316,3 +324,234 @@ TEST_CASE_TEMPLATE("set shrink_to_fit", Set, AllIntSets) {
     for (int i = 900; i < 1000; ++i)
         CHECK(s.contains(i));
 }
+
+// ============================================================================
+// emhash8 set algebra
+// ============================================================================
+TEST_CASE("set8 intersect/union/difference match std::set") {
+    set8<int> a, b;
+    std::set<int> sa, sb;
+    for (int i = 0; i < 3000; i++) {
+        a.insert(i * 3);
+        sa.insert(i * 3);
+    }
+    for (int i = 0; i < 500; i++) {
+        b.insert(i * 5);
+        sb.insert(i * 5);
+    }
+
+    std::vector<int> expect;
+    std::set_intersection(sa.begin(), sa.end(), sb.begin(), sb.end(), std::back_inserter(expect));
+    CHECK(a.intersection_size(b) == expect.size());
+    CHECK(b.intersection_size(a) == expect.size());
+
+    set8<int> out;
+    CHECK(a.intersect_into(b, out) == expect.size());
+    CHECK(out.size() == expect.size());
+    for (auto k : expect)
+        CHECK(out.contains(k));
+
+    expect.clear();
+    std::set_union(sa.begin(), sa.end(), sb.begin(), sb.end(), std::back_inserter(expect));
+    set8<int> uni;
+    CHECK(b.union_into(a, uni) == expect.size());
+    CHECK(uni.size() == expect.size());
+    for (auto k : expect)
+        CHECK(uni.contains(k));
+
+    expect.clear();
+    std::set_difference(sb.begin(), sb.end(), sa.begin(), sa.end(), std::back_inserter(expect));
+    set8<int> diff;
+    CHECK(b.difference_into(a, diff) == expect.size());
+    CHECK(diff.size() == expect.size());
+    for (auto k : expect)
+        CHECK(diff.contains(k));
+    CHECK(!diff.contains(0));
+}
+
+TEST_CASE("set8 set algebra appends to a non-empty destination") {
+    set8<int> a{1, 2, 3, 4}, b{3, 4, 5, 6};
+    set8<int> out{4, 100};
+
+    CHECK(a.intersect_into(b, out) == 1); // 3 added, 4 already there
+    CHECK(out.size() == 3);
+    CHECK(a.union_into(b, out) == 4);     // 1, 2, 5, 6
+    CHECK(out.size() == 7);
+    CHECK(b.difference_into(a, out) == 0);
+    CHECK(out.size() == 7);
+
+    set8<int> empty;
+    CHECK(a.intersection_size(empty) == 0);
+    CHECK(empty.intersection_size(a) == 0);
+    set8<int> copy;
+    CHECK(empty.union_into(a, copy) == 4);
+    CHECK(copy == a);
+}
+
+TEST_CASE("set8 set algebra with string keys") {
+    set8<std::string> a, b;
+    for (int i = 0; i < 200; i++) {
+        a.insert("key_" + std::to_string(i));
+        b.insert("key_" + std::to_string(i + 150));
+    }
+    CHECK(a.intersection_size(b) == 50);
+    set8<std::string> diff;
+    CHECK(a.difference_into(b, diff) == 150);
+    CHECK(diff.contains("key_0"));
+    CHECK(!diff.contains("key_150"));
+}
+
+// Every default-constructed instance picks its own seed, so two sets hash a key differently.
+struct SeededHash {
+    static uint64_t next_seed() {
+        static uint64_t counter = 0;
+        return ++counter * 0x9E3779B97F4A7C15ull;
+    }
+    uint64_t seed = next_seed();
+    size_t operator()(uint64_t key) const { return static_cast<size_t>((key ^ seed) * 0xff51afd7ed558ccdull); }
+};
+
+TEST_CASE("set8 set algebra with a per-instance seeded hasher") {
+    emhash8::HashSet<uint64_t, SeededHash> a, b;
+    for (uint64_t i = 0; i < 1000; i++) {
+        a.insert(i);
+        b.insert(i + 500);
+    }
+
+    emhash8::HashSet<uint64_t, SeededHash> inter, uni, diff;
+    CHECK(a.intersect_into(b, inter) == 500);
+    CHECK(a.union_into(b, uni) == 1500);
+    CHECK(a.difference_into(b, diff) == 500);
+    size_t missing = 0;
+    for (uint64_t i = 0; i < 1500; i++) {
+        missing += (i >= 500 && i < 1000) != inter.contains(i);
+        missing += !uni.contains(i);
+        missing += (i < 500) != diff.contains(i);
+    }
+    CHECK(missing == 0);
+}
+
+TEST_CASE("set8 insert_each reports dense slots across rehashes") {
+    std::vector<int> keys;
+    for (int i = 0; i < 5000; i++)
+        keys.push_back(i % 3000);
+    set8<int> set;
+    size_t next = 0, inserted = 0;
+    set.insert_each(keys.begin(), keys.end(), [&](uint32_t slot, bool added) {
+        REQUIRE(slot < set.size());
+        REQUIRE((&*set.begin())[slot] == keys[next++]);
+        CHECK(added == (next <= 3000));
+        inserted += added;
+    });
+    CHECK(inserted == 3000);
+    CHECK(set.size() == 3000);
+    for (int i = 0; i < 3000; i++)
+        REQUIRE((&*set.begin())[i] == i);
+}
+
+TEST_CASE("set8 nth and erase_nth keep keys densely packed") {
+    set8<int> set;
+    for (int i = 0; i < 1000; i++)
+        set.insert(i);
+    for (uint32_t i = 0; i < set.size(); i++)
+        REQUIRE(set.nth(i) == int(i));
+
+    // reservoir style: drop every even key by walking slots upward
+    for (uint32_t i = 0; i < set.size();) {
+        if (set.nth(i) % 2 == 0)
+            set.erase_nth(i);
+        else
+            i++;
+    }
+    CHECK(set.size() == 500);
+    for (int i = 0; i < 1000; i++)
+        REQUIRE(set.contains(i) == (i % 2 == 1));
+
+    auto it = set.erase_nth(set.size() - 1);
+    CHECK(it == set.end());
+    CHECK(set.size() == 499);
+}
+
+TEST_CASE("set8 sample and sample_k draw uniformly without replacement") {
+    set8<int> set;
+    for (int i = 0; i < 100; i++)
+        set.insert(i);
+    std::mt19937_64 rng(36);
+
+    std::vector<int> hits(100);
+    for (int i = 0; i < 100000; i++)
+        hits[set.sample(rng)]++;
+    for (int h : hits)
+        REQUIRE((h > 800 && h < 1200));
+
+    // both the Floyd (small k) and the selection (large k) paths
+    for (uint32_t k : {0u, 1u, 5u, 12u, 13u, 60u, 99u, 100u, 150u}) {
+        std::vector<int> first(100);
+        for (int round = 0; round < 2000; round++) {
+            auto keys = set.sample_k(k, rng);
+            REQUIRE(keys.size() == std::min<size_t>(k, 100));
+            std::sort(keys.begin(), keys.end());
+            REQUIRE(std::adjacent_find(keys.begin(), keys.end()) == keys.end());
+            for (int key : keys)
+                first[key]++;
+        }
+        // each key is picked with probability k / 100
+        const double expect = 2000.0 * std::min<size_t>(k, 100) / 100;
+        for (int f : first)
+            REQUIRE(std::abs(f - expect) <= 0.25 * expect + 30);
+    }
+
+    set8<std::string> strs;
+    strs.insert("only");
+    CHECK(strs.sample(rng) == "only");
+    CHECK(strs.sample_k(3, rng) == std::vector<std::string>{"only"});
+}
+
+TEST_CASE_TEMPLATE("emihset insert_batch/contains_batch match single-key calls", Set, iset2<uint64_t>, iset3<uint64_t>,
+                   iset2<std::string>, iset3<std::string>) {
+    using Key = typename Set::key_type;
+    std::mt19937_64 rng(17);
+    const auto make_key = [&rng](uint64_t range) {
+        const uint64_t v = rng() % range;
+        if constexpr (std::is_same<Key, std::string>::value)
+            return std::to_string(v);
+        else
+            return v;
+    };
+
+    Set batch, single;
+    std::vector<Key> keys;
+    std::vector<uint8_t> mask;
+    for (int round = 0; round < 50; round++) {
+        keys.clear();
+        for (int i = 0; i < 1000; i++)
+            keys.push_back(make_key(30000)); // duplicates inside and across batches
+        mask.assign(keys.size(), 2);
+
+        size_t expect = 0;
+        std::vector<uint8_t> expect_mask;
+        for (const auto& key : keys) {
+            expect_mask.push_back(single.insert(key).second);
+            expect += expect_mask.back();
+        }
+        REQUIRE(batch.insert_batch(keys.data(), keys.size(), mask.data()) == expect);
+        REQUIRE(mask == expect_mask);
+        REQUIRE(batch.size() == single.size());
+    }
+    CHECK(batch.insert_batch(keys.data(), keys.size()) == 0);
+
+    keys.clear();
+    for (int i = 0; i < 5000; i++)
+        keys.push_back(make_key(60000));
+    mask.assign(keys.size(), 2);
+    size_t hits = 0;
+    for (const auto& key : keys)
+        hits += single.contains(key);
+    CHECK(batch.contains_batch(keys.data(), keys.size(), mask.data()) == hits);
+    for (size_t i = 0; i < keys.size(); i++)
+        REQUIRE(mask[i] == single.contains(keys[i]));
+
+    Set empty;
+    CHECK(empty.contains_batch(keys.data(), keys.size(), mask.data()) == 0);
+    CHECK(std::count(mask.begin(), mask.end(), 0) == static_cast<long>(keys.size()));
+}
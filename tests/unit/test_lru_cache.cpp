@@ -0,0 +1,327 @@
+// unit/test_lru_cache.cpp
+// LRU cache coverage for emlru_size::lru_cache and emlru_time::lru_cache.
+// Covers: weight-bounded (byte budget) eviction, EMHASH_LRU_STATS counters,
+//         soft/hard TTL with find_or_stale()/touch(), snapshot()/restore().
+#define DOCTEST_CONFIG_IMPLEMENT_WITH_MAIN
+#include "doctest.h"
+
+#define EMHASH_LRU_STATS 1
+#include "emhash/lru_size.hpp"
+#include "emhash/lru_time.hpp"
+
+#include <chrono>
+#include <cstdio>
+#include <filesystem>
+#include <string>
+#include <thread>
+#include <type_traits>
+
+struct StringBytes {
+    uint32_t operator()(const int&, const std::string& value) const {
+        return static_cast<uint32_t>(sizeof(int) + value.size());
+    }
+};
+
+using WeightedLru = emlru_size::lru_cache<int, std::string, std::hash<int>, std::equal_to<int>, StringBytes>;
+
+// ============================================================================
+// emlru_size: weight budget
+// ============================================================================
+TEST_CASE("lru_size entry has no weight slot without a weigher") {
+    CHECK(sizeof(emlru_size::entry<uint64_t, uint64_t>) == 24);
+    CHECK(sizeof(emlru_size::entry<uint64_t, uint64_t, true>) > 24);
+}
+
+TEST_CASE("lru_size tracks total weight on insert/erase/clear") {
+    WeightedLru cache(8, 1 << 20, 1 << 20);
+    cache.insert(1, std::string(100, 'a'));
+    cache.insert(2, std::string(200, 'b'));
+    CHECK(cache.total_weight() == 300 + 2 * sizeof(int));
+
+    cache.erase(1);
+    CHECK(cache.total_weight() == 200 + sizeof(int));
+
+    cache[3] = std::string(50, 'c');
+    CHECK(cache.total_weight() == 200 + 2 * sizeof(int));
+    CHECK(cache.reweigh(3));
+    CHECK(cache.total_weight() == 250 + 2 * sizeof(int));
+    CHECK(!cache.reweigh(99));
+
+    cache.clear();
+    CHECK(cache.total_weight() == 0);
+}
+
+TEST_CASE("lru_size weight budget is never exceeded") {
+    const uint64_t budget = 64 * 1024;
+    WeightedLru cache(8, 1 << 20, budget);
+
+    for (int i = 0; i < 20000; i++) {
+        cache.insert(i, std::string(16 + (i * 7919) % 2048, 'x'));
+        REQUIRE(cache.total_weight() <= budget);
+        REQUIRE(cache.contains(i));
+    }
+
+    uint64_t sum = 0;
+    for (const auto& kv : cache)
+        sum += sizeof(int) + kv.second.size();
+    CHECK(sum == cache.total_weight());
+    CHECK(cache.size() < 20000);
+}
+
+TEST_CASE("lru_size weight eviction prefers recently used entries") {
+    WeightedLru cache(8, 1 << 20, 100 * (sizeof(int) + 10));
+    for (int i = 0; i < 100; i++)
+        cache.insert(i, std::string(10, 'v'));
+    CHECK(cache.size() == 100);
+
+    for (int round = 0; round < 200; round++)
+        CHECK(cache.contains(0));
+
+    cache.insert(1000, std::string(10, 'v'));
+    CHECK(cache.size() < 100);
+    CHECK(cache.contains(0));
+    CHECK(cache.contains(1000));
+    CHECK(!cache.contains(1));
+}
+
+TEST_CASE("lru_size re-inserting a cached key evicts nothing") {
+    const uint64_t budget = 100 * (sizeof(int) + 10);
+    WeightedLru cache(8, 1 << 20, budget);
+    for (int i = 0; i < 100; i++)
+        cache.insert(i, std::string(10, 'v'));
+    REQUIRE(cache.total_weight() == budget);
+
+    // the old value stays, so the larger replacement must not make room for itself
+    CHECK(!cache.insert(50, std::string(500, 'w')).second);
+    CHECK(!cache.emplace(51, std::string(500, 'w')).second);
+    cache[52];
+    CHECK(cache.size() == 100);
+    CHECK(cache.total_weight() == budget);
+    CHECK(cache.try_get(50)->size() == 10);
+
+    cache.insert_unique(emlru_size::entry<int, std::string, true>(std::make_pair(1000, std::string(100, 'n'))));
+    CHECK(cache.total_weight() <= budget);
+    CHECK(cache.contains(1000));
+}
+
+TEST_CASE("lru_size shrinking max_weight evicts immediately") {
+    WeightedLru cache(8, 1 << 20, 1 << 20);
+    for (int i = 0; i < 1000; i++)
+        cache.insert(i, std::string(64, 'z'));
+
+    cache.max_weight(8 * 1024);
+    CHECK(cache.total_weight() <= 8 * 1024);
+
+    WeightedLru copy(cache);
+    CHECK(copy.total_weight() == cache.total_weight());
+    CHECK(copy.max_weight() == cache.max_weight());
+}
+
+// ============================================================================
+// EMHASH_LRU_STATS counters
+// ============================================================================
+TEST_CASE("lru_size counts hits, misses, inserts and capacity evictions") {
+    emlru_size::lru_cache<int, int> cache(8, 16);
+    for (int i = 0; i < 100; i++)
+        cache.insert(i, i);
+
+    auto stats = cache.stats();
+    CHECK(stats.inserts == 100);
+    CHECK(stats.evict_capacity == 100 - cache.size());
+    CHECK(stats.pauses > 0);
+
+    uint64_t pauses = 0;
+    for (auto n : stats.pause_us)
+        pauses += n;
+    CHECK(pauses == stats.pauses);
+
+    cache.contains(99);
+    cache.contains(-1);
+    cache.try_get(-2);
+    stats = cache.stats();
+    CHECK(stats.hits == 1);
+    CHECK(stats.misses == 2);
+    CHECK(stats.hit_ratio() == doctest::Approx(1.0 / 3));
+    CHECK(stats.evict_timeout == 0);
+
+    cache.reset_stats();
+    CHECK(cache.stats().inserts == 0);
+    CHECK(cache.stats().hit_ratio() == 0.0);
+}
+
+TEST_CASE("lru_size weight evictions count as capacity") {
+    WeightedLru cache(8, 1 << 20, 4096);
+    for (int i = 0; i < 200; i++)
+        cache.insert(i, std::string(60, 'w'));
+    const auto stats = cache.stats();
+    CHECK(stats.inserts == 200);
+    CHECK(stats.evict_capacity == 200 - cache.size());
+}
+
+TEST_CASE("lru_size and lru_time share one counter type") {
+    CHECK(std::is_same<emlru_size::lru_stats, emlru_time::lru_stats>::value);
+    emlru_time::lru_stats stats = emlru_size::lru_cache<int, int>(8, 16).stats();
+    CHECK(stats.pauses == 0);
+}
+
+TEST_CASE("lru_time counts timeout evictions") {
+    emlru_time::lru_cache<int, int> cache(64, 1024, 3600 * 1000);
+    for (int i = 0; i < 10; i++)
+        cache.insert(i, i);
+    for (int i = 10; i < 20; i++)
+        cache.insert(i, i, -1000); // already expired
+
+    CHECK(cache.contains(0));
+    CHECK(!cache.contains(15));
+    cache.clear_timeout();
+    CHECK(cache.size() == 10);
+
+    const auto stats = cache.stats();
+    CHECK(stats.inserts == 20);
+    CHECK(stats.hits == 1);
+    CHECK(stats.misses == 1);
+    CHECK(stats.evict_timeout == 10);
+    CHECK(stats.pauses >= 1);
+    for (int i = 0; i < 10; i++)
+        CHECK(cache.contains(i));
+}
+
+// ============================================================================
+// emlru_time: soft/hard TTL, find_or_stale, touch
+// ============================================================================
+using SoftLru = emlru_time::lru_cache<int, int, std::hash<int>, std::equal_to<int>, true>;
+using emlru_time::freshness;
+
+TEST_CASE("lru_time entry has no soft deadline slot by default") {
+    CHECK(sizeof(emlru_time::entry<uint64_t, uint64_t>) == 24);
+    CHECK(sizeof(emlru_time::entry<uint64_t, uint64_t, true>) > 24);
+}
+
+TEST_CASE("lru_time find_or_stale hands out one refresh per stale window") {
+    SoftLru cache(64, 1024, 3600 * 1000);
+    cache.insert(1, 10);
+    cache.insert(2, 20, -1, 3600 * 1000); // soft deadline already passed
+
+    auto r1 = cache.find_or_stale(1);
+    REQUIRE(r1.first != nullptr);
+    CHECK(*r1.first == 10);
+    CHECK(r1.second == freshness::fresh);
+
+    auto r2 = cache.find_or_stale(2);
+    REQUIRE(r2.first != nullptr);
+    CHECK(*r2.first == 20);
+    CHECK(r2.second == freshness::refresh);
+    CHECK(cache.find_or_stale(2).second == freshness::stale);
+    CHECK(cache.contains(2)); // stale values are still served
+
+    // refresh: write in place and restart the TTL pair
+    *r2.first = 21;
+    CHECK(cache.touch(2, 1000, 3600 * 1000));
+    auto r3 = cache.find_or_stale(2);
+    CHECK(*r3.first == 21);
+    CHECK(r3.second == freshness::fresh);
+
+    CHECK(cache.find_or_stale(3).first == nullptr);
+    CHECK(cache.find_or_stale(3).second == freshness::missing);
+    CHECK(!cache.touch(3, 1000));
+}
+
+TEST_CASE("lru_time find_or_stale returns expired entries until reclaimed") {
+    SoftLru cache(64, 1024, 3600 * 1000);
+    cache.insert(7, 70, -10);
+
+    CHECK(!cache.contains(7));
+    auto r = cache.find_or_stale(7);
+    REQUIRE(r.first != nullptr);
+    CHECK(*r.first == 70);
+    CHECK(r.second == freshness::expired);
+    CHECK(!cache.touch(7, 1000));
+
+    cache.clear_timeout();
+    CHECK(cache.find_or_stale(7).second == freshness::missing);
+}
+
+TEST_CASE("lru_time touch keeps entries alive across rehash") {
+    emlru_time::lru_cache<int, int> cache(4, 1 << 16, 3600 * 1000);
+    for (int i = 0; i < 100; i++)
+        cache.insert(i, i, -1);
+    for (int i = 0; i < 100; i += 2)
+        CHECK(!cache.touch(i, 3600 * 1000)); // already expired
+
+    for (int i = 100; i < 200; i++)
+        cache.insert(i, i, 60 * 1000);
+    for (int i = 100; i < 200; i += 2)
+        CHECK(cache.touch(i, 3600 * 1000));
+    CHECK(cache.find_or_stale(100).second == freshness::fresh);
+
+    cache.reserve(4096);
+    for (int i = 100; i < 200; i += 2)
+        CHECK(cache.contains(i));
+}
+
+// ============================================================================
+// snapshot / restore
+// ============================================================================
+TEST_CASE("lru_size snapshot and restore round trip") {
+    const char* path = "test_lru_size_snapshot.bin";
+    emlru_size::lru_cache<uint64_t, uint64_t> cache(8, 1 << 12);
+    for (uint64_t i = 0; i < 5000; i++)
+        cache.insert(i, i * 3);
+    for (int round = 0; round < 10000; round++)
+        cache.contains(7);
+    REQUIRE(cache.snapshot(path));
+
+    emlru_size::lru_cache<uint64_t, uint64_t> warm(8, 1 << 12);
+    warm.insert(999999, 1);
+    REQUIRE(warm.restore(path));
+    CHECK(warm.size() == cache.size());
+    CHECK(!warm.contains(999999));
+    for (const auto& kv : cache)
+        CHECK(warm.get_or_return_default(kv.first) == kv.second);
+
+    // restored orderids keep their relative order: a smaller cache evicts while
+    // restoring and keeps the hottest key
+    emlru_size::lru_cache<uint64_t, uint64_t> small(8, 1 << 10);
+    REQUIRE(small.restore(path));
+    CHECK(small.size() < cache.size());
+    CHECK(small.stats().evict_capacity > 0);
+    CHECK(small.contains(7));
+
+    emlru_size::lru_cache<uint64_t, uint32_t> other;
+    CHECK(!other.restore(path));
+    CHECK(!other.restore("no_such_dir/snapshot.bin"));
+
+    std::filesystem::resize_file(path, sizeof(emlru_size::snapshot_header) + 20 * 100 + 7);
+    emlru_size::lru_cache<uint64_t, uint64_t> partial(8, 1 << 12);
+    CHECK(!partial.restore(path));
+    CHECK(partial.size() == 100);
+    std::remove(path);
+}
+
+TEST_CASE("lru_time snapshot and restore drops expired entries") {
+    const char* path = "test_lru_time_snapshot.bin";
+    SoftLru cache(64, 1024, 3600 * 1000);
+    for (int i = 0; i < 100; i++)
+        cache.insert(i, i + 1, 1000 * 1000, 3600 * 1000);
+    for (int i = 100; i < 200; i++)
+        cache.insert(i, i + 1, 50);
+    cache.insert(200, 201, -1); // expired, not saved
+    REQUIRE(cache.snapshot(path));
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(120));
+    SoftLru warm(64, 1024, 3600 * 1000);
+    REQUIRE(warm.restore(path));
+    CHECK(warm.size() == 100);
+    for (int i = 0; i < 100; i++) {
+        auto found = warm.find_or_stale(i);
+        REQUIRE(found.first != nullptr);
+        CHECK(*found.first == i + 1);
+        CHECK(found.second == freshness::fresh);
+    }
+    CHECK(!warm.contains(150));
+    CHECK(!warm.contains(200));
+
+    emlru_time::lru_cache<int, int> plain;
+    CHECK(!plain.restore(path)); // record layout differs without SoftTTL
+    std::remove(path);
+}
@@ -0,0 +1,122 @@
+// unit/test_lru_shm.cpp
+// Shared-memory LRU cache (emlru_shm::lru_cache), Linux only.
+// Covers: insert/lookup/erase, remove_half eviction per shard, attaching a second
+//         mapping of the same shm object, sharing a memfd with a forked child.
+#define DOCTEST_CONFIG_IMPLEMENT_WITH_MAIN
+#include "doctest.h"
+
+#if defined(__linux__)
+#include "emhash/lru_shm.hpp"
+
+#include <string>
+#include <sys/wait.h>
+#include <unistd.h>
+
+using ShmLru = emlru_shm::lru_cache<uint64_t, uint64_t>;
+
+namespace {
+std::string shm_name(const char* tag) { return "/emlru_test_" + std::to_string(getpid()) + "_" + tag; }
+} // namespace
+
+TEST_CASE("lru_shm insert, lookup and erase") {
+    const auto name = shm_name("crud");
+    ShmLru cache(name.c_str(), 4096, 4);
+    CHECK(cache.shard_count() == 4);
+    CHECK(cache.capacity() == 4096);
+    CHECK(cache.empty());
+
+    for (uint64_t i = 0; i < 1000; i++)
+        CHECK(cache.insert(i, i * 2));
+    CHECK(cache.size() == 1000);
+    CHECK(!cache.insert(5, 0)); // insert keeps the old value
+    CHECK(cache.get_or_return_default(5) == 10);
+    CHECK(!cache.insert_or_assign(5, 55));
+    CHECK(cache.get_or_return_default(5) == 55);
+
+    uint64_t value = 0;
+    for (uint64_t i = 0; i < 1000; i += 3) {
+        REQUIRE(cache.try_get(i, value));
+        CHECK(value == (i == 5 ? 55 : i * 2));
+    }
+    CHECK(!cache.try_get(1000, value));
+    CHECK(cache.update(7, [](uint64_t& v) { v += 1; }));
+    CHECK(cache.get_or_return_default(7) == 15);
+
+    for (uint64_t i = 0; i < 1000; i += 2)
+        CHECK(cache.erase(i) == 1);
+    CHECK(cache.erase(0) == 0);
+    CHECK(cache.size() == 500);
+    for (uint64_t i = 1; i < 1000; i += 2)
+        CHECK(cache.contains(i));
+    CHECK(!cache.contains(2));
+
+    cache.clear();
+    CHECK(cache.size() == 0);
+    CHECK(ShmLru::unlink(name.c_str()));
+}
+
+TEST_CASE("lru_shm evicts the least recently used half of a full shard") {
+    const auto name = shm_name("evict");
+    ShmLru cache(name.c_str(), 1024, 1);
+    for (uint64_t i = 0; i < 1024; i++)
+        cache.insert(i, i);
+    for (uint64_t i = 0; i < 16; i++)
+        CHECK(cache.contains(i)); // make the oldest keys hot
+
+    for (uint64_t i = 1024; i < 100000; i++) {
+        cache.insert(i, i);
+        REQUIRE(cache.size() <= 1024);
+        REQUIRE(cache.contains(i));
+    }
+
+    const auto stats = cache.stats();
+    CHECK(stats.inserts == 100000);
+    CHECK(stats.evict_capacity == 100000 - cache.size());
+    CHECK(stats.owner_dead == 0);
+    CHECK(!cache.contains(1023));
+    CHECK(ShmLru::unlink(name.c_str()));
+}
+
+TEST_CASE("lru_shm second mapping sees the same entries") {
+    const auto name = shm_name("attach");
+    ShmLru writer(name.c_str(), 1 << 14, 8);
+    ShmLru reader(name.c_str(), 16, 2); // geometry comes from the creator
+    CHECK(reader.shard_count() == 8);
+    CHECK(reader.capacity() == writer.capacity());
+
+    for (uint64_t i = 0; i < 5000; i++)
+        writer.insert(i, i + 1);
+    CHECK(reader.size() == 5000);
+    for (uint64_t i = 0; i < 5000; i++)
+        CHECK(reader.get_or_return_default(i) == i + 1);
+
+    CHECK_THROWS(emlru_shm::lru_cache<uint64_t, uint32_t>(name.c_str(), 16));
+    CHECK(ShmLru::unlink(name.c_str()));
+}
+
+TEST_CASE("lru_shm memfd is shared with a forked child") {
+    const auto fd = memfd_create("emlru_test", 0);
+    REQUIRE(fd >= 0);
+    ShmLru cache(fd, 1 << 14, 4);
+    cache.insert(1, 100);
+
+    const auto pid = fork();
+    REQUIRE(pid >= 0);
+    if (pid == 0) {
+        uint64_t value = 0;
+        const auto ok = cache.try_get(1, value) && value == 100;
+        for (uint64_t i = 2; i < 2000; i++)
+            cache.insert(i, i * 7);
+        _exit(ok ? 0 : 1);
+    }
+
+    int status = 0;
+    REQUIRE(waitpid(pid, &status, 0) == pid);
+    CHECK(WIFEXITED(status));
+    CHECK(WEXITSTATUS(status) == 0);
+    CHECK(cache.size() == 1999);
+    for (uint64_t i = 2; i < 2000; i++)
+        CHECK(cache.get_or_return_default(i) == i * 7);
+    CHECK(cache.stats().hits >= 1);
+}
+#endif
@@ -0,0 +1,183 @@
+// unit/test_memory_usage.cpp
+// memory_usage() footprint breakdown of the maps, sets and LRU caches.
+// Allocator-aware containers (emhash5-8 maps, emhash2/3/4/8 sets) are checked byte-exact
+// against a live-bytes allocator; the malloc-based emilib and LRU containers against
+// their bucket count. The compact set, counter map and Bloom filter return the same
+// breakdown.
+#define DOCTEST_CONFIG_IMPLEMENT_WITH_MAIN
+#include "doctest.h"
+#include "common/maps.hpp"
+
+#include "emhash/bloom_filter.hpp"
+#include "emhash/counter_map.hpp"
+#include "emhash/hash_set3.hpp"
+#include "emhash/hash_set_compact.hpp"
+#include "emhash/lru_size.hpp"
+#include "emhash/lru_time.hpp"
+
+#include <cstdint>
+#include <string>
+#include <utility>
+
+static std::size_t g_live_bytes = 0;
+
+template <typename T> struct LiveAllocator {
+    using value_type = T;
+
+    LiveAllocator() = default;
+    template <typename U> LiveAllocator(const LiveAllocator<U>&) noexcept {}
+
+    T* allocate(std::size_t n) {
+        g_live_bytes += n * sizeof(T);
+        return static_cast<T*>(::operator new(n * sizeof(T)));
+    }
+
+    void deallocate(T* p, std::size_t n) {
+        g_live_bytes -= n * sizeof(T);
+        ::operator delete(p);
+    }
+
+    template <typename U> bool operator==(const LiveAllocator<U>&) const noexcept { return true; }
+    template <typename U> bool operator!=(const LiveAllocator<U>&) const noexcept { return false; }
+};
+
+template <typename K, typename V>
+using LiveMapAlloc = LiveAllocator<std::pair<K, V>>;
+
+#define LiveMaps                                                                                                       \
+    emhash5::HashMap<uint64_t, uint64_t, std::hash<uint64_t>, std::equal_to<uint64_t>,                               \
+                     LiveMapAlloc<uint64_t, uint64_t>>,                                                                \
+        emhash6::HashMap<uint64_t, uint32_t, std::hash<uint64_t>, std::equal_to<uint64_t>,                           \
+                         LiveMapAlloc<uint64_t, uint32_t>>,                                                            \
+        emhash7::HashMap<uint32_t, std::string, std::hash<uint32_t>, std::equal_to<uint32_t>,                        \
+                         LiveMapAlloc<uint32_t, std::string>>,                                                         \
+        emhash8::HashMap<uint64_t, uint64_t, std::hash<uint64_t>, std::equal_to<uint64_t>,                           \
+                         LiveMapAlloc<uint64_t, uint64_t>>
+
+#define LiveSets                                                                                                       \
+    emhash2::HashSet<uint64_t, std::hash<uint64_t>, std::equal_to<uint64_t>, LiveAllocator<uint64_t>>,                \
+        emhash3::HashSet<uint64_t, std::hash<uint64_t>, std::equal_to<uint64_t>, LiveAllocator<uint64_t>>,            \
+        emhash4::HashSet<uint32_t, std::hash<uint32_t>, std::equal_to<uint32_t>, LiveAllocator<uint32_t>>,            \
+        emhash8::HashSet<uint64_t, std::hash<uint64_t>, std::equal_to<uint64_t>, LiveAllocator<uint64_t>>
+
+template <typename C> static std::size_t value_bytes() { return sizeof(typename C::value_type); }
+
+TEST_CASE_TEMPLATE("memory_usage: total matches allocated bytes (maps)", Map, LiveMaps) {
+    g_live_bytes = 0;
+    {
+        Map map;
+        CHECK(map.memory_usage().total() == g_live_bytes);
+        for (int i = 0; i < 5000; i++) {
+            map[static_cast<typename Map::key_type>(i)];
+            if (i % 997 == 0) {
+                const auto usage = map.memory_usage();
+                CHECK(usage.total() == g_live_bytes);
+                CHECK(usage.entries == map.size() * value_bytes<Map>());
+            }
+        }
+        for (int i = 0; i < 2500; i++)
+            map.erase(static_cast<typename Map::key_type>(i));
+        const auto usage = map.memory_usage();
+        CHECK(usage.total() == g_live_bytes);
+        CHECK(usage.entries == map.size() * value_bytes<Map>());
+        CHECK(usage.slack > 0);
+
+        Map other(std::move(map));
+        CHECK(other.memory_usage().total() + map.memory_usage().total() == g_live_bytes);
+        CHECK(other.memory_usage().entries == 2500 * value_bytes<Map>());
+    }
+    CHECK(g_live_bytes == 0);
+}
+
+TEST_CASE_TEMPLATE("memory_usage: total matches allocated bytes (sets)", Set, LiveSets) {
+    g_live_bytes = 0;
+    {
+        Set set;
+        CHECK(set.memory_usage().total() == g_live_bytes);
+        for (int i = 0; i < 5000; i++)
+            set.insert(static_cast<typename Set::value_type>(i * 7));
+        auto usage = set.memory_usage();
+        CHECK(usage.total() == g_live_bytes);
+        CHECK(usage.entries == set.size() * value_bytes<Set>());
+
+        set.clear();
+        usage = set.memory_usage();
+        CHECK(usage.entries == 0);
+        CHECK(usage.total() == g_live_bytes);
+    }
+    CHECK(g_live_bytes == 0);
+}
+
+TEST_CASE("memory_usage: emhash8 splits values and index") {
+    emhash8::HashMap<uint64_t, uint64_t> map;
+    map.reserve(1000);
+    for (uint64_t i = 0; i < 100; i++)
+        map[i] = i;
+    const auto usage = map.memory_usage();
+    CHECK(usage.entries == 100 * sizeof(std::pair<uint64_t, uint64_t>));
+    CHECK(usage.index >= map.bucket_count() * sizeof(uint32_t));
+    CHECK(usage.slack > 0);
+    CHECK(usage.metadata == 0);
+}
+
+TEST_CASE_TEMPLATE("memory_usage: emilib maps cover their buckets", Map, imap1<int, int>, imap2<int, int>,
+                   imap3<int, int>, imap4<int, int>) {
+    Map map;
+    for (int i = 0; i < 3000; i++)
+        map[i] = i;
+    const auto usage = map.memory_usage();
+    CHECK(usage.entries == map.size() * sizeof(std::pair<const int, int>));
+    CHECK(usage.entries + usage.slack >= map.bucket_count() * sizeof(std::pair<const int, int>) - 8);
+    CHECK(usage.metadata >= map.bucket_count());
+    CHECK(usage.total() <= map.bucket_count() * (sizeof(std::pair<const int, int>) + 4) + 256);
+}
+
+TEST_CASE_TEMPLATE("memory_usage: emilib sets cover their buckets", Set, iset2<uint64_t>, iset3<uint64_t>) {
+    Set set;
+    for (uint64_t i = 0; i < 3000; i++)
+        set.insert(i);
+    const auto usage = set.memory_usage();
+    CHECK(usage.entries == set.size() * sizeof(uint64_t));
+    CHECK(usage.entries + usage.slack == set.bucket_count() * sizeof(uint64_t));
+    CHECK(usage.metadata == set.bucket_count());
+    CHECK(usage.padding > 0);
+}
+
+TEST_CASE("memory_usage: LRU caches") {
+    emlru_size::lru_cache<uint64_t, uint64_t> by_size(8, 4096);
+    emlru_time::lru_cache<uint64_t, uint64_t> by_time(8, 4096);
+    for (uint64_t i = 0; i < 1000; i++) {
+        by_size.insert(i, i);
+        by_time.insert(i, i);
+    }
+    for (const auto& usage : {by_size.memory_usage(), by_time.memory_usage()}) {
+        CHECK(usage.entries == 1000 * sizeof(std::pair<uint64_t, uint64_t>));
+        CHECK(usage.metadata > 0);
+        CHECK(usage.slack > 0);
+        CHECK(usage.padding > 0);
+    }
+}
+
+TEST_CASE("memory_usage: compact set, counter map and Bloom filter") {
+    emhash_compact::IntSet<uint32_t> compact;
+    emhash_counter::CountMap<uint64_t> counts;
+    for (uint32_t i = 0; i < 1000; i++) {
+        compact.insert(i * 7919);
+        counts.increment(i, i < 10 ? 1000 : 1); // 10 wide counts
+    }
+
+    const emhash::MemoryUsage packed = compact.memory_usage();
+    CHECK(packed.entries >= compact.size() * (compact.bits_per_slot() - 5) / 8);
+    CHECK(packed.metadata > 0);
+    CHECK(packed.total() >= compact.bucket_count() * compact.bits_per_slot() / 8);
+
+    const emhash::MemoryUsage counted = counts.memory_usage();
+    CHECK(counted.entries == counts.keys().memory_usage().entries + 1000 + 10 * sizeof(uint64_t));
+    CHECK(counted.slack >= 54 * sizeof(uint64_t)); // rest of the one wide block
+
+    emfilter::block_bloom bloom(1000, 10);
+    const emhash::MemoryUsage bits = bloom.memory_usage();
+    CHECK(bits.entries == 0);
+    CHECK(bits.total() == bits.metadata);
+    CHECK(bits.total() * 8 == bloom.bit_count());
+}
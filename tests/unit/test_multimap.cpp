@@ -0,0 +1,147 @@
+// unit/test_multimap.cpp
+// emhash7::HashMultiMap (duplicate keys as adjacent entries of one bucket chain).
+// Covers: random insert/erase/erase-one against std::unordered_multimap, equal_range and
+//         count over a key's run, runs surviving rehash and guest kick-outs, string keys,
+//         iteration, copy/move/clear.
+#define DOCTEST_CONFIG_IMPLEMENT_WITH_MAIN
+#include "doctest.h"
+#include "emhash/hash_multimap7.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <random>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+using emhash7::HashMultiMap;
+
+namespace {
+
+// Few distinct main buckets: long chains with several runs and many guests.
+struct CoarseHash {
+    size_t operator()(uint64_t key) const { return static_cast<size_t>(key / 3); }
+};
+
+template <typename Map, typename Ref, typename Key> void check_key(const Map& map, const Ref& ref, const Key& key) {
+    std::vector<uint64_t> got, want;
+    const auto range = map.equal_range(key);
+    for (auto it = range.first; it != range.second; ++it) {
+        REQUIRE(it->first == key);
+        got.push_back(it->second);
+    }
+    const auto ref_range = ref.equal_range(key);
+    for (auto it = ref_range.first; it != ref_range.second; ++it)
+        want.push_back(it->second);
+    std::sort(got.begin(), got.end());
+    std::sort(want.begin(), want.end());
+    REQUIRE(got == want);
+    REQUIRE(map.count(key) == want.size());
+    REQUIRE(map.contains(key) == !want.empty());
+}
+
+template <typename Map, typename Ref> void check_all(const Map& map, const Ref& ref) {
+    REQUIRE(map.size() == ref.size());
+    size_t visited = 0;
+    for (const auto& kv : map) {
+        REQUIRE(ref.count(kv.first) > 0);
+        visited++;
+    }
+    REQUIRE(visited == ref.size());
+}
+
+} // namespace
+
+TEST_CASE_TEMPLATE("multimap matches std::unordered_multimap", Map, HashMultiMap<uint64_t, uint64_t>,
+                   HashMultiMap<uint64_t, uint64_t, CoarseHash>) {
+    Map map;
+    std::unordered_multimap<uint64_t, uint64_t> ref;
+    std::mt19937_64 rng(11);
+
+    for (int i = 0; i < 200000; i++) {
+        // a few keys with hundreds of values, many with one or two
+        const uint64_t key = rng() % 4 == 0 ? rng() % 20 : rng() % 30000;
+        const auto op = rng() % 16;
+        if (op == 0) {
+            REQUIRE(map.erase(key) == ref.erase(key));
+        } else if (op < 3) {
+            const uint64_t val = rng() % 8;
+            const auto range = ref.equal_range(key);
+            const auto it = std::find_if(range.first, range.second, [val](const auto& kv) { return kv.second == val; });
+            const size_t expect = it != range.second;
+            if (expect)
+                ref.erase(it);
+            REQUIRE(map.erase(key, val) == expect);
+        } else {
+            const uint64_t val = rng() % 8;
+            const auto it = map.emplace(key, val);
+            REQUIRE(it->first == key);
+            REQUIRE(it->second == val);
+            ref.emplace(key, val);
+        }
+        if (i % 1000 == 0)
+            check_key(map, ref, key);
+    }
+
+    check_all(map, ref);
+    for (uint64_t key = 0; key < 30000; key++)
+        check_key(map, ref, key);
+
+    const Map copy = map;
+    map.clear();
+    CHECK(map.empty());
+    CHECK(map.count(1) == 0);
+    check_all(copy, ref);
+    for (uint64_t key = 0; key < 20; key++)
+        check_key(copy, ref, key);
+}
+
+TEST_CASE("multimap runs keep their order through rehash") {
+    HashMultiMap<uint64_t, uint64_t> map(4);
+    for (uint64_t key = 0; key < 1000; key++)
+        map.emplace(key, 0);
+    std::vector<uint64_t> before;
+    for (uint64_t val = 1; val <= 50; val++)
+        map.emplace(7, val);
+    for (auto range = map.equal_range(7); range.first != range.second; ++range.first)
+        before.push_back(range.first->second);
+    REQUIRE(before.size() == 51);
+
+    map.rehash(100000);
+    CHECK(map.bucket_count() >= 100000);
+    std::vector<uint64_t> after;
+    for (auto range = map.equal_range(7); range.first != range.second; ++range.first)
+        after.push_back(range.first->second);
+    CHECK(after == before);
+    CHECK(map.size() == 1050);
+    CHECK(map.erase(7) == 51);
+    CHECK(map.size() == 999);
+    CHECK(map.equal_range(7).first == map.equal_range(7).second);
+    CHECK(map.find(7) == map.end());
+    CHECK(map.find(8) != map.end());
+}
+
+TEST_CASE("multimap with string keys, move and initializer list") {
+    HashMultiMap<std::string, std::string> map = {{"a", "1"}, {"b", "2"}, {"a", "3"}};
+    CHECK(map.size() == 3);
+    CHECK(map.count("a") == 2);
+    for (int i = 0; i < 5000; i++)
+        map.emplace("k" + std::to_string(i % 700), std::to_string(i));
+    CHECK(map.count("k5") == 8);
+    CHECK(map.erase("k5", "705") == 1);
+    CHECK(map.erase("k5", "705") == 0);
+    CHECK(map.count("k5") == 7);
+
+    auto moved = std::move(map);
+    CHECK(moved.size() == 5002);
+    CHECK(map.empty());
+    CHECK(map.erase("a") == 0);
+    map.emplace("z", "z");
+    CHECK(map.count("z") == 1);
+
+    map = moved;
+    CHECK(map.size() == 5002);
+    CHECK(map.erase("a") == 2);
+    CHECK(moved.count("a") == 2);
+}
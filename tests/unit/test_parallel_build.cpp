@@ -0,0 +1,135 @@
+// unit/test_parallel_build.cpp
+// assign_parallel() bulk construction for emhash8::HashMap/HashSet and emilib2::HashSet.
+// Covers: result equals a serial insert (duplicates, first value wins), serial fallbacks,
+//         skewed hashes that overflow a range, string keys, the table staying usable.
+#define DOCTEST_CONFIG_IMPLEMENT_WITH_MAIN
+#include "doctest.h"
+#include "common/maps.hpp"
+
+#include <cstdint>
+#include <random>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+namespace {
+
+// Every key lands in the lowest bucket range: forces the serial fallback / deferred path.
+struct SkewedHash {
+    size_t operator()(uint64_t key) const { return static_cast<size_t>(key << 20); }
+};
+
+std::vector<uint64_t> random_keys(size_t n, uint64_t range, uint64_t seed) {
+    std::mt19937_64 rng(seed);
+    std::vector<uint64_t> keys(n);
+    for (auto& key : keys)
+        key = rng() % range;
+    return keys;
+}
+
+} // namespace
+
+TEST_CASE("map8 assign_parallel matches a serial insert") {
+    const auto keys = random_keys(300000, 200000, 1);
+    std::vector<std::pair<uint64_t, uint64_t>> pairs;
+    for (size_t i = 0; i < keys.size(); i++)
+        pairs.emplace_back(keys[i], i);
+
+    std::unordered_map<uint64_t, uint64_t> ref;
+    for (const auto& kv : pairs)
+        ref.emplace(kv.first, kv.second);
+
+    for (unsigned threads : {1u, 2u, 3u, 8u}) {
+        map8<uint64_t, uint64_t> map;
+        map.emplace(1ull << 40, 7); // replaced, not merged
+        map.assign_parallel(pairs.begin(), pairs.end(), threads);
+        REQUIRE(map.size() == ref.size());
+        for (const auto& kv : ref) {
+            const auto it = map.find(kv.first);
+            REQUIRE(it != map.end());
+            REQUIRE(it->second == kv.second);
+        }
+        CHECK(!map.contains(1ull << 40));
+
+        // still an ordinary table
+        for (uint64_t key = 0; key < 1000; key++)
+            map.erase(key);
+        for (uint64_t key = 500000; key < 600000; key++)
+            map.emplace(key, key);
+        size_t expect = 100000;
+        for (const auto& kv : ref)
+            expect += kv.first >= 1000;
+        CHECK(map.size() == expect);
+        CHECK(map[599999] == 599999);
+    }
+}
+
+TEST_CASE("set8 assign_parallel with string keys and small inputs") {
+    std::vector<std::string> words;
+    for (const auto key : random_keys(100000, 60000, 2))
+        words.push_back("w" + std::to_string(key));
+    const std::unordered_set<std::string> ref(words.begin(), words.end());
+
+    set8<std::string> set;
+    set.assign_parallel(words.begin(), words.end(), 4);
+    REQUIRE(set.size() == ref.size());
+    for (const auto& word : ref)
+        REQUIRE(set.contains(word));
+    for (size_t slot = 0; slot < set.size(); slot++)
+        REQUIRE(ref.count(set.nth(static_cast<uint32_t>(slot))));
+
+    const std::vector<std::string> few = {"a", "b", "a"};
+    set.assign_parallel(few.begin(), few.end(), 4);
+    CHECK(set.size() == 2);
+    set.assign_parallel(few.begin(), few.begin(), 4);
+    CHECK(set.empty());
+}
+
+TEST_CASE("assign_parallel survives a hash that puts every key in one range") {
+    std::vector<uint64_t> keys;
+    for (uint64_t key = 0; key < 50000; key++)
+        keys.push_back(key % 40000);
+
+    emhash8::HashSet<uint64_t, SkewedHash> set8s;
+    set8s.assign_parallel(keys.begin(), keys.end(), 4);
+    CHECK(set8s.size() == 40000);
+
+    emilib2::HashSet<uint64_t, SkewedHash> iset2s;
+    iset2s.assign_parallel(keys.begin(), keys.end(), 4);
+    CHECK(iset2s.size() == 40000);
+    for (uint64_t key = 0; key < 40000; key++) {
+        REQUIRE(set8s.contains(key));
+        REQUIRE(iset2s.contains(key));
+    }
+}
+
+TEST_CASE("iset2 assign_parallel matches a serial insert") {
+    const auto keys = random_keys(400000, 250000, 3);
+    const std::unordered_set<uint64_t> ref(keys.begin(), keys.end());
+
+    for (unsigned threads : {1u, 2u, 5u, 8u}) {
+        iset2<uint64_t> set;
+        set.insert(1ull << 40);
+        set.assign_parallel(keys.begin(), keys.end(), threads);
+        REQUIRE(set.size() == ref.size());
+        for (const auto key : ref)
+            REQUIRE(set.contains(key));
+        CHECK(!set.contains(1ull << 40));
+
+        size_t visited = 0;
+        for (const auto key : set) {
+            REQUIRE(ref.count(key));
+            visited++;
+        }
+        CHECK(visited == ref.size());
+
+        for (uint64_t key = 0; key < 1000; key++)
+            set.erase(key);
+        for (uint64_t key = 300000; key < 400000; key++)
+            set.insert(key);
+        for (uint64_t key = 300000; key < 400000; key++)
+            REQUIRE(set.contains(key));
+    }
+}
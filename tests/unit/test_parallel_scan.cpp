@@ -0,0 +1,109 @@
+// unit/test_parallel_scan.cpp
+// parallel_for_each / parallel_reduce / parallel_erase_if on emhash7 and emhash8 HashMap.
+// Covers: results equal the serial loops for several thread counts, both erase_if paths
+//         (few erased, most erased), string values, small and empty tables.
+#define DOCTEST_CONFIG_IMPLEMENT_WITH_MAIN
+#include "doctest.h"
+#include "common/maps.hpp"
+
+#include <cstdint>
+#include <random>
+#include <string>
+#include <unordered_map>
+#include <utility>
+
+namespace {
+
+template <typename Map> Map random_map(size_t n, uint64_t seed) {
+    std::mt19937_64 rng(seed);
+    Map map;
+    while (map.size() < n) {
+        const auto key = rng() % (n * 4);
+        map.emplace(key, key * 3);
+    }
+    return map;
+}
+
+} // namespace
+
+TEST_CASE_TEMPLATE("parallel_for_each and parallel_reduce match a serial loop", Map, map7<uint64_t, uint64_t>,
+                   map8<uint64_t, uint64_t>) {
+    auto map = random_map<Map>(100000, 1);
+    uint64_t serial_sum = 0;
+    for (const auto& kv : map)
+        serial_sum += kv.first ^ kv.second;
+
+    for (unsigned threads : {1u, 2u, 3u, 8u}) {
+        const auto sum = static_cast<const Map&>(map).parallel_reduce(
+            uint64_t(7), [](const auto& kv) { return kv.first ^ kv.second; },
+            [](uint64_t a, uint64_t b) { return a + b; }, threads);
+        CHECK(sum == serial_sum + 7);
+
+        // a non-commutative reduce still sees every element exactly once
+        const auto count = map.parallel_reduce(
+            std::string(), [](const auto&) { return std::string("x"); },
+            [](std::string a, const std::string& b) { return a + b; }, threads);
+        CHECK(count.size() == map.size());
+    }
+
+    map.parallel_for_each([](auto& kv) { kv.second += 1; }, 4);
+    for (const auto& kv : map)
+        REQUIRE(kv.second == kv.first * 3 + 1);
+
+    Map empty;
+    CHECK(empty.parallel_reduce(5, [](const auto&) { return 1; },
+                                [](int a, int b) { return a + b; }, 4) == 5);
+}
+
+TEST_CASE_TEMPLATE("parallel_erase_if matches erase_if", Map, map7<uint64_t, std::string>,
+                   map8<uint64_t, std::string>) {
+    const auto erase_most = [](const auto& kv) { return kv.first % 10 != 0; };
+    const auto erase_few = [](const auto& kv) { return kv.first % 10 == 0; };
+
+    for (unsigned threads : {1u, 2u, 5u}) {
+        for (const bool most : {false, true}) {
+            Map map;
+            std::unordered_map<uint64_t, std::string> ref;
+            std::mt19937_64 rng(threads);
+            while (map.size() < 60000) {
+                const auto key = rng() % 200000;
+                map.emplace(key, "v" + std::to_string(key));
+                ref.emplace(key, "v" + std::to_string(key));
+            }
+
+            size_t expect = 0;
+            for (auto it = ref.begin(); it != ref.end();) {
+                if (most ? erase_most(*it) : erase_few(*it)) {
+                    it = ref.erase(it);
+                    expect++;
+                } else
+                    ++it;
+            }
+
+            const auto erased = most ? map.parallel_erase_if(erase_most, threads)
+                                     : map.parallel_erase_if(erase_few, threads);
+            REQUIRE(erased == expect);
+            REQUIRE(map.size() == ref.size());
+            for (const auto& kv : ref) {
+                const auto it = map.find(kv.first);
+                REQUIRE(it != map.end());
+                REQUIRE(it->second == kv.second);
+            }
+
+            // still an ordinary table
+            for (uint64_t key = 300000; key < 310000; key++)
+                map.emplace(key, "n");
+            CHECK(map.size() == ref.size() + 10000);
+            CHECK(map.erase(300000) == 1);
+        }
+    }
+
+    Map small;
+    small.emplace(1, "a");
+    small.emplace(2, "b");
+    CHECK(small.parallel_erase_if([](const auto& kv) { return kv.first == 1; }, 4) == 1);
+    CHECK(small.size() == 1);
+    CHECK(small.contains(2));
+    CHECK(small.parallel_erase_if([](const auto&) { return true; }, 4) == 1);
+    CHECK(small.empty());
+}